@@ -1,12 +1,23 @@
 #pragma once
 
 #include "Application.h"
-#include "Render\\OpenGLFunctions.h"
+#include "Render/OpenGLFunctions.h"
 
-#define CHECKEXTENSION( x, y, z ) x = UtilsInstance->CheckExtension( #y, z )
+#define CHECKEXTENSION( x, y ) x = WGLExtensions.Has( #y )
 #define GETFUNCTIONADDRESS( x, y ) y = (x)UtilsInstance->GetFunctionAddress( handle, #y )
 
-Application::Application(HINSTANCE i_Instance, WNDPROC WndProc) {
+// WGL loader - wglGetProcAddress only knows 1.2+ functions, 1.0 and 1.1 ones are exported by OpenGL32.dll
+static void* GetWGLFunctionAddress(const char* i_ProcedureName) {
+	void* address = (void*)wglGetProcAddress(i_ProcedureName);
+	if (!address) {
+		address = (void*)GetProcAddress(GetModuleHandle("OpenGL32.dll"), i_ProcedureName);
+	}
+	return address;
+}
+
+Application::Application(HINSTANCE i_Instance, WNDPROC WndProc, const LightingQuality i_Quality) {
+	PROFILE_FUNCTION();
+
 
 	ApplicationInstance = i_Instance;
 
@@ -39,28 +50,31 @@ Application::Application(HINSTANCE i_Instance, WNDPROC WndProc) {
 		Result = false;
 	}
 
-	// Create window
-	if (!CreateApplicationWindow(i_Instance, AppName, window_handle)) {
+	StartupTimer.Mark("Window class");
+
+	// WGL extension functions are needed to create core context
+	if (!LoadWGLExtensions(i_Instance)) {
 		Result = false;
 	}
-	// Create OpenGL context using old, Windows functions
-	if (!CreateOpenGLContext(true, window_handle, device_context, rendering_context)) {
+	StartupTimer.Mark("WGL extensions");
+
+	// Create the only application window
+	if (!CreateApplicationWindow(i_Instance, AppName, window_handle)) {
 		Result = false;
 	}
+	StartupTimer.Mark("Window");
 
-	// Destroy OpenGL context created with old functions
-	DestroyOpenGLContext(window_handle, device_context, rendering_context);
-	// Destroy window - pixel format for window can be set only once so new window need to be created
-	DestroyApplicationWindow(window_handle);
-
-	// Create window again
-	if (!CreateApplicationWindow(i_Instance, AppName, window_handle)) {
+	// Create final OpenGL context directly, using more flexible functions (if available)
+	if (!CreateOpenGLContext(window_handle, device_context, rendering_context)) {
 		Result = false;
 	}
-	// Create OpenGL context this time using more flexible functions (if available)
-	if (!CreateOpenGLContext(false, window_handle, device_context, rendering_context)) {
+	StartupTimer.Mark("Context");
+
+	// Get addresses of OpenGL's functions beyond version 1.1 from final context
+	if (!LoadOpenGLCoreFunctions(GetWGLFunctionAddress)) {
 		Result = false;
 	}
+	StartupTimer.Mark("Functions");
 
 	ShowWindow(window_handle, SW_SHOW);
 	UpdateWindow(window_handle);
@@ -74,7 +88,12 @@ Application::Application(HINSTANCE i_Instance, WNDPROC WndProc) {
 		UtilsInstance->ErrorMessage("Application Creation Error", "Could not create application.", true);
 	}
 
-	Render.reset(new RenderClass(&GDeviceContext, &GWidth, &GHeight));
+	Render.reset(new RenderClass(&GWidth, &GHeight, 0, i_Quality));
+	// Present initial frame rendered by constructor
+	SwapBuffers(GDeviceContext);
+	StartupTimer.Mark("Render setup");
+
+	StartupTimer.Report("Startup");
 
 };
 
@@ -115,13 +134,42 @@ void Application::Run() {
 		else {
 			isActive = true;
 			Render->Render();
+			// Swap back and front buffers (SwapChain)
+			SwapBuffers(GDeviceContext);
 		}
 	}
 	isActive = false;
 }
 
+// Render scripted benchmark timeline, messages are still processed so the window stays responsive
+bool Application::RunBenchmark(const int i_Frames, const char* i_ReportPath, const BenchmarkTimeline i_Timeline) {
+	Benchmark benchmark(i_Frames, i_ReportPath, i_Timeline);
+	// Measured frames draw the whole scene, loading is not part of the timeline
+	Render->FinishSceneLoading();
+
+	MSG		message;
+	const int total = benchmark.TotalFrames();
+	for (int i = 0; i < total; ++i) {
+		while (PeekMessage(&message, nullptr, 0, 0, PM_REMOVE)) {
+			if (message.message == WM_QUIT) {
+				return false;
+			}
+			TranslateMessage(&message);
+			DispatchMessage(&message);
+		}
+
+		benchmark.BeginFrame(*Render, i);
+		Render->Render();
+		SwapBuffers(GDeviceContext);
+		benchmark.EndFrame(*Render);
+	}
+
+	return benchmark.WriteReport(GWidth, GHeight);
+}
+
 void Application::ForceRenderUpdate() {
 	Render->Render();
+	SwapBuffers(GDeviceContext);
 }
 
 void Application::WindowResize(const int i_Width, const int i_Height) {
@@ -179,7 +227,47 @@ void Application::DestroyApplicationWindow(HWND& io_WindowHandle) {
 	}
 }
 
-bool Application::CreateOpenGLContext(const bool i_FirstCreation, const HWND i_WindowHandle, HDC& o_DeviceContext, HGLRC& o_RenderingContext) {
+// Dummy window with legacy context is the only way to reach WGL extension functions
+// Nothing else is loaded through it and both are destroyed right away, pixel format of a window can be set only once
+bool Application::LoadWGLExtensions(const HINSTANCE i_ApplicationInstance) {
+	PROFILE_FUNCTION();
+	HWND window_handle = CreateWindowEx(0, AppName, AppName, WS_POPUP, 0, 0, 1, 1, nullptr, nullptr, i_ApplicationInstance, nullptr);
+	if (!window_handle) {
+		UtilsInstance->ErrorMessage("OpenGL Creation Error", "Could not create dummy window.");
+		return false;
+	}
+
+	HDC device_context = GetDC(window_handle);
+	HGLRC rendering_context = 0;
+
+	bool result = device_context && SetUpBasePixelFormat(device_context) && CreateBaseContext(device_context, rendering_context);
+	if (result) {
+		// Get the handle of the OpenGL library from which functions will be loaded
+		HMODULE handle = GetModuleHandle("OpenGL32.dll");
+
+		result = GETFUNCTIONADDRESS(PFNWGLGETEXTENSIONSSTRINGARBPROC, wglGetExtensionsStringARB) != nullptr;
+		if (result) {
+			// Get all extensions supported on this computer
+			WGLExtensions.Parse(wglGetExtensionsStringARB(device_context));
+
+			result = CHECKEXTENSION(ARB_extensions_string_present, WGL_ARB_extensions_string);
+			if (CHECKEXTENSION(ARB_pixel_format_present, WGL_ARB_pixel_format)) {
+				GETFUNCTIONADDRESS(PFNWGLCHOOSEPIXELFORMATARBPROC, wglChoosePixelFormatARB);
+			}
+			if (CHECKEXTENSION(ARB_create_context_present, WGL_ARB_create_context)) {
+				GETFUNCTIONADDRESS(PFNWGLCREATECONTEXTATTRIBSARBPROC, wglCreateContextAttribsARB);
+			}
+			CHECKEXTENSION(ARB_create_context_profile_present, WGL_ARB_create_context_profile);
+		}
+	}
+
+	DestroyOpenGLContext(window_handle, device_context, rendering_context);
+	DestroyApplicationWindow(window_handle);
+	return result;
+}
+
+bool Application::CreateOpenGLContext(const HWND i_WindowHandle, HDC& o_DeviceContext, HGLRC& o_RenderingContext) {
+	PROFILE_FUNCTION();
 	// Get context of a device associated with created window
 	HDC device_context = GetDC(i_WindowHandle);
 	if (!device_context) {
@@ -187,57 +275,31 @@ bool Application::CreateOpenGLContext(const bool i_FirstCreation, const HWND i_W
 		return false;
 	}
 
-	HGLRC rendering_context;
-
-	// Create OpenGL's rendering context
-	if (i_FirstCreation) {
+	HGLRC rendering_context = 0;
 
-		// Set the description of drawing buffers
-		if (!SetUpBasePixelFormat(device_context)) {
+	// Check if new methods for setting pixel format are available
+	if (ARB_pixel_format_present) {
+		// Set pixel format with new methods
+		if (!SetUpExtendedPixelFormat(device_context)) {
 			return false;
 		}
-		// Create rendering context
-		if (!CreateBaseContext(device_context, rendering_context)) {
+	}
+	else {
+		// Set pixel format with old methods
+		if (!SetUpBasePixelFormat(device_context)) {
 			return false;
 		}
-		// Check OpenGL's extensions and get addresses of OpenGL's functions beyond version 1.1
-		if (!LoadOpenGLFunctions(device_context)) {
+	}
+	// Check if new methods for creating rendering context are available
+	if (ARB_create_context_present) {
+		// Create context with new methods
+		if (!CreateExtendedContext(device_context, rendering_context)) {
 			return false;
 		}
-
-		o_RenderingContext = rendering_context;
 	}
 	else {
-
-		// Check if new methods for setting pixel format are available
-		if (ARB_pixel_format_present) {
-			// Set pixel format with new methods
-			if (!SetUpExtendedPixelFormat(device_context)) {
-				return false;
-			}
-		}
-		else {
-			// Set pixel format with old methods
-			if (!SetUpBasePixelFormat(device_context)) {
-				return false;
-			}
-		}
-		// Check if new methods for creating rendering context are available
-		if (ARB_create_context_present) {
-			// Create context with new methods
-			if (!CreateExtendedContext(device_context, rendering_context)) {
-				return false;
-			}
-		}
-		else {
-			// Create context the old way
-			if (!CreateBaseContext(device_context, rendering_context)) {
-				return false;
-			}
-		}
-		// Check OpenGL's extensions and get addresses of OpenGL's functions beyond version 1.1
-		// Newly created rendering context may have different addresses of the same functions!
-		if (!LoadOpenGLFunctions(device_context)) {
+		// Create context the old way
+		if (!CreateBaseContext(device_context, rendering_context)) {
 			return false;
 		}
 	}
@@ -339,215 +401,6 @@ bool Application::CreateExtendedContext(const HDC i_DeviceContext, HGLRC& o_Rend
 	return true;
 }
 
-bool Application::LoadOpenGLFunctions(const HDC i_DeviceContext) {
-	// Get the handle of the OpenGL library from which functions will be loaded
-	HMODULE handle = GetModuleHandle("OpenGL32.dll");
-
-	if (!(GETFUNCTIONADDRESS(PFNWGLGETEXTENSIONSSTRINGARBPROC, wglGetExtensionsStringARB))) {
-		return false;
-	}
-
-	// Get all extensions supported on this computer
-	const char* wglExtensions = wglGetExtensionsStringARB(i_DeviceContext);
-
-	if (!(CHECKEXTENSION(ARB_extensions_string_present, WGL_ARB_extensions_string, wglExtensions))) {
-		return false;
-	}
-	if (CHECKEXTENSION(ARB_pixel_format_present, WGL_ARB_pixel_format, wglExtensions)) {
-		GETFUNCTIONADDRESS(PFNWGLCHOOSEPIXELFORMATARBPROC, wglChoosePixelFormatARB);
-	}
-	if (CHECKEXTENSION(ARB_create_context_present, WGL_ARB_create_context, wglExtensions)) {
-		GETFUNCTIONADDRESS(PFNWGLCREATECONTEXTATTRIBSARBPROC, wglCreateContextAttribsARB);
-	}
-
-	CHECKEXTENSION(ARB_create_context_profile_present, WGL_ARB_create_context_profile, wglExtensions);
-
-	if (!(GETFUNCTIONADDRESS(PFNGLGETINTEGERVPROC, glGetIntegerv))) {
-		return false;
-	}
-
-	int MajorVersion, MinorVersion;
-	glGetIntegerv(GL_MAJOR_VERSION, &MajorVersion);
-	glGetIntegerv(GL_MINOR_VERSION, &MinorVersion);
-
-	// Application is designed for 3.0+ OGL version and forward compatible mode
-	// so if version is earlier than 3.0 there is no need to get entry points for other functions
-	if (MajorVersion < 3) {
-		return true;
-	}
-
-	// Acquire addresses of all core OpenGL functions
-	if (!(GETFUNCTIONADDRESS(PFNGLGETSTRINGPROC, glGetString)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLGETSTRINGIPROC, glGetStringi)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLGETERRORPROC, glGetError)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLCLEARCOLORPROC, glClearColor)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLCLEARPROC, glClear)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLVIEWPORTPROC, glViewport)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLCLEARDEPTHPROC, glClearDepth)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLDEPTHFUNCPROC, glDepthFunc)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLDEPTHMASKPROC, glDepthMask)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLBLENDFUNCPROC, glBlendFunc)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLENABLEPROC, glEnable)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLDISABLEPROC, glDisable)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLFRONTFACEPROC, glFrontFace)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLCULLFACEPROC, glCullFace)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLPOLYGONMODEPROC, glPolygonMode)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLSAMPLECOVERAGEPROC, glSampleCoverage)))
-		return false;
-
-	// Shaders
-	if (!(GETFUNCTIONADDRESS(PFNGLCREATESHADERPROC, glCreateShader)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLSHADERSOURCEPROC, glShaderSource)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLCOMPILESHADERPROC, glCompileShader)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLGETSHADERIVPROC, glGetShaderiv)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLGETSHADERINFOLOGPROC, glGetShaderInfoLog)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLDELETESHADERPROC, glDeleteShader)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLCREATEPROGRAMPROC, glCreateProgram)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLATTACHSHADERPROC, glAttachShader)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLLINKPROGRAMPROC, glLinkProgram)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLGETPROGRAMIVPROC, glGetProgramiv)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLGETPROGRAMINFOLOGPROC, glGetProgramInfoLog)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLUSEPROGRAMPROC, glUseProgram)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLDETACHSHADERPROC, glDetachShader)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLDELETEPROGRAMPROC, glDeleteProgram)))
-		return false;
-
-	// Vertex arrays
-	if (!(GETFUNCTIONADDRESS(PFNGLGENVERTEXARRAYSPROC, glGenVertexArrays)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLBINDVERTEXARRAYPROC, glBindVertexArray)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLDELETEVERTEXARRAYSPROC, glDeleteVertexArrays)))
-		return false;
-
-	// Buffers
-	if (!(GETFUNCTIONADDRESS(PFNGLGENBUFFERSPROC, glGenBuffers)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLBINDBUFFERPROC, glBindBuffer)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLBUFFERDATAPROC, glBufferData)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLBUFFERSUBDATAPROC, glBufferSubData)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLDELETEBUFFERSPROC, glDeleteBuffers)))
-		return false;
-
-	// Framebuffers
-	if (!(GETFUNCTIONADDRESS(PFNGLGENFRAMEBUFFERSPROC, glGenFramebuffers)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLBINDFRAMEBUFFERPROC, glBindFramebuffer)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLFRAMEBUFFERTEXTURE2DPROC, glFramebufferTexture2D)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLCHECKFRAMEBUFFERSTATUSPROC, glCheckFramebufferStatus)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLDRAWBUFFERPROC, glDrawBuffer)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLDRAWBUFFERSPROC, glDrawBuffers)))
-		return false;
-
-
-	// Vertex attribs
-	if (!(GETFUNCTIONADDRESS(PFNGLVERTEXATTRIBPOINTERPROC, glVertexAttribPointer)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLBINDATTRIBLOCATIONPROC, glBindAttribLocation)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLBINDFRAGDATALOCATIONPROC, glBindFragDataLocation)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLGETATTRIBLOCATIONPROC, glGetAttribLocation)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLGETACTIVEATTRIBPROC, glGetActiveAttrib)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLENABLEVERTEXATTRIBARRAYPROC, glEnableVertexAttribArray)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLDISABLEVERTEXATTRIBARRAYPROC, glDisableVertexAttribArray)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLGETVERTEXATTRIBIVPROC, glGetVertexAttribiv)))
-		return false;
-
-	// Textures
-	if (!(GETFUNCTIONADDRESS(PFNGLGENTEXTURESPROC, glGenTextures)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLDELETETEXTURESPROC, glDeleteTextures)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLBINDTEXTUREPROC, glBindTexture)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLACTIVETEXTUREPROC, glActiveTexture)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLTEXPARAMETERIPROC, glTexParameteri)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLTEXIMAGE2DPROC, glTexImage2D)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLGENERATEMIPMAPPROC, glGenerateMipmap)))
-		return false;
-
-	// Uniform paramters
-	if (!(GETFUNCTIONADDRESS(PFNGLGETACTIVEUNIFORMPROC, glGetActiveUniform)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLGETUNIFORMLOCATIONPROC, glGetUniformLocation)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLUNIFORM1FVPROC, glUniform1fv)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLUNIFORM2FVPROC, glUniform2fv)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLUNIFORM3FVPROC, glUniform3fv)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLUNIFORM4FVPROC, glUniform4fv)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLUNIFORM1IVPROC, glUniform1iv)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLUNIFORM2IVPROC, glUniform2iv)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLUNIFORM3IVPROC, glUniform3iv)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLUNIFORM4IVPROC, glUniform4iv)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLUNIFORM1IPROC, glUniform1i)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLUNIFORMMATRIX3FVPROC, glUniformMatrix3fv)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLUNIFORMMATRIX4FVPROC, glUniformMatrix4fv)))
-		return false;
-
-	// Drawing
-	if (!(GETFUNCTIONADDRESS(PFNGLDRAWARRAYSPROC, glDrawArrays)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLDRAWELEMENTSPROC, glDrawElements)))
-		return false;
-	if (!(GETFUNCTIONADDRESS(PFNGLGETERRORPROC, glGetError)))
-		return false;
-
-	return true;
-}
-
 bool Application::SetUpBasePixelFormat(const HDC i_DeviceContext) {
 	// Fill the structure describing our desired format of drawing buffers
 	PIXELFORMATDESCRIPTOR pfd = {
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <Windows.h>
-#include <GL\glcorearb.h>
-#include "Render\\Render.h"
-#include "Utils\\Utils.h"
+#include <GL/glcorearb.h>
+#include "Render/Render.h"
+#include "Benchmark.h"
+#include "Utils/Utils.h"
+#include "Utils/ExtensionSet.h"
+#include "Utils/PhaseTimer.h"
 
 // Application predifinitions
 #define ApplicationName "Some simple render"
@@ -32,32 +35,35 @@ private:
 
 	const char*     AppName = ApplicationName;
 
+	PhaseTimer      StartupTimer;                           // Durations of startup phases
+
 	// OpenGL extensions
-	bool            ARB_extensions_string_present;          // Extension indicating that all extensions can be check
-	bool            ARB_pixel_format_present;               // Extension that allows setting pixel format with more flexible functions
-	bool            ARB_create_context_present;             // Extension that allows creating rendering context with more flexible functions
-	bool            ARB_create_context_profile_present;     // Extension that allows creating core rendering context
+	ExtensionSet    WGLExtensions;                          // WGL extensions, hashed once
+	bool            ARB_extensions_string_present = false;  // Extension indicating that all extensions can be check
+	bool            ARB_pixel_format_present = false;       // Extension that allows setting pixel format with more flexible functions
+	bool            ARB_create_context_present = false;     // Extension that allows creating rendering context with more flexible functions
+	bool            ARB_create_context_profile_present = false; // Extension that allows creating core rendering context
 
 
 public:
-	Application(HINSTANCE i_Instance, WNDPROC WndProc);
+	Application(HINSTANCE i_Instance, WNDPROC WndProc, const LightingQuality i_Quality = DefaultLightingQuality);
 
 	~Application();
 
 	void Run();
+	bool RunBenchmark(const int i_Frames, const char* i_ReportPath, const BenchmarkTimeline i_Timeline = BenchmarkTimelineOrbit);
 	void WindowResize(const int i_Width, const int i_Height);
 	void ForceRenderUpdate();
 
 	static bool CreateApplicationWindow(const HINSTANCE i_ApplicationInstance, const char* i_ApplicationClassName, HWND& o_WindowHandle);
 	static void Application::DestroyApplicationWindow(HWND& io_WindowHandle);
 
-	bool CreateOpenGLContext(const bool i_FirstCreation, const HWND i_WindowHandle, HDC& o_DeviceContext, HGLRC& o_RenderingContext);
+	bool LoadWGLExtensions(const HINSTANCE i_ApplicationInstance);
+	bool CreateOpenGLContext(const HWND i_WindowHandle, HDC& o_DeviceContext, HGLRC& o_RenderingContext);
 	bool CreateBaseContext(const HDC i_DeviceContext, HGLRC& o_RenderingContext);
 	bool Application::CreateExtendedContext(const HDC i_DeviceContext, HGLRC& o_RenderingContext);
 	void Application::DestroyOpenGLContext(const HWND i_WindowHandle, HDC& io_DeviceContext, HGLRC& io_RenderingContext);
 
-	bool Application::LoadOpenGLFunctions(const HDC i_DeviceContext);
-
 	static bool Application::SetUpBasePixelFormat(const HDC i_DeviceContext);
 	static bool SetUpExtendedPixelFormat(const HDC i_DeviceContext);
 
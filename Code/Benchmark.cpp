@@ -0,0 +1,212 @@
+#include "Benchmark.h"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <iostream>
+#include "Utils/Utils.h"
+
+// Metric names used in reports
+static const char* GPUPassNames[GPUPassCount] = { "gpu_base_pass_ms", "gpu_lighting_pass_ms" };
+static const char* GPUStatisticNames[GPUPassCount][GPUStatisticCount] = {
+	{ "base_pass_vertices", "base_pass_primitives", "base_pass_fragments" },
+	{ "lighting_pass_vertices", "lighting_pass_primitives", "lighting_pass_fragments" },
+};
+static const char* FilterBasePassNames[MaterialFilterCount] = { "gpu_base_pass_ms_base_level", "gpu_base_pass_ms_trilinear", "gpu_base_pass_ms_anisotropic" };
+static const char* TimelineNames[BenchmarkTimelineCount] = { "orbit", "textures" };
+
+// Driver strings are copied into the report, quotes, backslashes and control characters would break the JSON
+static std::string EscapeJson(const char* i_Text) {
+	static const char* hex = "0123456789abcdef";
+	std::string escaped;
+	for (const char* c = i_Text; *c; ++c) {
+		const unsigned char character = (unsigned char)*c;
+		if (character == '"' || character == '\\') {
+			escaped += '\\';
+			escaped += (char)character;
+		}
+		else if (character < 0x20) {
+			escaped += "\\u00";
+			escaped += hex[character >> 4];
+			escaped += hex[character & 0xF];
+		}
+		else {
+			escaped += (char)character;
+		}
+	}
+	return escaped;
+}
+
+bool BenchmarkTimelineFromName(const char* i_Name, BenchmarkTimeline& o_Timeline) {
+	for (int i = 0; i < BenchmarkTimelineCount; ++i) {
+		if (strcmp(i_Name, TimelineNames[i]) == 0) {
+			o_Timeline = (BenchmarkTimeline)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+Benchmark::Benchmark(const int i_Frames, const char* i_ReportPath, const BenchmarkTimeline i_Timeline) {
+	Frames = i_Frames > 0 ? i_Frames : 1;
+	ReportPath = i_ReportPath ? i_ReportPath : "";
+	Timeline = i_Timeline;
+}
+
+void Benchmark::BeginFrame(RenderClass& io_Render, const int i_Frame) {
+	CurrentFrame = i_Frame;
+
+	if (Timeline == BenchmarkTimelineTextures) {
+		// Measured frames are split evenly between material filters, each of them replays the same path from its start
+		const int measured = i_Frame - BenchmarkWarmupFrames;
+		const int phase = measured < 0 ? 0 : measured * MaterialFilterCount / Frames;
+		const float t = measured < 0 ? 0.0f : fmodf((float)measured * MaterialFilterCount / (float)Frames, 1.0f);
+
+		// Filter switches wait for the first measured frame, so late results of warmup frames are not counted
+		if ((phase != FilterPhase || measured == 0) && io_Render.SetMaterialFilter((MaterialFilter)phase)) {
+			FilterPhase = phase;
+			FilterFirstGPUFrame[phase] = io_Render.GetPassTimer().NextFrame();
+		}
+
+		// Camera backs away over the plane and returns while the model makes one turn
+		const float camera[3] = { 0.0f, BenchmarkTextureCameraHeight, BenchmarkTextureCameraTravel * 0.5f * (1.0f - cosf(2.0f * 3.14159265f * t)) };
+		io_Render.SetCamera(camera, BenchmarkTexturePitch);
+		io_Render.SetAnimation(360.0f * t, BenchmarkLightDistance);
+
+		FrameStart = Clock::now();
+		return;
+	}
+
+	// One full turn of the model and two light sweeps over the whole run
+	const float t = (float)i_Frame / (float)TotalFrames();
+	const float angle = 360.0f * t;
+	const float light_distance = BenchmarkLightDistance + BenchmarkLightDistance * sinf(4.0f * 3.14159265f * t);
+	io_Render.SetAnimation(angle, light_distance);
+
+	FrameStart = Clock::now();
+}
+
+void Benchmark::EndFrame(const RenderClass& i_Render) {
+	const double frame_time = std::chrono::duration<double, std::milli>(Clock::now() - FrameStart).count();
+	if (CurrentFrame < BenchmarkWarmupFrames) {
+		return;
+	}
+
+	CPUFrameTime.Add(frame_time);
+
+	const GPUPassTimer& timer = i_Render.GetPassTimer();
+	const GPUFrameStats& gpu = timer.LatestResults();
+	if (timer.HasResults() && (!GPUResultsSeen || gpu.Frame != LastGPUFrame)) {
+		GPUResultsSeen = true;
+		LastGPUFrame = gpu.Frame;
+
+		GPUFrameTime.Add(gpu.FrameMilliseconds);
+
+		// Results arrive late, the filter is the one that was set when their frame was drawn
+		int filter = FilterPhase;
+		while (filter >= 0 && gpu.Frame < FilterFirstGPUFrame[filter]) {
+			--filter;
+		}
+		if (filter >= 0) {
+			FilterBasePassTime[filter].Add(gpu.PassMilliseconds[GPUPassBase]);
+		}
+		for (int pass = 0; pass < GPUPassCount; ++pass) {
+			GPUPassTime[pass].Add(gpu.PassMilliseconds[pass]);
+			if (timer.HasStatistics()) {
+				for (int statistic = 0; statistic < GPUStatisticCount; ++statistic) {
+					GPUStatistics[pass][statistic].Add((double)gpu.Statistics[pass][statistic]);
+				}
+			}
+		}
+	}
+
+	const DrawStats& draws = i_Render.GetDrawStats();
+	DrawCalls.Add((double)draws.DrawCalls);
+	Triangles.Add((double)draws.Triangles);
+	if (draws.ClustersTested > 0) {
+		ClusterRejection.Add(100.0 * draws.ClustersCulled / draws.ClustersTested);
+	}
+#if defined(ALLOCATION_COUNTING)
+	HeapAllocations.Add((double)draws.HeapAllocations);
+#endif
+}
+
+bool Benchmark::WriteReport(const float i_Width, const float i_Height) const {
+	const char* renderer = (const char*)glGetString(GL_RENDERER);
+
+	std::vector<const char*> names = { "cpu_frame_ms", "gpu_frame_ms", GPUPassNames[GPUPassBase], GPUPassNames[GPUPassLighting], "draw_calls", "triangles" };
+	std::vector<const LogHistogram*> metrics = { &CPUFrameTime, &GPUFrameTime, &GPUPassTime[GPUPassBase], &GPUPassTime[GPUPassLighting], &DrawCalls, &Triangles };
+
+	// Scenes without meshlets have no rejection rate
+	if (ClusterRejection.Count() > 0) {
+		names.push_back("cluster_rejection_pct");
+		metrics.push_back(&ClusterRejection);
+	}
+	if (HeapAllocations.Count() > 0) {
+		names.push_back("heap_allocations");
+		metrics.push_back(&HeapAllocations);
+	}
+	// Texture timeline, base pass time of every material filter over the same path
+	for (int filter = 0; filter < MaterialFilterCount; ++filter) {
+		if (FilterBasePassTime[filter].Count() > 0) {
+			names.push_back(FilterBasePassNames[filter]);
+			metrics.push_back(&FilterBasePassTime[filter]);
+		}
+	}
+
+	// Pipeline statistics are only reported when the driver provided them
+	for (int pass = 0; pass < GPUPassCount; ++pass) {
+		for (int statistic = 0; statistic < GPUStatisticCount; ++statistic) {
+			if (GPUStatistics[pass][statistic].Count() > 0) {
+				names.push_back(GPUStatisticNames[pass][statistic]);
+				metrics.push_back(&GPUStatistics[pass][statistic]);
+			}
+		}
+	}
+	const int count = (int)metrics.size();
+
+	std::cout << "Benchmark: " << Frames << " frames at " << i_Width << "x" << i_Height << ", " << TimelineNames[Timeline] << " timeline" << std::endl;
+	for (int i = 0; i < count; ++i) {
+		std::cout << "  " << names[i] << ": mean " << metrics[i]->Mean() << ", p50 " << metrics[i]->Percentile(50)
+			<< ", p95 " << metrics[i]->Percentile(95) << ", p99 " << metrics[i]->Percentile(99) << ", max " << metrics[i]->Max() << std::endl;
+	}
+
+	if (ReportPath.empty()) {
+		return true;
+	}
+
+	std::ofstream report(ReportPath.c_str());
+	if (!report) {
+		UtilsInstance->ErrorMessage("Benchmark Report Error", ReportPath.c_str());
+		return false;
+	}
+
+	const bool csv = ReportPath.size() >= 4 && ReportPath.compare(ReportPath.size() - 4, 4, ".csv") == 0;
+	if (csv) {
+		report << "metric,samples,mean,p50,p95,p99,max" << std::endl;
+		for (int i = 0; i < count; ++i) {
+			report << names[i] << "," << metrics[i]->Count() << "," << metrics[i]->Mean() << "," << metrics[i]->Percentile(50) << ","
+				<< metrics[i]->Percentile(95) << "," << metrics[i]->Percentile(99) << "," << metrics[i]->Max() << std::endl;
+		}
+	}
+	else {
+		report << "{" << std::endl;
+		report << "  \"frames\": " << Frames << "," << std::endl;
+		report << "  \"warmup_frames\": " << BenchmarkWarmupFrames << "," << std::endl;
+		report << "  \"timeline\": \"" << TimelineNames[Timeline] << "\"," << std::endl;
+		report << "  \"width\": " << i_Width << "," << std::endl;
+		report << "  \"height\": " << i_Height << "," << std::endl;
+		report << "  \"renderer\": \"" << EscapeJson(renderer ? renderer : "") << "\"," << std::endl;
+		report << "  \"metrics\": {" << std::endl;
+		for (int i = 0; i < count; ++i) {
+			report << "    \"" << names[i] << "\": { \"samples\": " << metrics[i]->Count() << ", \"mean\": " << metrics[i]->Mean()
+				<< ", \"p50\": " << metrics[i]->Percentile(50) << ", \"p95\": " << metrics[i]->Percentile(95)
+				<< ", \"p99\": " << metrics[i]->Percentile(99) << ", \"max\": " << metrics[i]->Max() << " }"
+				<< (i + 1 < count ? "," : "") << std::endl;
+		}
+		report << "  }" << std::endl;
+		report << "}" << std::endl;
+	}
+	return true;
+}
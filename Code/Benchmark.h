@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include "Render/Render.h"
+#include "Utils/Histogram.h"
+
+// Benchmark predifinitions
+#define BenchmarkWarmupFrames 10                            // Frames rendered before measuring, drivers compile and upload lazily
+#define BenchmarkLightDistance 2.07f                        // Middle of light distance range used by the timeline
+#define BenchmarkTextureCameraHeight -1.6f                  // Texture timeline camera, just above the plane (at -2) so it is seen at grazing angles
+#define BenchmarkTextureCameraTravel 2.0f                   // Texture timeline camera moves this far back and forth along Z
+#define BenchmarkTexturePitch -6.0f                         // Degrees, texture timeline camera looks slightly down along the plane
+
+// Scripted paths
+enum BenchmarkTimeline {
+	BenchmarkTimelineOrbit = 0,                             // Model turns in front of the fixed camera
+	BenchmarkTimelineTextures,                              // Low camera over the textured plane, replayed once per material filter
+	BenchmarkTimelineCount
+};
+
+bool BenchmarkTimelineFromName(const char* i_Name, BenchmarkTimeline& o_Timeline);
+
+// Renders fixed number of frames along a scripted timeline and collects frame statistics
+// Same number of frames always gives the same camera and light path, so runs can be compared
+class Benchmark {
+
+public:
+	Benchmark(const int i_Frames, const char* i_ReportPath, const BenchmarkTimeline i_Timeline = BenchmarkTimelineOrbit);
+
+	// Total number of frames to render including warmup
+	int TotalFrames() const { return Frames + BenchmarkWarmupFrames; }
+
+	// Set scripted animation state of given frame and start measuring it
+	void BeginFrame(RenderClass& io_Render, const int i_Frame);
+
+	// Stop measuring frame, call after frame was submitted (and presented)
+	void EndFrame(const RenderClass& i_Render);
+
+	// Write report as JSON or CSV depending on file extension, print summary to console
+	bool WriteReport(const float i_Width, const float i_Height) const;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	int             Frames;                                 // Number of measured frames
+	std::string     ReportPath;                             // Output file, .json or .csv
+	BenchmarkTimeline Timeline;
+	int             CurrentFrame = 0;
+	Clock::time_point FrameStart;
+
+	LogHistogram    CPUFrameTime;                           // Milliseconds from BeginFrame to EndFrame
+	LogHistogram    GPUFrameTime;                           // Milliseconds from first to last pass on GPU
+	LogHistogram    GPUPassTime[GPUPassCount];              // Milliseconds per render pass, a few frames late
+	LogHistogram    GPUStatistics[GPUPassCount][GPUStatisticCount]; // Pipeline statistics per pass, when supported
+	bool            GPUResultsSeen = false;
+	uint64_t        LastGPUFrame = 0;                       // GPU results arrive late and not every frame, each one is added once
+	int             FilterPhase = -1;                       // Material filter of the texture timeline, measured frames are split evenly between filters
+	uint64_t        FilterFirstGPUFrame[MaterialFilterCount] = {}; // First GPU timer frame drawn with each filter, late results are matched to it
+	LogHistogram    FilterBasePassTime[MaterialFilterCount]; // Milliseconds of base pass per material filter, texture timeline only
+	LogHistogram    DrawCalls;
+	LogHistogram    Triangles;
+	LogHistogram    ClusterRejection;                       // Percent of tested meshlets culled, frames that tested any
+	LogHistogram    HeapAllocations;                        // Render thread allocations per frame, builds with allocation counting
+};
@@ -1,10 +1,22 @@
 #pragma once
+#ifdef _WIN32
 #include <WinUser.h>
+#else
+// WinApi virtual key codes, keys only arrive through window messages but the values keep the definitions portable
+#define VK_LEFT 0x25
+#define VK_UP 0x26
+#define VK_RIGHT 0x27
+#define VK_DOWN 0x28
+#define VK_ESCAPE 0x1B
+#endif
 
-const struct ButtonsDefinitions {
+struct ButtonsDefinitions {
 	const static int ChangeMeshesRotationL = VK_LEFT;
 	const static int ChangeMeshesRotationR = VK_RIGHT;
 	const static int ChangeLightPositionL = VK_UP;
 	const static int ChangeLightPositionR = VK_DOWN;
+	const static int DumpStatsButton = 'P';                     // Letter keys use their uppercase ASCII code
+	const static int ChangeLightingQuality = 'Q';               // Cycle low, medium and high lighting permutations
+	const static int ToggleIndirectDraws = 'I';                 // Switch model draws between multi draw indirect and one call per packet
 	const static int QuitButton = VK_ESCAPE;
-};
\ No newline at end of file
+};
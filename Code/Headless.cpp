@@ -0,0 +1,251 @@
+#include "Headless.h"
+
+// Context versions tried from the newest one, shaders need at least 3.1
+static const int ContextVersions[][2] = { {4, 3}, {4, 2}, {4, 1}, {4, 0}, {3, 3}, {3, 2}, {3, 1} };
+
+#if defined(HEADLESS_OSMESA)
+static void* GetOSMesaFunctionAddress(const char* i_ProcedureName) {
+	return (void*)OSMesaGetProcAddress(i_ProcedureName);
+}
+#else
+static void* GetEGLFunctionAddress(const char* i_ProcedureName) {
+	return (void*)eglGetProcAddress(i_ProcedureName);
+}
+#endif
+
+HeadlessApplication::HeadlessApplication(const int i_Width, const int i_Height, const LightingQuality i_Quality) {
+	PROFILE_FUNCTION();
+
+	GWidth = (float)(i_Width > 0 ? i_Width : 1);
+	GHeight = (float)(i_Height > 0 ? i_Height : 1);
+
+	// Final core context is created directly, no temporary context is needed
+	if (!CreateOpenGLContext()) {
+		UtilsInstance->ErrorMessage("Application Creation Error", "Could not create headless OpenGL context.", true);
+	}
+	StartupTimer.Mark("Context");
+
+#if defined(HEADLESS_OSMESA)
+	const bool functions_loaded = LoadOpenGLCoreFunctions(GetOSMesaFunctionAddress);
+#else
+	const bool functions_loaded = LoadOpenGLCoreFunctions(GetEGLFunctionAddress);
+#endif
+	if (!functions_loaded) {
+		UtilsInstance->ErrorMessage("Application Creation Error", "Could not load OpenGL functions.", true);
+	}
+	StartupTimer.Mark("Functions");
+
+	// Lighting pass output goes to offscreen framebuffer instead of window back buffer
+	CreateOutputFramebuffer();
+
+	Render.reset(new RenderClass(&GWidth, &GHeight, OutputFramebuffer, i_Quality));
+	StartupTimer.Mark("Render setup");
+
+	StartupTimer.Report("Startup");
+}
+
+HeadlessApplication::~HeadlessApplication() {
+
+	// Render objects have to be released while context is still current
+	Render.reset();
+
+	glDeleteFramebuffers(1, &OutputFramebuffer);
+	glDeleteTextures(1, &OutputTexture);
+
+	DestroyOpenGLContext();
+}
+
+void HeadlessApplication::Run(const int i_Frames) {
+	// Output frames show the whole scene, not the part streamed in so far
+	Render->FinishSceneLoading();
+	for (int i = 0; i < i_Frames; ++i) {
+		Render->Render();
+	}
+
+	// Nothing presents frames so make sure all of them are actually drawn
+	glFinish();
+}
+
+bool HeadlessApplication::RunBenchmark(const int i_Frames, const char* i_ReportPath, const BenchmarkTimeline i_Timeline) {
+	Benchmark benchmark(i_Frames, i_ReportPath, i_Timeline);
+	// Measured frames draw the whole scene, loading is not part of the timeline
+	Render->FinishSceneLoading();
+
+	const int total = benchmark.TotalFrames();
+	for (int i = 0; i < total; ++i) {
+		benchmark.BeginFrame(*Render, i);
+		Render->Render();
+		benchmark.EndFrame(*Render);
+	}
+	glFinish();
+
+	return benchmark.WriteReport(GWidth, GHeight);
+}
+
+void HeadlessApplication::ReadPixels(std::vector<unsigned char>& o_Pixels) {
+	const int width = (int)GWidth;
+	const int height = (int)GHeight;
+	const size_t row_size = (size_t)width * 4;
+
+	std::vector<unsigned char> pixels(row_size * height);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, OutputFramebuffer);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+	// OpenGL rows start at the bottom of the image
+	o_Pixels.resize(pixels.size());
+	for (int row = 0; row < height; ++row) {
+		memcpy(&o_Pixels[row * row_size], &pixels[(height - 1 - row) * row_size], row_size);
+	}
+}
+
+bool HeadlessApplication::SaveImage(const char* i_Filename) {
+	std::vector<unsigned char> pixels;
+	ReadPixels(pixels);
+
+	if (!stbi_write_png(i_Filename, (int)GWidth, (int)GHeight, 4, pixels.data(), (int)GWidth * 4)) {
+		UtilsInstance->ErrorMessage("Image Saving Error", i_Filename);
+		return false;
+	}
+	return true;
+}
+
+void HeadlessApplication::CreateOutputFramebuffer() {
+	OutputTexture = RenderClass::CreateRectTexture((size_t)GWidth, (size_t)GHeight, GL_RGBA, GL_RGBA8, GL_UNSIGNED_BYTE);
+
+	// Lighting pass draws fullscreen quad without depth test, color attachment is enough
+	std::pair<GLenum, GLuint> pairs[] = {
+		std::make_pair(GL_COLOR_ATTACHMENT0, OutputTexture),
+	};
+	OutputFramebuffer = RenderClass::CreateRenderTarget(std::vector<std::pair<GLenum, GLuint>>(pairs, pairs + 1));
+}
+
+#if defined(HEADLESS_OSMESA)
+
+bool HeadlessApplication::CreateOpenGLContext() {
+	PROFILE_FUNCTION();
+
+	const int count = sizeof(ContextVersions) / sizeof(ContextVersions[0]);
+
+	// Find and create context with the highest supported version
+	for (int i = 0; i < count && !MesaContext; ++i) {
+		const int context_attribs[] = {
+			OSMESA_FORMAT,					OSMESA_RGBA,                    // Format of default color buffer
+			OSMESA_DEPTH_BITS,				24,                             // 24 bits for depth buffer
+			OSMESA_STENCIL_BITS,			8,                              // 8 bits for stencil buffer
+			OSMESA_PROFILE,					OSMESA_CORE_PROFILE,            // Only core functionality
+			OSMESA_CONTEXT_MAJOR_VERSION,	ContextVersions[i][0],          // Major version of context
+			OSMESA_CONTEXT_MINOR_VERSION,	ContextVersions[i][1],          // Minor version of context
+			0                                                               // End of list
+		};
+		MesaContext = OSMesaCreateContextAttribs(context_attribs, nullptr);
+	}
+	if (!MesaContext) {
+		UtilsInstance->ErrorMessage("OpenGL Creation Error", "Could not create OSMesa rendering context.");
+		return false;
+	}
+
+	// Render draws into its own framebuffers, default buffer only has to exist
+	MesaBuffer.resize((size_t)GWidth * (size_t)GHeight * 4);
+	if (!OSMesaMakeCurrent(MesaContext, MesaBuffer.data(), GL_UNSIGNED_BYTE, (int)GWidth, (int)GHeight)) {
+		UtilsInstance->ErrorMessage("OpenGL Creation Error", "Could not activate rendering context.");
+		return false;
+	}
+	return true;
+}
+
+void HeadlessApplication::DestroyOpenGLContext() {
+	if (MesaContext) {
+		OSMesaDestroyContext(MesaContext);
+		MesaContext = nullptr;
+	}
+	MesaBuffer.clear();
+}
+
+#else
+
+bool HeadlessApplication::CreateOpenGLContext() {
+	PROFILE_FUNCTION();
+
+	// Surfaceless platform works without any display server, otherwise fall back to default display
+	ExtensionSet client_extensions;
+	client_extensions.Parse(eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS));
+	PFNEGLGETPLATFORMDISPLAYEXTPROC eglGetPlatformDisplayEXT = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (eglGetPlatformDisplayEXT && client_extensions.Has("EGL_MESA_platform_surfaceless")) {
+		Display = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (Display == EGL_NO_DISPLAY) {
+		Display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint major_version, minor_version;
+	if (Display == EGL_NO_DISPLAY || !eglInitialize(Display, &major_version, &minor_version)) {
+		UtilsInstance->ErrorMessage("OpenGL Creation Error", "Could not initialize EGL display.");
+		return false;
+	}
+
+	// Context has to be made current without any surface
+	ExtensionSet display_extensions;
+	display_extensions.Parse(eglQueryString(Display, EGL_EXTENSIONS));
+	if (!display_extensions.Has("EGL_KHR_surfaceless_context")) {
+		UtilsInstance->ErrorMessage("OpenGL Creation Error", "EGL display does not support surfaceless contexts.");
+		return false;
+	}
+	if (!eglBindAPI(EGL_OPENGL_API)) {
+		UtilsInstance->ErrorMessage("OpenGL Creation Error", "EGL does not support desktop OpenGL.");
+		return false;
+	}
+
+	const EGLint config_attribs[] = {
+		EGL_SURFACE_TYPE,		EGL_PBUFFER_BIT,                        // Offscreen capable configuration
+		EGL_RENDERABLE_TYPE,	EGL_OPENGL_BIT,                         // Support for desktop OpenGL
+		EGL_NONE                                                        // End of list
+	};
+
+	EGLConfig config;
+	EGLint num_configs = 0;
+	if (!eglChooseConfig(Display, config_attribs, &config, 1, &num_configs) || num_configs == 0) {
+		UtilsInstance->ErrorMessage("OpenGL Creation Error", "Could not find EGL configuration.");
+		return false;
+	}
+
+	// Find and create context with the highest supported version
+	const int count = sizeof(ContextVersions) / sizeof(ContextVersions[0]);
+	for (int i = 0; i < count && Context == EGL_NO_CONTEXT; ++i) {
+		const EGLint context_attribs[] = {
+			EGL_CONTEXT_MAJOR_VERSION,			ContextVersions[i][0],                  // Major version of context
+			EGL_CONTEXT_MINOR_VERSION,			ContextVersions[i][1],                  // Minor version of context
+			EGL_CONTEXT_OPENGL_PROFILE_MASK,	EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,    // Only core functionality
+			EGL_NONE                                                                    // End of list
+		};
+		Context = eglCreateContext(Display, config, EGL_NO_CONTEXT, context_attribs);
+	}
+	if (Context == EGL_NO_CONTEXT) {
+		UtilsInstance->ErrorMessage("OpenGL Creation Error", "Could not create OpenGL 3.1+ rendering context.");
+		return false;
+	}
+
+	if (!eglMakeCurrent(Display, EGL_NO_SURFACE, EGL_NO_SURFACE, Context)) {
+		UtilsInstance->ErrorMessage("OpenGL Creation Error", "Could not activate rendering context.");
+		return false;
+	}
+	return true;
+}
+
+void HeadlessApplication::DestroyOpenGLContext() {
+	if (Display == EGL_NO_DISPLAY) {
+		return;
+	}
+
+	eglMakeCurrent(Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (Context != EGL_NO_CONTEXT) {
+		eglDestroyContext(Display, Context);
+		Context = EGL_NO_CONTEXT;
+	}
+	eglTerminate(Display);
+	Display = EGL_NO_DISPLAY;
+}
+
+#endif
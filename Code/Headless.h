@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include "Render/OpenGLFunctions.h"
+#include "Render/Render.h"
+#include "Benchmark.h"
+#include "Utils/Utils.h"
+#include "Utils/ExtensionSet.h"
+#include "Utils/PhaseTimer.h"
+
+#if defined(HEADLESS_OSMESA)
+// GL/osmesa.h pulls in GL/gl.h whose prototypes collide with loaded function pointers,
+// types are already provided by glcorearb.h
+#define __gl_h_
+#ifndef GLAPI
+#define GLAPI extern
+#endif
+#ifndef GLAPIENTRY
+#define GLAPIENTRY APIENTRY
+#endif
+#include <GL/osmesa.h>
+#else
+// Surfaceless context needs no display server headers
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+// Headless application predifinitions
+#define DefaultHeadlessWidth 1920
+#define DefaultHeadlessHeight 1080
+#define DefaultHeadlessFrames 1
+
+// Offscreen application without window and message pump
+// Renders into framebuffer object of requested size using surfaceless EGL context
+// or OSMesa context when built with HEADLESS_OSMESA
+class HeadlessApplication {
+
+private:
+
+	// Main render
+	std::unique_ptr<RenderClass>	Render;
+
+#if defined(HEADLESS_OSMESA)
+	OSMesaContext   MesaContext = nullptr;                  // OSMesa rendering context
+	std::vector<unsigned char> MesaBuffer;                  // Default color buffer OSMesa needs to make context current
+#else
+	EGLDisplay      Display = EGL_NO_DISPLAY;               // EGL display, surfaceless platform if available
+	EGLContext      Context = EGL_NO_CONTEXT;               // Rendering context for OpenGL
+#endif
+
+	GLuint          OutputTexture = 0;                      // Color texture lighting pass draws into
+	GLuint          OutputFramebuffer = 0;                  // Framebuffer replacing window back buffer
+
+	float           GWidth = DefaultHeadlessWidth;          // Output width
+	float           GHeight = DefaultHeadlessHeight;        // Output height
+
+	PhaseTimer      StartupTimer;                           // Durations of startup phases
+
+	bool CreateOpenGLContext();
+	void DestroyOpenGLContext();
+	void CreateOutputFramebuffer();
+
+public:
+	HeadlessApplication(const int i_Width, const int i_Height, const LightingQuality i_Quality = DefaultLightingQuality);
+
+	~HeadlessApplication();
+
+	// Render given number of frames and wait until GPU finishes them
+	void Run(const int i_Frames);
+
+	// Render scripted benchmark timeline and write its report
+	bool RunBenchmark(const int i_Frames, const char* i_ReportPath, const BenchmarkTimeline i_Timeline = BenchmarkTimelineOrbit);
+
+	// Read output image as tightly packed RGBA rows, top row first
+	void ReadPixels(std::vector<unsigned char>& o_Pixels);
+
+	// Store output image in PNG file
+	bool SaveImage(const char* i_Filename);
+
+	RenderClass* GetRender() {
+		return Render.get();
+	}
+
+	float* GetGWidth() {
+		return &GWidth;
+	}
+
+	float* GetGHeight() {
+		return &GHeight;
+	}
+};
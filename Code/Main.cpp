@@ -1,19 +1,72 @@
+#ifdef _WIN32
 #include "Application.h"
-#include "Configs\\KeysConfiguration.h"
-#include "Utils\\Utils.h"
+#else
+#include "Headless.h"
+#endif
+#include "Configs/KeysConfiguration.h"
+#include "MicroBenchmarks.h"
+#include "Utils/Utils.h"
 
 #define EXIT_CODE 0 // Exit code for application
 
+#ifdef _WIN32
+
 // WinApi window creation and handle
 LRESULT CALLBACK WndProc( HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam );
 
 std::unique_ptr<Application> app; // Main application
 int WINAPI WinMain(HINSTANCE i_Instance, HINSTANCE i_PrevInstance, LPSTR i_CmdLine, int i_CmdShow ) {
-  
-	app.reset(new Application(i_Instance, WndProc)); // Create application instance updating smart pointer
-    app->Run();
 
-    return 0;
+    // Benchmark options: --benchmark N --report path --timeline orbit|textures, profiler trace: --trace path, lighting: --quality low|medium|high
+    // CPU kernels alone: --microbench matrix|bvh|all --report path, no window is created
+    int benchmark_frames = 0;
+    const char* report = nullptr;
+    const char* trace = nullptr;
+    const char* microbench = nullptr;
+    LightingQuality quality = DefaultLightingQuality;
+    BenchmarkTimeline timeline = BenchmarkTimelineOrbit;
+    for (int i = 1; i + 1 < __argc; i += 2) {
+        if (strcmp(__argv[i], "--benchmark") == 0) benchmark_frames = atoi(__argv[i + 1]);
+        else if (strcmp(__argv[i], "--report") == 0) report = __argv[i + 1];
+        else if (strcmp(__argv[i], "--trace") == 0) trace = __argv[i + 1];
+        else if (strcmp(__argv[i], "--quality") == 0) {
+            if (!LightingQualityFromName(__argv[i + 1], quality)) {
+                UtilsInstance->ErrorMessage("Command Line Error", (std::string("Unknown lighting quality ") + __argv[i + 1] + ", expected low, medium or high").c_str());
+                return 1;
+            }
+        }
+        else if (strcmp(__argv[i], "--timeline") == 0) {
+            if (!BenchmarkTimelineFromName(__argv[i + 1], timeline)) {
+                UtilsInstance->ErrorMessage("Command Line Error", (std::string("Unknown benchmark timeline ") + __argv[i + 1] + ", expected orbit or textures").c_str());
+                return 1;
+            }
+        }
+        else if (strcmp(__argv[i], "--microbench") == 0) microbench = __argv[i + 1];
+    }
+#if !defined(ENABLE_PROFILER)
+    if (trace) {
+        UtilsInstance->ErrorMessage("Profiler Warning", "Tracing is compiled out, build with ENABLE_PROFILER to write --trace");
+        trace = nullptr;
+    }
+#endif
+    if (microbench) {
+        return MicroBenchmarks(report).Run(microbench) ? 0 : 1;
+    }
+
+	app.reset(new Application(i_Instance, WndProc, quality)); // Create application instance updating smart pointer, only the chosen lighting permutation is built
+
+    int result = 0;
+    if (benchmark_frames > 0) {
+        result = app->RunBenchmark(benchmark_frames, report, timeline) ? 0 : 1;
+    }
+    else {
+        app->Run();
+    }
+
+    if (trace && !PROFILE_WRITE_TRACE(trace)) {
+        UtilsInstance->ErrorMessage("Profiler Warning", "Could not write trace");
+    }
+    return result;
 }
 
 LRESULT CALLBACK WndProc(HWND i_hWnd, UINT i_Message, WPARAM i_wParam, LPARAM i_lParam ) {
@@ -32,7 +85,7 @@ LRESULT CALLBACK WndProc(HWND i_hWnd, UINT i_Message, WPARAM i_wParam, LPARAM i_
             return 0;
         }
     case WM_KEYDOWN: {                                              // User pressed any key
-            app->GetRender()->UpdateParameters(i_wParam, i_lParam);
+            app->GetRender()->UpdateParameters((unsigned int)i_wParam);
             return 0;
         }
     case WM_KEYUP: {                                                // User released any key
@@ -52,3 +105,72 @@ LRESULT CALLBACK WndProc(HWND i_hWnd, UINT i_Message, WPARAM i_wParam, LPARAM i_
     }
     return 0;
 }
+
+#else
+
+// Headless entry point, options: --width W --height H --frames N --output image.png --benchmark N --report path --trace path
+// --timeline orbit|textures --quality low|medium|high, --microbench matrix|bvh|all runs CPU kernels alone without a GL context
+int main(int argc, char** argv) {
+    int width = DefaultHeadlessWidth;
+    int height = DefaultHeadlessHeight;
+    int frames = DefaultHeadlessFrames;
+    int benchmark_frames = 0;
+    const char* output = nullptr;
+    const char* report = nullptr;
+    const char* trace = nullptr;
+    const char* microbench = nullptr;
+    LightingQuality quality = DefaultLightingQuality;
+    BenchmarkTimeline timeline = BenchmarkTimelineOrbit;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--width") == 0) width = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--height") == 0) height = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--frames") == 0) frames = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--output") == 0) output = argv[i + 1];
+        else if (strcmp(argv[i], "--benchmark") == 0) benchmark_frames = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--report") == 0) report = argv[i + 1];
+        else if (strcmp(argv[i], "--trace") == 0) trace = argv[i + 1];
+        else if (strcmp(argv[i], "--quality") == 0) {
+            if (!LightingQualityFromName(argv[i + 1], quality)) {
+                UtilsInstance->ErrorMessage("Command Line Error", (std::string("Unknown lighting quality ") + argv[i + 1] + ", expected low, medium or high").c_str());
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--timeline") == 0) {
+            if (!BenchmarkTimelineFromName(argv[i + 1], timeline)) {
+                UtilsInstance->ErrorMessage("Command Line Error", (std::string("Unknown benchmark timeline ") + argv[i + 1] + ", expected orbit or textures").c_str());
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--microbench") == 0) microbench = argv[i + 1];
+    }
+#if !defined(ENABLE_PROFILER)
+    if (trace) {
+        UtilsInstance->ErrorMessage("Profiler Warning", "Tracing is compiled out, build with ENABLE_PROFILER to write --trace");
+        trace = nullptr;
+    }
+#endif
+    if (microbench) {
+        return MicroBenchmarks(report).Run(microbench) ? 0 : 1;
+    }
+
+    HeadlessApplication app(width, height, quality);
+    if (benchmark_frames > 0) {
+        if (!app.RunBenchmark(benchmark_frames, report, timeline)) {
+            return 1;
+        }
+    }
+    else {
+        app.Run(frames);
+    }
+
+    if (output && !app.SaveImage(output)) {
+        return 1;
+    }
+    if (trace && !PROFILE_WRITE_TRACE(trace)) {
+        UtilsInstance->ErrorMessage("Profiler Warning", "Could not write trace");
+    }
+    return EXIT_CODE;
+}
+
+#endif
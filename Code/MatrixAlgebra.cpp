@@ -1,9 +1,182 @@
 #include <cmath>
-#include <Windows.h>
+#include <immintrin.h>
 #include "MatrixAlgebra.h"
 
 #define DEG_TO_RAD 0.01745329251994329576923690768489f
 
+// Column j of result = i_Matrix1 * column j of i_Matrix2
+static inline __m128 MultiplyColumn( const __m128 i_C0,
+                                     const __m128 i_C1,
+                                     const __m128 i_C2,
+                                     const __m128 i_C3,
+                                     const __m128 i_Column ) {
+    __m128 result = _mm_mul_ps( i_C0, _mm_shuffle_ps( i_Column, i_Column, _MM_SHUFFLE( 0, 0, 0, 0 ) ) );
+    result = _mm_add_ps( result, _mm_mul_ps( i_C1, _mm_shuffle_ps( i_Column, i_Column, _MM_SHUFFLE( 1, 1, 1, 1 ) ) ) );
+    result = _mm_add_ps( result, _mm_mul_ps( i_C2, _mm_shuffle_ps( i_Column, i_Column, _MM_SHUFFLE( 2, 2, 2, 2 ) ) ) );
+    result = _mm_add_ps( result, _mm_mul_ps( i_C3, _mm_shuffle_ps( i_Column, i_Column, _MM_SHUFFLE( 3, 3, 3, 3 ) ) ) );
+    return result;
+}
+
+// Unaligned 4x4 product, safe when o_Output aliases one of the inputs
+static inline void MultiplySSE( const float* i_Matrix1,
+                                const float* i_Matrix2,
+                                float*       o_Output ) {
+    const __m128 c0 = _mm_loadu_ps( i_Matrix1 + 0 );
+    const __m128 c1 = _mm_loadu_ps( i_Matrix1 + 4 );
+    const __m128 c2 = _mm_loadu_ps( i_Matrix1 + 8 );
+    const __m128 c3 = _mm_loadu_ps( i_Matrix1 + 12 );
+
+    const __m128 r0 = MultiplyColumn( c0, c1, c2, c3, _mm_loadu_ps( i_Matrix2 + 0 ) );
+    const __m128 r1 = MultiplyColumn( c0, c1, c2, c3, _mm_loadu_ps( i_Matrix2 + 4 ) );
+    const __m128 r2 = MultiplyColumn( c0, c1, c2, c3, _mm_loadu_ps( i_Matrix2 + 8 ) );
+    const __m128 r3 = MultiplyColumn( c0, c1, c2, c3, _mm_loadu_ps( i_Matrix2 + 12 ) );
+
+    _mm_storeu_ps( o_Output + 0, r0 );
+    _mm_storeu_ps( o_Output + 4, r1 );
+    _mm_storeu_ps( o_Output + 8, r2 );
+    _mm_storeu_ps( o_Output + 12, r3 );
+}
+
+#if defined( __AVX2__ )
+// Two result columns per iteration - columns of i_Matrix1 are duplicated into both 128-bit lanes
+static inline void MultiplyAVX2( const __m256 i_C0,
+                                 const __m256 i_C1,
+                                 const __m256 i_C2,
+                                 const __m256 i_C3,
+                                 const float* i_Matrix2,
+                                 float*       o_Output ) {
+    for( int j = 0; j < 16; j += 8 ) {
+        const __m256 columns = _mm256_loadu_ps( i_Matrix2 + j );
+
+        __m256 result = _mm256_mul_ps( i_C0, _mm256_permute_ps( columns, _MM_SHUFFLE( 0, 0, 0, 0 ) ) );
+        result = _mm256_fmadd_ps( i_C1, _mm256_permute_ps( columns, _MM_SHUFFLE( 1, 1, 1, 1 ) ), result );
+        result = _mm256_fmadd_ps( i_C2, _mm256_permute_ps( columns, _MM_SHUFFLE( 2, 2, 2, 2 ) ), result );
+        result = _mm256_fmadd_ps( i_C3, _mm256_permute_ps( columns, _MM_SHUFFLE( 3, 3, 3, 3 ) ), result );
+
+        _mm256_storeu_ps( o_Output + j, result );
+    }
+}
+#endif
+
+Mat4 Mat4Identity() {
+    Mat4 result;
+    GetIdentityMatrix( result.m );
+    return result;
+}
+
+Mat4 Mat4FromFloats( const float* i_Matrix ) {
+    Mat4 result;
+    _mm_store_ps( result.m + 0, _mm_loadu_ps( i_Matrix + 0 ) );
+    _mm_store_ps( result.m + 4, _mm_loadu_ps( i_Matrix + 4 ) );
+    _mm_store_ps( result.m + 8, _mm_loadu_ps( i_Matrix + 8 ) );
+    _mm_store_ps( result.m + 12, _mm_loadu_ps( i_Matrix + 12 ) );
+    return result;
+}
+
+Mat4 Multiply( const Mat4& i_Matrix1,
+               const Mat4& i_Matrix2 ) {
+    Mat4 result;
+    MultiplySSE( i_Matrix1.m, i_Matrix2.m, result.m );
+    return result;
+}
+
+Vec4 Transform( const Mat4& i_Matrix,
+                const Vec4& i_Vector ) {
+    Vec4 result;
+    _mm_store_ps( &result.x, MultiplyColumn( _mm_load_ps( i_Matrix.m + 0 ),
+                                             _mm_load_ps( i_Matrix.m + 4 ),
+                                             _mm_load_ps( i_Matrix.m + 8 ),
+                                             _mm_load_ps( i_Matrix.m + 12 ),
+                                             _mm_load_ps( &i_Vector.x ) ) );
+    return result;
+}
+
+Mat4 Transpose( const Mat4& i_Matrix ) {
+    __m128 c0 = _mm_load_ps( i_Matrix.m + 0 );
+    __m128 c1 = _mm_load_ps( i_Matrix.m + 4 );
+    __m128 c2 = _mm_load_ps( i_Matrix.m + 8 );
+    __m128 c3 = _mm_load_ps( i_Matrix.m + 12 );
+    _MM_TRANSPOSE4_PS( c0, c1, c2, c3 );
+
+    Mat4 result;
+    _mm_store_ps( result.m + 0, c0 );
+    _mm_store_ps( result.m + 4, c1 );
+    _mm_store_ps( result.m + 8, c2 );
+    _mm_store_ps( result.m + 12, c3 );
+    return result;
+}
+
+void MultiplyN( const Mat4* i_Matrices1,
+                const Mat4* i_Matrices2,
+                Mat4*       o_Output,
+                size_t      i_Count ) {
+    for( size_t i = 0; i < i_Count; ++i ) {
+#if defined( __AVX2__ )
+        const float* a = i_Matrices1[i].m;
+        MultiplyAVX2( _mm256_broadcast_ps( (const __m128*)( a + 0 ) ),
+                      _mm256_broadcast_ps( (const __m128*)( a + 4 ) ),
+                      _mm256_broadcast_ps( (const __m128*)( a + 8 ) ),
+                      _mm256_broadcast_ps( (const __m128*)( a + 12 ) ),
+                      i_Matrices2[i].m, o_Output[i].m );
+#else
+        MultiplySSE( i_Matrices1[i].m, i_Matrices2[i].m, o_Output[i].m );
+#endif
+    }
+}
+
+void MultiplyN( const Mat4& i_Matrix,
+                const Mat4* i_Matrices,
+                Mat4*       o_Output,
+                size_t      i_Count ) {
+    // Columns of the shared matrix stay in registers for the whole batch
+#if defined( __AVX2__ )
+    const __m256 c0 = _mm256_broadcast_ps( (const __m128*)( i_Matrix.m + 0 ) );
+    const __m256 c1 = _mm256_broadcast_ps( (const __m128*)( i_Matrix.m + 4 ) );
+    const __m256 c2 = _mm256_broadcast_ps( (const __m128*)( i_Matrix.m + 8 ) );
+    const __m256 c3 = _mm256_broadcast_ps( (const __m128*)( i_Matrix.m + 12 ) );
+
+    for( size_t i = 0; i < i_Count; ++i ) {
+        MultiplyAVX2( c0, c1, c2, c3, i_Matrices[i].m, o_Output[i].m );
+    }
+#else
+    const __m128 c0 = _mm_load_ps( i_Matrix.m + 0 );
+    const __m128 c1 = _mm_load_ps( i_Matrix.m + 4 );
+    const __m128 c2 = _mm_load_ps( i_Matrix.m + 8 );
+    const __m128 c3 = _mm_load_ps( i_Matrix.m + 12 );
+
+    for( size_t i = 0; i < i_Count; ++i ) {
+        const float* b = i_Matrices[i].m;
+        float*       r = o_Output[i].m;
+        _mm_store_ps( r + 0, MultiplyColumn( c0, c1, c2, c3, _mm_load_ps( b + 0 ) ) );
+        _mm_store_ps( r + 4, MultiplyColumn( c0, c1, c2, c3, _mm_load_ps( b + 4 ) ) );
+        _mm_store_ps( r + 8, MultiplyColumn( c0, c1, c2, c3, _mm_load_ps( b + 8 ) ) );
+        _mm_store_ps( r + 12, MultiplyColumn( c0, c1, c2, c3, _mm_load_ps( b + 12 ) ) );
+    }
+#endif
+}
+
+void TransformN( const Mat4& i_Matrix,
+                 const Vec4* i_Vectors,
+                 Vec4*       o_Output,
+                 size_t      i_Count ) {
+    const __m128 c0 = _mm_load_ps( i_Matrix.m + 0 );
+    const __m128 c1 = _mm_load_ps( i_Matrix.m + 4 );
+    const __m128 c2 = _mm_load_ps( i_Matrix.m + 8 );
+    const __m128 c3 = _mm_load_ps( i_Matrix.m + 12 );
+
+    for( size_t i = 0; i < i_Count; ++i ) {
+        _mm_store_ps( &o_Output[i].x, MultiplyColumn( c0, c1, c2, c3, _mm_load_ps( &i_Vectors[i].x ) ) );
+    }
+}
+
+void TransposeN( const Mat4* i_Matrices,
+                 Mat4*       o_Output,
+                 size_t      i_Count ) {
+    for( size_t i = 0; i < i_Count; ++i ) {
+        o_Output[i] = Transpose( i_Matrices[i] );
+    }
+}
+
 void GetIdentityMatrix( float* o_Output ) {
     o_Output[0] = 1.0f;
     o_Output[1] = 0.0f;
@@ -214,175 +387,304 @@ void GetScalingMatrix( const float i_XAxis,
 void Multiply( const float* i_Matrix1,
                const float* i_Matrix2,
                float*       o_Output ) {
-    float result[16];
-
-    result[0] = i_Matrix1[0] * i_Matrix2[0] + i_Matrix1[4] * i_Matrix2[1] + i_Matrix1[8] * i_Matrix2[2] + i_Matrix1[12] * i_Matrix2[3];
-    result[1] = i_Matrix1[1] * i_Matrix2[0] + i_Matrix1[5] * i_Matrix2[1] + i_Matrix1[9] * i_Matrix2[2] + i_Matrix1[13] * i_Matrix2[3];
-    result[2] = i_Matrix1[2] * i_Matrix2[0] + i_Matrix1[6] * i_Matrix2[1] + i_Matrix1[10] * i_Matrix2[2] + i_Matrix1[14] * i_Matrix2[3];
-    result[3] = i_Matrix1[3] * i_Matrix2[0] + i_Matrix1[7] * i_Matrix2[1] + i_Matrix1[11] * i_Matrix2[2] + i_Matrix1[15] * i_Matrix2[3];
-
-    result[4] = i_Matrix1[0] * i_Matrix2[4] + i_Matrix1[4] * i_Matrix2[5] + i_Matrix1[8] * i_Matrix2[6] + i_Matrix1[12] * i_Matrix2[7];
-    result[5] = i_Matrix1[1] * i_Matrix2[4] + i_Matrix1[5] * i_Matrix2[5] + i_Matrix1[9] * i_Matrix2[6] + i_Matrix1[13] * i_Matrix2[7];
-    result[6] = i_Matrix1[2] * i_Matrix2[4] + i_Matrix1[6] * i_Matrix2[5] + i_Matrix1[10] * i_Matrix2[6] + i_Matrix1[14] * i_Matrix2[7];
-    result[7] = i_Matrix1[3] * i_Matrix2[4] + i_Matrix1[7] * i_Matrix2[5] + i_Matrix1[11] * i_Matrix2[6] + i_Matrix1[15] * i_Matrix2[7];
-
-    result[8] = i_Matrix1[0] * i_Matrix2[8] + i_Matrix1[4] * i_Matrix2[9] + i_Matrix1[8] * i_Matrix2[10] + i_Matrix1[12] * i_Matrix2[11];
-    result[9] = i_Matrix1[1] * i_Matrix2[8] + i_Matrix1[5] * i_Matrix2[9] + i_Matrix1[9] * i_Matrix2[10] + i_Matrix1[13] * i_Matrix2[11];
-    result[10] = i_Matrix1[2] * i_Matrix2[8] + i_Matrix1[6] * i_Matrix2[9] + i_Matrix1[10] * i_Matrix2[10] + i_Matrix1[14] * i_Matrix2[11];
-    result[11] = i_Matrix1[3] * i_Matrix2[8] + i_Matrix1[7] * i_Matrix2[9] + i_Matrix1[11] * i_Matrix2[10] + i_Matrix1[15] * i_Matrix2[11];
-
-    result[12] = i_Matrix1[0] * i_Matrix2[12] + i_Matrix1[4] * i_Matrix2[13] + i_Matrix1[8] * i_Matrix2[14] + i_Matrix1[12] * i_Matrix2[15];
-    result[13] = i_Matrix1[1] * i_Matrix2[12] + i_Matrix1[5] * i_Matrix2[13] + i_Matrix1[9] * i_Matrix2[14] + i_Matrix1[13] * i_Matrix2[15];
-    result[14] = i_Matrix1[2] * i_Matrix2[12] + i_Matrix1[6] * i_Matrix2[13] + i_Matrix1[10] * i_Matrix2[14] + i_Matrix1[14] * i_Matrix2[15];
-    result[15] = i_Matrix1[3] * i_Matrix2[12] + i_Matrix1[7] * i_Matrix2[13] + i_Matrix1[11] * i_Matrix2[14] + i_Matrix1[15] * i_Matrix2[15];
-
-    memcpy_s( o_Output, 16*sizeof(float), result, 16*sizeof(float) );
+    MultiplySSE( i_Matrix1, i_Matrix2, o_Output );
 }
 
+// In-place transforms below premultiply io_Matrix (M = T * M) and only touch the rows
+// the elementary matrix actually changes instead of running a full 4x4 product
+
 void Translate( const float i_XAxis,
                 const float i_YAxis,
                 const float i_ZAxis,
                 float*      io_Matrix ) {
-    float matrix[16];
-
-    matrix[0] = 1.0f;
-    matrix[1] = 0.0f;
-    matrix[2] = 0.0f;
-    matrix[3] = 0.0f;
+    // Rows 0..2 gain translation * row 3
+    const __m128 translation = _mm_set_ps( 0.0f, i_ZAxis, i_YAxis, i_XAxis );
+
+    for( int column = 0; column < 16; column += 4 ) {
+        const __m128 values = _mm_loadu_ps( io_Matrix + column );
+        const __m128 w = _mm_shuffle_ps( values, values, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+        _mm_storeu_ps( io_Matrix + column, _mm_add_ps( values, _mm_mul_ps( translation, w ) ) );
+    }
+}
 
-    matrix[4] = 0.0f;
-    matrix[5] = 1.0f;
-    matrix[6] = 0.0f;
-    matrix[7] = 0.0f;
+void XRotate( const float i_Angle,
+              float*      io_Matrix ) {
+    float cos_angle = cos( i_Angle * DEG_TO_RAD );
+    float sin_angle = sin( i_Angle * DEG_TO_RAD );
 
-    matrix[8]  = 0.0f;
-    matrix[9]  = 0.0f;
-    matrix[10] = 1.0f;
-    matrix[11] = 0.0f;
+    // Mixes rows 1 and 2
+    for( int column = 0; column < 16; column += 4 ) {
+        const float y = io_Matrix[column + 1];
+        const float z = io_Matrix[column + 2];
+        io_Matrix[column + 1] = cos_angle * y - sin_angle * z;
+        io_Matrix[column + 2] = sin_angle * y + cos_angle * z;
+    }
+}
 
-    matrix[12] = i_XAxis;
-    matrix[13] = i_YAxis;
-    matrix[14] = i_ZAxis;
-    matrix[15] = 1.0f;
+void YRotate( const float i_Angle,
+              float*      io_Matrix ) {
+    float cos_angle = cos( i_Angle * DEG_TO_RAD );
+    float sin_angle = sin( i_Angle * DEG_TO_RAD );
 
-    Multiply( matrix, io_Matrix, io_Matrix );
+    // Mixes rows 0 and 2
+    for( int column = 0; column < 16; column += 4 ) {
+        const float x = io_Matrix[column + 0];
+        const float z = io_Matrix[column + 2];
+        io_Matrix[column + 0] = cos_angle * x + sin_angle * z;
+        io_Matrix[column + 2] = cos_angle * z - sin_angle * x;
+    }
 }
 
-void XRotate( const float i_Angle,
+void ZRotate( const float i_Angle,
               float*      io_Matrix ) {
-    float matrix[16];
-
     float cos_angle = cos( i_Angle * DEG_TO_RAD );
     float sin_angle = sin( i_Angle * DEG_TO_RAD );
 
-    matrix[0] = 1.0f;
-    matrix[1] = 0.0f;
-    matrix[2] = 0.0f;
-    matrix[3] = 0.0f;
+    // Mixes rows 0 and 1
+    for( int column = 0; column < 16; column += 4 ) {
+        const float x = io_Matrix[column + 0];
+        const float y = io_Matrix[column + 1];
+        io_Matrix[column + 0] = cos_angle * x - sin_angle * y;
+        io_Matrix[column + 1] = sin_angle * x + cos_angle * y;
+    }
+}
 
-    matrix[4] = 0.0f;
-    matrix[5] = cos_angle;
-    matrix[6] = sin_angle;
-    matrix[7] = 0.0f;
+void Scale( const float i_XAxis,
+            const float i_YAxis,
+            const float i_ZAxis,
+            float*      io_Matrix ) {
+    // Scales rows 0..2
+    const __m128 scale = _mm_set_ps( 1.0f, i_ZAxis, i_YAxis, i_XAxis );
 
-    matrix[8]  = 0.0f;
-    matrix[9]  = -sin_angle;
-    matrix[10] = cos_angle;
-    matrix[11] = 0.0f;
+    for( int column = 0; column < 16; column += 4 ) {
+        _mm_storeu_ps( io_Matrix + column, _mm_mul_ps( _mm_loadu_ps( io_Matrix + column ), scale ) );
+    }
+}
 
-    matrix[12] = 0.0f;
-    matrix[13] = 0.0f;
-    matrix[14] = 0.0f;
-    matrix[15] = 1.0f;
+Quat QuatIdentity() {
+    return Quat{ 0.0f, 0.0f, 0.0f, 1.0f };
+}
 
-    Multiply( matrix, io_Matrix, io_Matrix );
+Quat QuatFromAxisAngle( const float i_XAxis,
+                        const float i_YAxis,
+                        const float i_ZAxis,
+                        const float i_Angle ) {
+    float half_angle = i_Angle * DEG_TO_RAD * 0.5f;
+    float cos_angle = cos( half_angle );
+    float sin_angle = sin( half_angle );
+    float length = sqrt( i_XAxis * i_XAxis + i_YAxis * i_YAxis + i_ZAxis * i_ZAxis );
+    if( length > 0.0f ) {
+        sin_angle /= length;
+    }
+    return Quat{ i_XAxis * sin_angle, i_YAxis * sin_angle, i_ZAxis * sin_angle, cos_angle };
 }
 
-void YRotate( const float i_Angle,
-              float*      io_Matrix ) {
-    float matrix[16];
+Affine AffineIdentity() {
+    return Affine{ { 1.0f, 0.0f, 0.0f, 0.0f,
+                     0.0f, 1.0f, 0.0f, 0.0f,
+                     0.0f, 0.0f, 1.0f, 0.0f } };
+}
 
-    float cos_angle = cos( i_Angle * DEG_TO_RAD );
-    float sin_angle = sin( i_Angle * DEG_TO_RAD );
+// Rotation part of quaternion written straight into the 3x3 block, each row scaled by given factors
+static inline void WriteRotation( const Quat& i_Rotation,
+                                  const float i_XScale,
+                                  const float i_YScale,
+                                  const float i_ZScale,
+                                  float*      o_Output ) {
+    const float xx = i_Rotation.x * i_Rotation.x;
+    const float yy = i_Rotation.y * i_Rotation.y;
+    const float zz = i_Rotation.z * i_Rotation.z;
+    const float xy = i_Rotation.x * i_Rotation.y;
+    const float xz = i_Rotation.x * i_Rotation.z;
+    const float yz = i_Rotation.y * i_Rotation.z;
+    const float wx = i_Rotation.w * i_Rotation.x;
+    const float wy = i_Rotation.w * i_Rotation.y;
+    const float wz = i_Rotation.w * i_Rotation.z;
+
+    o_Output[0] = ( 1.0f - 2.0f * ( yy + zz ) ) * i_XScale;
+    o_Output[1] = 2.0f * ( xy - wz ) * i_YScale;
+    o_Output[2] = 2.0f * ( xz + wy ) * i_ZScale;
+
+    o_Output[4] = 2.0f * ( xy + wz ) * i_XScale;
+    o_Output[5] = ( 1.0f - 2.0f * ( xx + zz ) ) * i_YScale;
+    o_Output[6] = 2.0f * ( yz - wx ) * i_ZScale;
+
+    o_Output[8]  = 2.0f * ( xz - wy ) * i_XScale;
+    o_Output[9]  = 2.0f * ( yz + wx ) * i_YScale;
+    o_Output[10] = ( 1.0f - 2.0f * ( xx + yy ) ) * i_ZScale;
+}
 
-    matrix[0] = cos_angle;
-    matrix[1] = 0.0f;
-    matrix[2] = -sin_angle;
-    matrix[3] = 0.0f;
+static inline void WriteTranslation( const float* i_Translation,
+                                     float*       o_Output ) {
+    o_Output[3]  = i_Translation[0];
+    o_Output[7]  = i_Translation[1];
+    o_Output[11] = i_Translation[2];
+}
 
-    matrix[4] = 0.0f;
-    matrix[5] = 1.0f;
-    matrix[6] = 0.0f;
-    matrix[7] = 0.0f;
+template<>
+Affine ComposeTRS<TransformKind::Identity>( const float*, const Quat&, const float* ) {
+    return AffineIdentity();
+}
 
-    matrix[8]  = sin_angle;
-    matrix[9]  = 0.0f;
-    matrix[10] = cos_angle;
-    matrix[11] = 0.0f;
+template<>
+Affine ComposeTRS<TransformKind::RotationOnly>( const float* i_Translation,
+                                                const Quat&  i_Rotation,
+                                                const float* ) {
+    Affine result;
+    WriteRotation( i_Rotation, 1.0f, 1.0f, 1.0f, result.m );
+    WriteTranslation( i_Translation, result.m );
+    return result;
+}
 
-    matrix[12] = 0.0f;
-    matrix[13] = 0.0f;
-    matrix[14] = 0.0f;
-    matrix[15] = 1.0f;
+template<>
+Affine ComposeTRS<TransformKind::UniformScale>( const float* i_Translation,
+                                                const Quat&  i_Rotation,
+                                                const float* i_Scale ) {
+    Affine result;
+    WriteRotation( i_Rotation, i_Scale[0], i_Scale[0], i_Scale[0], result.m );
+    WriteTranslation( i_Translation, result.m );
+    return result;
+}
 
-    Multiply( matrix, io_Matrix, io_Matrix );
+template<>
+Affine ComposeTRS<TransformKind::General>( const float* i_Translation,
+                                           const Quat&  i_Rotation,
+                                           const float* i_Scale ) {
+    Affine result;
+    WriteRotation( i_Rotation, i_Scale[0], i_Scale[1], i_Scale[2], result.m );
+    WriteTranslation( i_Translation, result.m );
+    return result;
 }
 
-void ZRotate( const float i_Angle,
-              float*      io_Matrix ) {
-    float matrix[16];
+// Inverse translation: -( A * t ) for the already inverted 3x3 block A
+static inline void WriteInverseTranslation( const Affine& i_Matrix,
+                                            Affine&       io_Inverse ) {
+    const float tx = i_Matrix.m[3];
+    const float ty = i_Matrix.m[7];
+    const float tz = i_Matrix.m[11];
 
-    float cos_angle = cos( i_Angle * DEG_TO_RAD );
-    float sin_angle = sin( i_Angle * DEG_TO_RAD );
+    for( int row = 0; row < 12; row += 4 ) {
+        io_Inverse.m[row + 3] = -( io_Inverse.m[row + 0] * tx + io_Inverse.m[row + 1] * ty + io_Inverse.m[row + 2] * tz );
+    }
+}
 
-    matrix[0] = cos_angle;
-    matrix[1] = sin_angle;
-    matrix[2] = 0.0f;
-    matrix[3] = 0.0f;
+// Transposed 3x3 block scaled by given factor
+static inline void WriteTransposed( const Affine& i_Matrix,
+                                    const float   i_Factor,
+                                    Affine&       o_Output ) {
+    for( int row = 0; row < 3; ++row ) {
+        for( int column = 0; column < 3; ++column ) {
+            o_Output.m[row * 4 + column] = i_Matrix.m[column * 4 + row] * i_Factor;
+        }
+    }
+}
 
-    matrix[4] = -sin_angle;
-    matrix[5] = cos_angle;
-    matrix[6] = 0.0f;
-    matrix[7] = 0.0f;
+template<>
+Affine Inverse<TransformKind::Identity>( const Affine& ) {
+    return AffineIdentity();
+}
 
-    matrix[8]  = 0.0f;
-    matrix[9]  = 0.0f;
-    matrix[10] = 1.0f;
-    matrix[11] = 0.0f;
+template<>
+Affine Inverse<TransformKind::RotationOnly>( const Affine& i_Matrix ) {
+    Affine result;
+    WriteTransposed( i_Matrix, 1.0f, result );
+    WriteInverseTranslation( i_Matrix, result );
+    return result;
+}
 
-    matrix[12] = 0.0f;
-    matrix[13] = 0.0f;
-    matrix[14] = 0.0f;
-    matrix[15] = 1.0f;
+template<>
+Affine Inverse<TransformKind::UniformScale>( const Affine& i_Matrix ) {
+    // ( s * R )^-1 = R^T / s = ( s * R )^T / s^2
+    const float scale_squared = i_Matrix.m[0] * i_Matrix.m[0] + i_Matrix.m[4] * i_Matrix.m[4] + i_Matrix.m[8] * i_Matrix.m[8];
 
-    Multiply( matrix, io_Matrix, io_Matrix );
+    Affine result;
+    WriteTransposed( i_Matrix, 1.0f / scale_squared, result );
+    WriteInverseTranslation( i_Matrix, result );
+    return result;
 }
 
-void Scale( const float i_XAxis,
-            const float i_YAxis,
-            const float i_ZAxis,
-            float*      io_Matrix ) {
-    float matrix[16];
+template<>
+Affine Inverse<TransformKind::General>( const Affine& i_Matrix ) {
+    const float* m = i_Matrix.m;
+
+    // Cofactors of the 3x3 block
+    const float c00 = m[5] * m[10] - m[6] * m[9];
+    const float c01 = m[6] * m[8]  - m[4] * m[10];
+    const float c02 = m[4] * m[9]  - m[5] * m[8];
+
+    const float determinant = m[0] * c00 + m[1] * c01 + m[2] * c02;
+    const float inv_determinant = determinant != 0.0f ? 1.0f / determinant : 0.0f;
 
-    matrix[0] = i_XAxis;
-    matrix[1] = 0.0f;
-    matrix[2] = 0.0f;
-    matrix[3] = 0.0f;
+    Affine result;
+    result.m[0]  = c00 * inv_determinant;
+    result.m[1]  = ( m[2] * m[9]  - m[1] * m[10] ) * inv_determinant;
+    result.m[2]  = ( m[1] * m[6]  - m[2] * m[5] )  * inv_determinant;
 
-    matrix[4] = 0.0f;
-    matrix[5] = i_YAxis;
-    matrix[6] = 0.0f;
-    matrix[7] = 0.0f;
+    result.m[4]  = c01 * inv_determinant;
+    result.m[5]  = ( m[0] * m[10] - m[2] * m[8] )  * inv_determinant;
+    result.m[6]  = ( m[2] * m[4]  - m[0] * m[6] )  * inv_determinant;
 
-    matrix[8]  = 0.0f;
-    matrix[9]  = 0.0f;
-    matrix[10] = i_ZAxis;
-    matrix[11] = 0.0f;
+    result.m[8]  = c02 * inv_determinant;
+    result.m[9]  = ( m[1] * m[8]  - m[0] * m[9] )  * inv_determinant;
+    result.m[10] = ( m[0] * m[5]  - m[1] * m[4] )  * inv_determinant;
 
-    matrix[12] = 0.0f;
-    matrix[13] = 0.0f;
-    matrix[14] = 0.0f;
-    matrix[15] = 1.0f;
+    WriteInverseTranslation( i_Matrix, result );
+    return result;
+}
+
+Affine Multiply( const Affine& i_Matrix1,
+                 const Affine& i_Matrix2 ) {
+    // Row i of result = sum_k A[i][k] * B row k, B row 3 is ( 0, 0, 0, 1 )
+    const __m128 b0 = _mm_load_ps( i_Matrix2.m + 0 );
+    const __m128 b1 = _mm_load_ps( i_Matrix2.m + 4 );
+    const __m128 b2 = _mm_load_ps( i_Matrix2.m + 8 );
+    const __m128 w  = _mm_set_ps( 1.0f, 0.0f, 0.0f, 0.0f );
+
+    Affine result;
+    for( int row = 0; row < 12; row += 4 ) {
+        const __m128 a = _mm_load_ps( i_Matrix1.m + row );
+        __m128 value = _mm_mul_ps( _mm_shuffle_ps( a, a, _MM_SHUFFLE( 0, 0, 0, 0 ) ), b0 );
+        value = _mm_add_ps( value, _mm_mul_ps( _mm_shuffle_ps( a, a, _MM_SHUFFLE( 1, 1, 1, 1 ) ), b1 ) );
+        value = _mm_add_ps( value, _mm_mul_ps( _mm_shuffle_ps( a, a, _MM_SHUFFLE( 2, 2, 2, 2 ) ), b2 ) );
+        value = _mm_add_ps( value, _mm_mul_ps( _mm_shuffle_ps( a, a, _MM_SHUFFLE( 3, 3, 3, 3 ) ), w ) );
+        _mm_store_ps( result.m + row, value );
+    }
+    return result;
+}
+
+Mat4 ToMat4( const Affine& i_Matrix ) {
+    __m128 r0 = _mm_load_ps( i_Matrix.m + 0 );
+    __m128 r1 = _mm_load_ps( i_Matrix.m + 4 );
+    __m128 r2 = _mm_load_ps( i_Matrix.m + 8 );
+    __m128 r3 = _mm_set_ps( 1.0f, 0.0f, 0.0f, 0.0f );
+    _MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+
+    Mat4 result;
+    _mm_store_ps( result.m + 0, r0 );
+    _mm_store_ps( result.m + 4, r1 );
+    _mm_store_ps( result.m + 8, r2 );
+    _mm_store_ps( result.m + 12, r3 );
+    return result;
+}
 
-    Multiply( matrix, io_Matrix, io_Matrix );
+Mat4 Multiply( const Mat4&   i_Matrix1,
+               const Affine& i_Matrix2 ) {
+    // Columns of the affine matrix are read from its rows, w component of the first three is 0
+    const __m128 c0 = _mm_load_ps( i_Matrix1.m + 0 );
+    const __m128 c1 = _mm_load_ps( i_Matrix1.m + 4 );
+    const __m128 c2 = _mm_load_ps( i_Matrix1.m + 8 );
+    const __m128 c3 = _mm_load_ps( i_Matrix1.m + 12 );
+    const float* b = i_Matrix2.m;
+
+    Mat4 result;
+    for( int column = 0; column < 4; ++column ) {
+        __m128 value = _mm_mul_ps( c0, _mm_set1_ps( b[column] ) );
+        value = _mm_add_ps( value, _mm_mul_ps( c1, _mm_set1_ps( b[4 + column] ) ) );
+        value = _mm_add_ps( value, _mm_mul_ps( c2, _mm_set1_ps( b[8 + column] ) ) );
+        if( column == 3 ) {
+            value = _mm_add_ps( value, c3 );
+        }
+        _mm_store_ps( result.m + column * 4, value );
+    }
+    return result;
 }
@@ -1,6 +1,115 @@
 #ifndef _MATRIX_ALGEBRA_HEADER_
 #define _MATRIX_ALGEBRA_HEADER_
 
+#include <cstddef>
+
+// 4 component vector aligned for SSE loads
+struct alignas(16) Vec4 {
+    float x, y, z, w;
+};
+
+// Column-major 4x4 matrix (OpenGL layout) aligned for SSE/AVX loads
+struct alignas(16) Mat4 {
+    float m[16];
+
+    float*       Data()       { return m; }
+    const float* Data() const { return m; }
+};
+
+Mat4 Mat4Identity();
+
+Mat4 Mat4FromFloats( const float* i_Matrix );
+
+// SIMD kernels (AVX2 when compiled with /arch:AVX2, SSE otherwise)
+Mat4 Multiply( const Mat4& i_Matrix1,
+               const Mat4& i_Matrix2 );
+
+Vec4 Transform( const Mat4& i_Matrix,
+                const Vec4& i_Vector );
+
+Mat4 Transpose( const Mat4& i_Matrix );
+
+// Batched kernels - o_Output[i] = i_Matrices1[i] * i_Matrices2[i]
+void MultiplyN( const Mat4* i_Matrices1,
+                const Mat4* i_Matrices2,
+                Mat4*       o_Output,
+                size_t      i_Count );
+
+// o_Output[i] = i_Matrix * i_Matrices[i], e.g. view-projection applied to instance transforms
+void MultiplyN( const Mat4& i_Matrix,
+                const Mat4* i_Matrices,
+                Mat4*       o_Output,
+                size_t      i_Count );
+
+void TransformN( const Mat4& i_Matrix,
+                 const Vec4* i_Vectors,
+                 Vec4*       o_Output,
+                 size_t      i_Count );
+
+void TransposeN( const Mat4* i_Matrices,
+                 Mat4*       o_Output,
+                 size_t      i_Count );
+
+// Unit quaternion, vector part in x, y, z and scalar part in w (glTF order)
+struct Quat {
+    float x, y, z, w;
+};
+
+// Affine transform stored as the top 3 rows of a 4x4 matrix in row-major order,
+// the implied last row is ( 0, 0, 0, 1 ) - 12 floats, one __m128 per row
+struct alignas(16) Affine {
+    float m[12];
+};
+
+// Which parts of a TRS transform are present - used to pick a specialized kernel at compile time
+enum class TransformKind {
+    Identity,       // No rotation, translation or scale
+    RotationOnly,   // Rotation and translation, scale is 1
+    UniformScale,   // Rotation, translation and one scale factor for all axes
+    General         // Rotation, translation and per-axis scale
+};
+
+Quat QuatIdentity();
+
+Quat QuatFromAxisAngle( const float i_XAxis,
+                        const float i_YAxis,
+                        const float i_ZAxis,
+                        const float i_Angle );
+
+Affine AffineIdentity();
+
+// Writes T * R * S directly into the affine matrix. i_Translation and i_Scale point at 3 floats,
+// UniformScale reads only i_Scale[0] and RotationOnly / Identity ignore i_Scale (may be nullptr)
+template<TransformKind Kind>
+Affine ComposeTRS( const float* i_Translation,
+                   const Quat&  i_Rotation,
+                   const float* i_Scale );
+
+template<> Affine ComposeTRS<TransformKind::Identity>( const float*, const Quat&, const float* );
+template<> Affine ComposeTRS<TransformKind::RotationOnly>( const float*, const Quat&, const float* );
+template<> Affine ComposeTRS<TransformKind::UniformScale>( const float*, const Quat&, const float* );
+template<> Affine ComposeTRS<TransformKind::General>( const float*, const Quat&, const float* );
+
+// Inverse of an affine matrix built for the given kind - rotation only and uniform scale
+// use the transposed 3x3 instead of a general cofactor inverse
+template<TransformKind Kind>
+Affine Inverse( const Affine& i_Matrix );
+
+template<> Affine Inverse<TransformKind::Identity>( const Affine& );
+template<> Affine Inverse<TransformKind::RotationOnly>( const Affine& );
+template<> Affine Inverse<TransformKind::UniformScale>( const Affine& );
+template<> Affine Inverse<TransformKind::General>( const Affine& );
+
+Affine Multiply( const Affine& i_Matrix1,
+                 const Affine& i_Matrix2 );
+
+// Expands affine matrix to the column-major layout expected by OpenGL
+Mat4 ToMat4( const Affine& i_Matrix );
+
+// Full 4x4 (e.g. projection) times affine matrix
+Mat4 Multiply( const Mat4&   i_Matrix1,
+               const Affine& i_Matrix2 );
+
 void GetIdentityMatrix( float* o_Output );
 
 void GetPerspectiveProjectionMatrix( const float i_Left,
@@ -0,0 +1,392 @@
+#include "MicroBenchmarks.h"
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include "MatrixAlgebra.h"
+#include "Render/BVH.h"
+#include "Render/Culling.h"
+#include "Render/OpenGLFunctions.h"
+#include "Utils/Utils.h"
+
+#define MicroBenchmarkQueries 1000                          // Box queries and rays per timed run
+#define MicroBenchmarkMatrices 10000                        // Matrix products and vector transforms per timed run
+#define MicroBenchmarkTolerance 1e-5f                       // Largest kernel difference to the scalar reference, relative to the reference value
+
+// Xorshift, fast and the same everywhere
+static uint32_t NextRandom(uint32_t& io_State) {
+	io_State ^= io_State << 13;
+	io_State ^= io_State >> 17;
+	io_State ^= io_State << 5;
+	return io_State;
+}
+
+// Uniform in [0, 1)
+static float RandomFloat(uint32_t& io_State) {
+	return (NextRandom(io_State) >> 8) * (1.0f / 16777216.0f);
+}
+
+// Box with center in [0, i_Extent)^3 and half size between 0.05 and 0.3
+static AABB RandomBox(uint32_t& io_State, const float i_Extent) {
+	AABB box;
+	for (int axis = 0; axis < 3; ++axis) {
+		const float center = RandomFloat(io_State) * i_Extent;
+		const float half_size = 0.05f + 0.25f * RandomFloat(io_State);
+		box.Min[axis] = center - half_size;
+		box.Max[axis] = center + half_size;
+	}
+	return box;
+}
+
+// Plain loops the SIMD kernels replaced, column-major like Mat4
+static void MultiplyScalar(const float* i_Matrix1, const float* i_Matrix2, float* o_Output) {
+	for (int column = 0; column < 4; ++column) {
+		for (int row = 0; row < 4; ++row) {
+			float sum = 0.0f;
+			for (int k = 0; k < 4; ++k) {
+				sum += i_Matrix1[k * 4 + row] * i_Matrix2[column * 4 + k];
+			}
+			o_Output[column * 4 + row] = sum;
+		}
+	}
+}
+
+static void TransformScalar(const float* i_Matrix, const float* i_Vector, float* o_Output) {
+	for (int row = 0; row < 4; ++row) {
+		o_Output[row] = i_Matrix[row] * i_Vector[0] + i_Matrix[4 + row] * i_Vector[1] + i_Matrix[8 + row] * i_Vector[2] + i_Matrix[12 + row] * i_Vector[3];
+	}
+}
+
+// Rotation of a unit quaternion as a column-major matrix, written out independently of the affine kernels
+static void RotationScalar(const Quat& i_Rotation, float* o_Output) {
+	const float x = i_Rotation.x, y = i_Rotation.y, z = i_Rotation.z, w = i_Rotation.w;
+	GetIdentityMatrix(o_Output);
+	o_Output[0] = 1.0f - 2.0f * (y * y + z * z);
+	o_Output[1] = 2.0f * (x * y + w * z);
+	o_Output[2] = 2.0f * (x * z - w * y);
+	o_Output[4] = 2.0f * (x * y - w * z);
+	o_Output[5] = 1.0f - 2.0f * (x * x + z * z);
+	o_Output[6] = 2.0f * (y * z + w * x);
+	o_Output[8] = 2.0f * (x * z + w * y);
+	o_Output[9] = 2.0f * (y * z - w * x);
+	o_Output[10] = 1.0f - 2.0f * (x * x + y * y);
+}
+
+// T * R * S from the single transform builders and the scalar product
+static Mat4 ComposeScalar(const float* i_Translation, const Quat& i_Rotation, const float* i_Scale) {
+	Mat4 translation, rotation, scale, rotation_scale, result;
+	GetTranslationMatrix(i_Translation[0], i_Translation[1], i_Translation[2], translation.m);
+	RotationScalar(i_Rotation, rotation.m);
+	GetScalingMatrix(i_Scale[0], i_Scale[1], i_Scale[2], scale.m);
+	MultiplyScalar(rotation.m, scale.m, rotation_scale.m);
+	MultiplyScalar(translation.m, rotation_scale.m, result.m);
+	return result;
+}
+
+// Largest difference of i_Count floats, relative to the reference so large values get the same number of significant digits
+static float LargestDifference(const float* i_Values, const float* i_Reference, const size_t i_Count) {
+	float difference = 0.0f;
+	for (size_t i = 0; i < i_Count; ++i) {
+		const float d = fabsf(i_Values[i] - i_Reference[i]) / (1.0f + fabsf(i_Reference[i]));
+		difference = d > difference ? d : difference;
+	}
+	return difference;
+}
+
+MicroBenchmarks::MicroBenchmarks(const char* i_ReportPath) {
+	ReportPath = i_ReportPath ? i_ReportPath : "";
+}
+
+bool MicroBenchmarks::Run(const std::string& i_Suite) {
+	const bool all = i_Suite == "all";
+	bool known = all;
+	bool matching = true;
+	if (all || i_Suite == "matrix") {
+		matching = RunMatrix();
+		known = true;
+	}
+	if (all || i_Suite == "bvh") {
+		RunBVH();
+		known = true;
+	}
+	if (!known) {
+		UtilsInstance->ErrorMessage("Micro Benchmark Error", ("Unknown suite " + i_Suite).c_str());
+		return false;
+	}
+	// Timings are still reported when a kernel is wrong
+	const bool written = WriteReport();
+	return written && matching;
+}
+
+bool MicroBenchmarks::CheckKernel(const std::string& i_Name, const float i_Difference) {
+	const bool matching = i_Difference <= MicroBenchmarkTolerance;
+	std::cout << "  " << i_Name << ": largest difference to scalar reference " << i_Difference << (matching ? "" : " - FAILED") << std::endl;
+	if (!matching) {
+		UtilsInstance->ErrorMessage("Micro Benchmark Error", (i_Name + " differs from the scalar reference").c_str());
+	}
+	return matching;
+}
+
+template<typename Case>
+void MicroBenchmarks::Measure(const std::string& i_Name, const int i_Repetitions, Case i_Case) {
+	typedef std::chrono::steady_clock Clock;
+
+	// One untimed run warms caches and lets lazily grown buffers reach their size
+	i_Case();
+	LogHistogram times;
+	for (int i = 0; i < i_Repetitions; ++i) {
+		const Clock::time_point start = Clock::now();
+		i_Case();
+		times.Add(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+	}
+	Results.emplace_back(i_Name, times);
+}
+
+// Scalar reference against the SSE single product and the batched kernels (AVX2 when compiled with it),
+// every kernel result is checked against the reference and the suite fails when one is off by more than rounding
+bool MicroBenchmarks::RunMatrix() {
+	uint32_t seed = MicroBenchmarkSeed;
+	std::vector<Mat4> left(MicroBenchmarkMatrices), right(MicroBenchmarkMatrices), output(MicroBenchmarkMatrices), reference(MicroBenchmarkMatrices);
+	std::vector<Vec4> vectors(MicroBenchmarkMatrices), transformed(MicroBenchmarkMatrices), transformed_reference(MicroBenchmarkMatrices);
+	for (int i = 0; i < MicroBenchmarkMatrices; ++i) {
+		for (int j = 0; j < 16; ++j) {
+			left[i].m[j] = RandomFloat(seed) * 2.0f - 1.0f;
+			right[i].m[j] = RandomFloat(seed) * 2.0f - 1.0f;
+		}
+		vectors[i] = { RandomFloat(seed), RandomFloat(seed), RandomFloat(seed), 1.0f };
+	}
+	const std::string suffix = "_" + std::to_string(MicroBenchmarkMatrices / 1000) + "k";
+	const size_t matrix_floats = MicroBenchmarkMatrices * 16;
+
+	// Kernels reassociate sums (and fuse them with AVX2), results may only differ by rounding
+	std::cout << "Matrix kernels:" << std::endl;
+	bool matching = true;
+
+	Measure("mat4_multiply_scalar" + suffix, MicroBenchmarkRepetitions, [&]() {
+		for (int i = 0; i < MicroBenchmarkMatrices; ++i) {
+			MultiplyScalar(left[i].m, right[i].m, reference[i].m);
+		}
+	});
+	Measure("mat4_multiply_sse" + suffix, MicroBenchmarkRepetitions, [&]() {
+		for (int i = 0; i < MicroBenchmarkMatrices; ++i) {
+			output[i] = Multiply(left[i], right[i]);
+		}
+	});
+	matching &= CheckKernel("mat4_multiply_sse", LargestDifference(output[0].m, reference[0].m, matrix_floats));
+	Measure("mat4_multiply_batch" + suffix, MicroBenchmarkRepetitions, [&]() {
+		MultiplyN(left.data(), right.data(), output.data(), MicroBenchmarkMatrices);
+	});
+	matching &= CheckKernel("mat4_multiply_batch", LargestDifference(output[0].m, reference[0].m, matrix_floats));
+
+	Measure("mat4_multiply_shared_scalar" + suffix, MicroBenchmarkRepetitions, [&]() {
+		for (int i = 0; i < MicroBenchmarkMatrices; ++i) {
+			MultiplyScalar(left[0].m, right[i].m, reference[i].m);
+		}
+	});
+	Measure("mat4_multiply_shared_batch" + suffix, MicroBenchmarkRepetitions, [&]() {
+		MultiplyN(left[0], right.data(), output.data(), MicroBenchmarkMatrices);
+	});
+	matching &= CheckKernel("mat4_multiply_shared_batch", LargestDifference(output[0].m, reference[0].m, matrix_floats));
+
+	Measure("vec4_transform_scalar" + suffix, MicroBenchmarkRepetitions, [&]() {
+		for (int i = 0; i < MicroBenchmarkMatrices; ++i) {
+			TransformScalar(left[0].m, &vectors[i].x, &transformed_reference[i].x);
+		}
+	});
+	Measure("vec4_transform_batch" + suffix, MicroBenchmarkRepetitions, [&]() {
+		TransformN(left[0], vectors.data(), transformed.data(), MicroBenchmarkMatrices);
+	});
+	matching &= CheckKernel("vec4_transform_batch", LargestDifference(&transformed[0].x, &transformed_reference[0].x, MicroBenchmarkMatrices * 4));
+	for (int i = 0; i < MicroBenchmarkMatrices; ++i) {
+		transformed[i] = Transform(left[0], vectors[i]);
+	}
+	matching &= CheckKernel("vec4_transform_sse", LargestDifference(&transformed[0].x, &transformed_reference[0].x, MicroBenchmarkMatrices * 4));
+
+	// Affine kernels against full matrices built from the single transform builders, one random TRS per matrix
+	float compose_difference[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float inverse_difference[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float affine_multiply_difference = 0.0f;
+	float projection_multiply_difference = 0.0f;
+	const Mat4 identity = Mat4Identity();
+	Affine previous = AffineIdentity();
+	for (int i = 0; i < MicroBenchmarkMatrices; ++i) {
+		const float translation[3] = { RandomFloat(seed) * 2.0f - 1.0f, RandomFloat(seed) * 2.0f - 1.0f, RandomFloat(seed) * 2.0f - 1.0f };
+		const float scale[3] = { 0.5f + 1.5f * RandomFloat(seed), 0.5f + 1.5f * RandomFloat(seed), 0.5f + 1.5f * RandomFloat(seed) };
+		const float uniform_scale[3] = { scale[0], scale[0], scale[0] };
+		const float unit_scale[3] = { 1.0f, 1.0f, 1.0f };
+		const Quat rotation = QuatFromAxisAngle(RandomFloat(seed) * 2.0f - 1.0f, RandomFloat(seed) * 2.0f - 1.0f, RandomFloat(seed) * 2.0f - 1.0f, RandomFloat(seed) * 360.0f);
+
+		const Affine composed[4] = {
+			ComposeTRS<TransformKind::Identity>(translation, rotation, scale),
+			ComposeTRS<TransformKind::RotationOnly>(translation, rotation, scale),
+			ComposeTRS<TransformKind::UniformScale>(translation, rotation, scale),
+			ComposeTRS<TransformKind::General>(translation, rotation, scale)
+		};
+		const Mat4 expected[4] = {
+			identity,
+			ComposeScalar(translation, rotation, unit_scale),
+			ComposeScalar(translation, rotation, uniform_scale),
+			ComposeScalar(translation, rotation, scale)
+		};
+		const Affine inverses[4] = {
+			Inverse<TransformKind::Identity>(composed[0]),
+			Inverse<TransformKind::RotationOnly>(composed[1]),
+			Inverse<TransformKind::UniformScale>(composed[2]),
+			Inverse<TransformKind::General>(composed[3])
+		};
+		for (int kind = 0; kind < 4; ++kind) {
+			const float d = LargestDifference(ToMat4(composed[kind]).m, expected[kind].m, 16);
+			compose_difference[kind] = d > compose_difference[kind] ? d : compose_difference[kind];
+
+			// Inverse times matrix gives identity
+			Mat4 product;
+			MultiplyScalar(ToMat4(inverses[kind]).m, expected[kind].m, product.m);
+			const float e = LargestDifference(product.m, identity.m, 16);
+			inverse_difference[kind] = e > inverse_difference[kind] ? e : inverse_difference[kind];
+		}
+
+		Mat4 product;
+		MultiplyScalar(ToMat4(previous).m, expected[3].m, product.m);
+		const float a = LargestDifference(ToMat4(Multiply(previous, composed[3])).m, product.m, 16);
+		affine_multiply_difference = a > affine_multiply_difference ? a : affine_multiply_difference;
+		previous = composed[3];
+
+		MultiplyScalar(left[i].m, expected[3].m, product.m);
+		const float b = LargestDifference(Multiply(left[i], composed[3]).m, product.m, 16);
+		projection_multiply_difference = b > projection_multiply_difference ? b : projection_multiply_difference;
+	}
+	static const char* kinds[] = { "identity", "rotation_only", "uniform_scale", "general" };
+	for (int kind = 0; kind < 4; ++kind) {
+		matching &= CheckKernel(std::string("affine_compose_trs_") + kinds[kind], compose_difference[kind]);
+		matching &= CheckKernel(std::string("affine_inverse_") + kinds[kind], inverse_difference[kind]);
+	}
+	matching &= CheckKernel("affine_multiply", affine_multiply_difference);
+	matching &= CheckKernel("mat4_affine_multiply", projection_multiply_difference);
+	return matching;
+}
+
+// Binned SAH build, frustum query against the flat SIMD test, box queries, rays and refits over growing box counts
+void MicroBenchmarks::RunBVH() {
+	static const size_t counts[] = { 1000, 10000, 100000, 1000000 };
+	for (const size_t count : counts) {
+		// Scene volume grows with the count, so box density and box sizes stay the same
+		const float extent = 10.0f * cbrtf((float)count / 1000.0f);
+		const int repetitions = count >= 1000000 ? MicroBenchmarkRepetitions / 4 : MicroBenchmarkRepetitions;
+		const std::string suffix = "_" + std::to_string(count / 1000) + "k";
+		uint32_t seed = MicroBenchmarkSeed;
+
+		std::vector<AABB> boxes(count);
+		for (size_t i = 0; i < count; ++i) {
+			boxes[i] = RandomBox(seed, extent);
+		}
+
+		BVH hierarchy;
+		Measure("bvh_build" + suffix, repetitions, [&]() { hierarchy.Build(boxes.data(), count); });
+
+		// Camera in front of the scene looking into it along -Z
+		Mat4 projection;
+		GetPerspectiveProjectionMatrix(45.0f, 1.0f, 2.0f * extent, 16.0f / 9.0f, projection.m);
+		const float camera[3] = { -0.5f * extent, -0.5f * extent, -1.1f * extent };
+		const Affine view = ComposeTRS<TransformKind::RotationOnly>(camera, QuatIdentity(), nullptr);
+		Frustum frustum;
+		ExtractFrustumPlanes(Multiply(projection, view), frustum);
+
+		std::vector<unsigned char> visible(count);
+		CullingStats stats;
+		Measure("bvh_frustum" + suffix, repetitions, [&]() { hierarchy.QueryFrustum(frustum, visible.data(), stats); });
+		BoxSoA flat;
+		flat.Resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			flat.Set(i, boxes[i]);
+		}
+		Measure("flat_frustum" + suffix, repetitions, [&]() { CullBoxes(frustum, flat, visible.data(), stats); });
+
+		std::vector<AABB> queries(MicroBenchmarkQueries);
+		std::vector<float> rays(MicroBenchmarkQueries * 6);
+		for (int i = 0; i < MicroBenchmarkQueries; ++i) {
+			queries[i] = RandomBox(seed, extent);
+			float* ray = &rays[i * 6];
+			float length = 0.0f;
+			for (int axis = 0; axis < 3; ++axis) {
+				ray[axis] = RandomFloat(seed) * extent;
+				ray[3 + axis] = RandomFloat(seed) * 2.0f - 1.0f;
+				length += ray[3 + axis] * ray[3 + axis];
+			}
+			length = length > 0.0f ? sqrtf(length) : 1.0f;
+			for (int axis = 0; axis < 3; ++axis) {
+				ray[3 + axis] /= length;
+			}
+		}
+		std::vector<int> found;
+		found.reserve(count);
+		Measure("bvh_aabb_queries" + suffix, repetitions, [&]() {
+			for (int i = 0; i < MicroBenchmarkQueries; ++i) {
+				found.clear();
+				hierarchy.QueryAABB(queries[i], found);
+			}
+		});
+		Measure("bvh_raycasts" + suffix, repetitions, [&]() {
+			int primitive;
+			float distance;
+			for (int i = 0; i < MicroBenchmarkQueries; ++i) {
+				hierarchy.Raycast(&rays[i * 6], &rays[i * 6 + 3], extent, primitive, distance);
+			}
+		});
+
+		// Every hundredth box moves, partial refit climbs from their leaves only
+		std::vector<AABB> moved(boxes);
+		std::vector<int> changed;
+		for (size_t i = 0; i < count; i += 100) {
+			for (int axis = 0; axis < 3; ++axis) {
+				moved[i].Min[axis] += 0.5f;
+				moved[i].Max[axis] += 0.5f;
+			}
+			changed.push_back((int)i);
+		}
+		Measure("bvh_refit_1pct" + suffix, repetitions, [&]() { hierarchy.Refit(moved.data(), changed.data(), changed.size()); });
+		Measure("bvh_refit_full" + suffix, repetitions, [&]() { hierarchy.Refit(moved.data()); });
+	}
+}
+
+bool MicroBenchmarks::WriteReport() const {
+	std::cout << "Micro benchmarks (ms per run):" << std::endl;
+	for (size_t i = 0; i < Results.size(); ++i) {
+		const LogHistogram& times = Results[i].second;
+		std::cout << "  " << Results[i].first << ": mean " << times.Mean() << ", p50 " << times.Percentile(50)
+			<< ", p95 " << times.Percentile(95) << ", min " << times.Min() << ", max " << times.Max() << std::endl;
+	}
+
+	if (ReportPath.empty()) {
+		return true;
+	}
+
+	std::ofstream report(ReportPath.c_str());
+	if (!report) {
+		UtilsInstance->ErrorMessage("Benchmark Report Error", ReportPath.c_str());
+		return false;
+	}
+
+	const bool csv = ReportPath.size() >= 4 && ReportPath.compare(ReportPath.size() - 4, 4, ".csv") == 0;
+	if (csv) {
+		report << "metric,samples,mean,p50,p95,min,max" << std::endl;
+		for (size_t i = 0; i < Results.size(); ++i) {
+			const LogHistogram& times = Results[i].second;
+			report << Results[i].first << "," << times.Count() << "," << times.Mean() << "," << times.Percentile(50) << ","
+				<< times.Percentile(95) << "," << times.Min() << "," << times.Max() << std::endl;
+		}
+	}
+	else {
+		report << "{" << std::endl;
+		report << "  \"metrics\": {" << std::endl;
+		for (size_t i = 0; i < Results.size(); ++i) {
+			const LogHistogram& times = Results[i].second;
+			report << "    \"" << Results[i].first << "\": { \"samples\": " << times.Count() << ", \"mean\": " << times.Mean()
+				<< ", \"p50\": " << times.Percentile(50) << ", \"p95\": " << times.Percentile(95)
+				<< ", \"min\": " << times.Min() << ", \"max\": " << times.Max() << " }"
+				<< (i + 1 < Results.size() ? "," : "") << std::endl;
+		}
+		report << "  }" << std::endl;
+		report << "}" << std::endl;
+	}
+	return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "Utils/Histogram.h"
+
+// Micro benchmark predifinitions
+#define MicroBenchmarkRepetitions 20                        // Timed runs of every case, fewer for the largest inputs
+#define MicroBenchmarkSeed 0x2545F491u                      // Inputs are generated, the same seed gives the same data on every run
+
+// CPU kernels timed in isolation, no window or GL context is needed
+// Suites: "matrix" (scalar reference against SIMD matrix kernels), "bvh" (build, refit and queries over 1k to 1M boxes), "all"
+// Every case is reported like benchmark metrics, in milliseconds per run
+class MicroBenchmarks {
+
+public:
+	explicit MicroBenchmarks(const char* i_ReportPath);
+
+	// Run given suite, false for an unknown suite, a kernel result off the scalar reference or when the report could not be written
+	bool Run(const std::string& i_Suite);
+
+private:
+	// False when a SIMD kernel differs from the scalar reference by more than MicroBenchmarkTolerance
+	bool RunMatrix();
+	void RunBVH();
+
+	// Time i_Repetitions calls of i_Case under given metric name
+	template<typename Case>
+	void Measure(const std::string& i_Name, const int i_Repetitions, Case i_Case);
+
+	// Print largest difference of a kernel, report and return false when it is above tolerance
+	bool CheckKernel(const std::string& i_Name, const float i_Difference);
+
+	bool WriteReport() const;
+
+	std::string     ReportPath;                             // Output file, .json or .csv, empty prints only
+	std::vector<std::pair<std::string, LogHistogram>> Results;
+};
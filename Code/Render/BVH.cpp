@@ -0,0 +1,485 @@
+#include <algorithm>
+#include "BVH.h"
+
+#define BVH_BIN_COUNT 16
+#define BVH_MAX_LEAF_SIZE 4
+#define BVH_STACK_SIZE 64
+#define BVH_MAX_DEPTH (BVH_STACK_SIZE - 1)                      // Deeper nodes become leaves, so traversal never needs more than the fixed stack
+#define BVH_TRAVERSAL_COST 1.0f                                 // Cost of visiting a node relative to testing one primitive
+
+static const float BVHInfinity = 1e30f;
+
+static void ResetAABB(AABB& o_Box) {
+    for (int i = 0; i < 3; ++i) {
+        o_Box.Min[i] = BVHInfinity;
+        o_Box.Max[i] = -BVHInfinity;
+    }
+}
+
+// Inlined ExpandAABB for the build loops
+static inline void Grow(AABB& io_Box, const AABB& i_Other) {
+    for (int i = 0; i < 3; ++i) {
+        io_Box.Min[i] = i_Other.Min[i] < io_Box.Min[i] ? i_Other.Min[i] : io_Box.Min[i];
+        io_Box.Max[i] = i_Other.Max[i] > io_Box.Max[i] ? i_Other.Max[i] : io_Box.Max[i];
+    }
+}
+
+// Half of the surface area - constant factor does not matter for SAH
+static float HalfArea(const AABB& i_Box) {
+    const float dx = i_Box.Max[0] - i_Box.Min[0];
+    const float dy = i_Box.Max[1] - i_Box.Min[1];
+    const float dz = i_Box.Max[2] - i_Box.Min[2];
+    return dx * dy + dy * dz + dz * dx;
+}
+
+static bool Overlaps(const AABB& i_A, const AABB& i_B) {
+    for (int i = 0; i < 3; ++i) {
+        if (i_A.Max[i] < i_B.Min[i] || i_A.Min[i] > i_B.Max[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Slab test, returns entry distance or BVHInfinity when missed
+static float IntersectRay(const AABB& i_Box, const float* i_Origin, const float* i_InvDirection, const float i_MaxDistance) {
+    float t_min = 0.0f;
+    float t_max = i_MaxDistance;
+    for (int i = 0; i < 3; ++i) {
+        float t0 = (i_Box.Min[i] - i_Origin[i]) * i_InvDirection[i];
+        float t1 = (i_Box.Max[i] - i_Origin[i]) * i_InvDirection[i];
+        if (t0 > t1) {
+            std::swap(t0, t1);
+        }
+        t_min = t0 > t_min ? t0 : t_min;
+        t_max = t1 < t_max ? t1 : t_max;
+        if (t_min > t_max) {
+            return BVHInfinity;
+        }
+    }
+    return t_min;
+}
+
+void BVH::Build(const AABB* i_Boxes, const size_t i_Count) {
+    Boxes.resize(i_Count);
+    Indices.resize(i_Count);
+    SlotOf.resize(i_Count);
+    LeafOf.assign(i_Count, 0);
+    References.resize(i_Count);
+    Nodes.clear();
+
+    for (size_t i = 0; i < i_Count; ++i) {
+        References[i].Box = i_Boxes[i];
+        References[i].Primitive = (int)i;
+        for (int axis = 0; axis < 3; ++axis) {
+            References[i].Centroid[axis] = (i_Boxes[i].Min[axis] + i_Boxes[i].Max[axis]) * 0.5f;
+        }
+    }
+
+    if (i_Count == 0) {
+        return;
+    }
+
+    // Upper bound of node count for leaves with at least one primitive
+    Nodes.reserve(2 * i_Count);
+
+    BVHNode root;
+    root.First = 0;
+    root.Count = (int)i_Count;
+    Nodes.push_back(root);
+    ResetAABB(Nodes[0].Bounds);
+    for (size_t i = 0; i < i_Count; ++i) {
+        Grow(Nodes[0].Bounds, i_Boxes[i]);
+    }
+    Subdivide(0, 0);
+
+    for (size_t i = 0; i < i_Count; ++i) {
+        Indices[i] = References[i].Primitive;
+        SlotOf[Indices[i]] = (int)i;
+        Boxes[i] = References[i].Box;
+    }
+    NodeDirty.assign(Nodes.size(), 0);
+    DirtyNodes.clear();
+    DirtyNodes.reserve(Nodes.size());
+
+    // References are only needed while building
+    References.clear();
+    References.shrink_to_fit();
+}
+
+void BVH::UpdateNodeBounds(const int i_Node) {
+    BVHNode& node = Nodes[i_Node];
+
+    if (node.Left >= 0) {
+        node.Bounds = Nodes[node.Left].Bounds;
+        Grow(node.Bounds, Nodes[node.Left + 1].Bounds);
+        return;
+    }
+
+    ResetAABB(node.Bounds);
+    for (int i = node.First; i < node.First + node.Count; ++i) {
+        Grow(node.Bounds, Boxes[i]);
+    }
+}
+
+void BVH::Subdivide(const int i_Node, const int i_Depth) {
+    const int first = Nodes[i_Node].First;
+    const int count = Nodes[i_Node].Count;
+
+    // Depth limit keeps degenerate inputs traversable with fixed stacks, such leaves just hold more primitives
+    if (count <= 1 || i_Depth >= BVH_MAX_DEPTH) {
+        for (int i = first; i < first + count; ++i) {
+            LeafOf[References[i].Primitive] = i_Node;
+        }
+        return;
+    }
+
+    // Bounds of primitive centers - bins are spread over them
+    AABB centroid_bounds;
+    ResetAABB(centroid_bounds);
+    for (int i = first; i < first + count; ++i) {
+        for (int axis = 0; axis < 3; ++axis) {
+            const float c = References[i].Centroid[axis];
+            centroid_bounds.Min[axis] = c < centroid_bounds.Min[axis] ? c : centroid_bounds.Min[axis];
+            centroid_bounds.Max[axis] = c > centroid_bounds.Max[axis] ? c : centroid_bounds.Max[axis];
+        }
+    }
+
+    // Binned SAH - evaluate BVH_BIN_COUNT - 1 split planes per axis
+    // All three axes are binned in one pass so every primitive is fetched once per level
+    float scale[3];
+    AABB bin_bounds[3][BVH_BIN_COUNT];
+    int bin_count[3][BVH_BIN_COUNT] = { { 0 } };
+    for (int axis = 0; axis < 3; ++axis) {
+        const float extent = centroid_bounds.Max[axis] - centroid_bounds.Min[axis];
+        scale[axis] = extent > 0.0f ? BVH_BIN_COUNT / extent : 0.0f;
+        for (int bin = 0; bin < BVH_BIN_COUNT; ++bin) {
+            ResetAABB(bin_bounds[axis][bin]);
+        }
+    }
+
+    for (int i = first; i < first + count; ++i) {
+        const BuildReference& reference = References[i];
+        const AABB& box = reference.Box;
+        for (int axis = 0; axis < 3; ++axis) {
+            int bin = (int)((reference.Centroid[axis] - centroid_bounds.Min[axis]) * scale[axis]);
+            bin = bin < BVH_BIN_COUNT - 1 ? bin : BVH_BIN_COUNT - 1;
+            bin_count[axis][bin]++;
+            Grow(bin_bounds[axis][bin], box);
+        }
+    }
+
+    float best_cost = BVHInfinity;
+    int best_axis = -1;
+    int best_split = 0;
+
+    for (int axis = 0; axis < 3; ++axis) {
+        if (scale[axis] == 0.0f) {
+            continue;
+        }
+
+        // Sweep from both sides collecting areas and counts of every split
+        float left_area[BVH_BIN_COUNT - 1], right_area[BVH_BIN_COUNT - 1];
+        int left_count[BVH_BIN_COUNT - 1], right_count[BVH_BIN_COUNT - 1];
+        AABB left_box, right_box;
+        ResetAABB(left_box);
+        ResetAABB(right_box);
+        int left_sum = 0, right_sum = 0;
+
+        for (int i = 0; i < BVH_BIN_COUNT - 1; ++i) {
+            left_sum += bin_count[axis][i];
+            left_count[i] = left_sum;
+            if (bin_count[axis][i] > 0) Grow(left_box, bin_bounds[axis][i]);
+            left_area[i] = left_sum > 0 ? HalfArea(left_box) : 0.0f;
+
+            const int j = BVH_BIN_COUNT - 1 - i;
+            right_sum += bin_count[axis][j];
+            right_count[j - 1] = right_sum;
+            if (bin_count[axis][j] > 0) Grow(right_box, bin_bounds[axis][j]);
+            right_area[j - 1] = right_sum > 0 ? HalfArea(right_box) : 0.0f;
+        }
+
+        for (int i = 0; i < BVH_BIN_COUNT - 1; ++i) {
+            if (left_count[i] == 0 || right_count[i] == 0) {
+                continue;
+            }
+            const float cost = left_count[i] * left_area[i] + right_count[i] * right_area[i];
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_axis = axis;
+                best_split = i;
+            }
+        }
+    }
+
+    // Keep small nodes as leaves when splitting does not pay off
+    const float parent_area = HalfArea(Nodes[i_Node].Bounds);
+    const float split_cost = parent_area > 0.0f ? BVH_TRAVERSAL_COST + best_cost / parent_area : BVHInfinity;
+    if (count <= BVH_MAX_LEAF_SIZE && (best_axis < 0 || split_cost >= (float)count)) {
+        for (int i = first; i < first + count; ++i) {
+            LeafOf[References[i].Primitive] = i_Node;
+        }
+        return;
+    }
+
+    int middle;
+    if (best_axis >= 0) {
+        const float axis_scale = scale[best_axis];
+        const float axis_min = centroid_bounds.Min[best_axis];
+        BuildReference* split = std::partition(&References[first], &References[first] + count, [&](const BuildReference& i_Reference) {
+            int bin = (int)((i_Reference.Centroid[best_axis] - axis_min) * axis_scale);
+            return (bin < BVH_BIN_COUNT - 1 ? bin : BVH_BIN_COUNT - 1) <= best_split;
+        });
+        middle = (int)(split - &References[0]);
+    }
+    else {
+        // All centers coincide - split in half
+        middle = first + count / 2;
+    }
+
+    const int left = (int)Nodes.size();
+    Nodes.emplace_back();
+    Nodes.emplace_back();
+
+    Nodes[left].First = first;
+    Nodes[left].Count = middle - first;
+    Nodes[left].Parent = i_Node;
+    Nodes[left + 1].First = middle;
+    Nodes[left + 1].Count = first + count - middle;
+    Nodes[left + 1].Parent = i_Node;
+    Nodes[i_Node].Left = left;
+
+    for (int child = left; child <= left + 1; ++child) {
+        ResetAABB(Nodes[child].Bounds);
+        for (int i = Nodes[child].First; i < Nodes[child].First + Nodes[child].Count; ++i) {
+            Grow(Nodes[child].Bounds, References[i].Box);
+        }
+    }
+    Subdivide(left, i_Depth + 1);
+    Subdivide(left + 1, i_Depth + 1);
+}
+
+void BVH::Refit(const AABB* i_Boxes) {
+    for (size_t i = 0; i < Boxes.size(); ++i) {
+        Boxes[i] = i_Boxes[Indices[i]];
+    }
+
+    // Children always have higher indices than parents
+    for (int i = (int)Nodes.size() - 1; i >= 0; --i) {
+        UpdateNodeBounds(i);
+    }
+}
+
+void BVH::Refit(const AABB* i_Boxes, const int* i_Changed, const size_t i_ChangedCount) {
+    // Collect changed leaves and ancestors, stop climbing at nodes already collected
+    std::vector<int>& dirty = DirtyNodes;
+    dirty.clear();
+    for (size_t i = 0; i < i_ChangedCount; ++i) {
+        const int primitive = i_Changed[i];
+        Boxes[SlotOf[primitive]] = i_Boxes[primitive];
+
+        for (int node = LeafOf[primitive]; node >= 0 && !NodeDirty[node]; node = Nodes[node].Parent) {
+            NodeDirty[node] = 1;
+            dirty.push_back(node);
+        }
+    }
+
+    // Deepest nodes first
+    std::sort(dirty.begin(), dirty.end(), std::greater<int>());
+    for (size_t i = 0; i < dirty.size(); ++i) {
+        UpdateNodeBounds(dirty[i]);
+        NodeDirty[dirty[i]] = 0;
+    }
+}
+
+void BVH::AcceptSubtree(const int i_Node, unsigned char* o_Visible) const {
+    // Subtree primitives are one contiguous range of the index list
+    const BVHNode& node = Nodes[i_Node];
+    for (int i = node.First; i < node.First + node.Count; ++i) {
+        o_Visible[Indices[i]] = 1;
+    }
+}
+
+// Plane with offsets of the box corners furthest along and against its normal,
+// boxes are read as float[6] ( Min, Max ) so the corner selection needs no branches
+struct FrustumPlane {
+    float           Normal[3];
+    float           Distance;
+    int             Far[3];
+    int             Near[3];
+};
+
+void BVH::QueryFrustum(const Frustum& i_Frustum, unsigned char* o_Visible, CullingStats& io_Stats) const {
+    const uint32_t total = (uint32_t)Boxes.size();
+    std::fill(o_Visible, o_Visible + total, 0);
+    io_Stats.Tested += total;
+
+    if (Nodes.empty()) {
+        io_Stats.Culled += total;
+        return;
+    }
+
+    FrustumPlane planes[6];
+    for (int plane = 0; plane < 6; ++plane) {
+        const float* p = i_Frustum.Planes[plane];
+        for (int i = 0; i < 3; ++i) {
+            planes[plane].Normal[i] = p[i];
+            planes[plane].Far[i] = p[i] > 0.0f ? 3 + i : i;
+            planes[plane].Near[i] = p[i] > 0.0f ? i : 3 + i;
+        }
+        planes[plane].Distance = p[3];
+    }
+
+    uint32_t drawn = 0;
+    uint32_t visited = 0;
+
+    // Node index and mask of planes the node still straddles
+    int node_stack[BVH_STACK_SIZE];
+    int mask_stack[BVH_STACK_SIZE];
+    int stack_size = 0;
+    node_stack[stack_size] = 0;
+    mask_stack[stack_size++] = 0x3F;
+
+    while (stack_size > 0) {
+        const int index = node_stack[--stack_size];
+        int mask = mask_stack[stack_size];
+        const BVHNode& node = Nodes[index];
+        const float* bounds = node.Bounds.Min;
+        visited++;
+
+        // Only planes the parent straddled are tested
+        int outside = 0;
+        const int tested = mask;
+        for (int plane = 0; plane < 6; ++plane) {
+            if (!(tested & (1 << plane))) {
+                continue;
+            }
+            const FrustumPlane& p = planes[plane];
+            const float far_distance = p.Distance + p.Normal[0] * bounds[p.Far[0]] + p.Normal[1] * bounds[p.Far[1]] + p.Normal[2] * bounds[p.Far[2]];
+            const float near_distance = p.Distance + p.Normal[0] * bounds[p.Near[0]] + p.Normal[1] * bounds[p.Near[1]] + p.Normal[2] * bounds[p.Near[2]];
+            outside |= far_distance < 0.0f;
+            // Fully on inner side - children need no test against this plane
+            mask &= near_distance >= 0.0f ? ~(1 << plane) : ~0;
+        }
+
+        if (outside) {
+            continue;
+        }
+        if (mask == 0) {
+            AcceptSubtree(index, o_Visible);
+            drawn += node.Count;
+            continue;
+        }
+
+        if (node.Left < 0) {
+            // Leaf boxes are stored in index list order, so this reads memory sequentially
+            for (int i = node.First; i < node.First + node.Count; ++i) {
+                const float* box = Boxes[i].Min;
+                int box_outside = 0;
+                for (int plane = 0; plane < 6; ++plane) {
+                    if (!(mask & (1 << plane))) {
+                        continue;
+                    }
+                    const FrustumPlane& p = planes[plane];
+                    box_outside |= p.Distance + p.Normal[0] * box[p.Far[0]] + p.Normal[1] * box[p.Far[1]] + p.Normal[2] * box[p.Far[2]] < 0.0f;
+                }
+                o_Visible[Indices[i]] = (unsigned char)(box_outside ^ 1);
+                drawn += box_outside ^ 1;
+            }
+            continue;
+        }
+
+        if (stack_size + 2 > BVH_STACK_SIZE) {
+            // Too deep for the fixed stack - accept conservatively
+            AcceptSubtree(index, o_Visible);
+            drawn += node.Count;
+            continue;
+        }
+        node_stack[stack_size] = node.Left;
+        mask_stack[stack_size++] = mask;
+        node_stack[stack_size] = node.Left + 1;
+        mask_stack[stack_size++] = mask;
+    }
+
+    io_Stats.Drawn += drawn;
+    io_Stats.Culled += total - drawn;
+    io_Stats.NodesVisited += visited;
+}
+
+void BVH::QueryAABB(const AABB& i_Box, std::vector<int>& o_Primitives) const {
+    if (Nodes.empty()) {
+        return;
+    }
+
+    // Tree depth is limited to the stack size, every pop makes room for the two children
+    int stack[BVH_STACK_SIZE];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0) {
+        const BVHNode& node = Nodes[stack[--stack_size]];
+
+        if (!Overlaps(node.Bounds, i_Box)) {
+            continue;
+        }
+        if (node.Left < 0) {
+            for (int i = node.First; i < node.First + node.Count; ++i) {
+                if (Overlaps(Boxes[i], i_Box)) {
+                    o_Primitives.push_back(Indices[i]);
+                }
+            }
+            continue;
+        }
+        stack[stack_size++] = node.Left;
+        stack[stack_size++] = node.Left + 1;
+    }
+}
+
+bool BVH::Raycast(const float* i_Origin, const float* i_Direction, float i_MaxDistance, int& o_Primitive, float& o_Distance) const {
+    if (Nodes.empty()) {
+        return false;
+    }
+
+    float inv_direction[3];
+    for (int i = 0; i < 3; ++i) {
+        inv_direction[i] = i_Direction[i] != 0.0f ? 1.0f / i_Direction[i] : BVHInfinity;
+    }
+
+    o_Primitive = -1;
+    float nearest = i_MaxDistance;
+
+    int stack[BVH_STACK_SIZE];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0) {
+        const BVHNode& node = Nodes[stack[--stack_size]];
+
+        if (IntersectRay(node.Bounds, i_Origin, inv_direction, nearest) >= BVHInfinity) {
+            continue;
+        }
+        if (node.Left < 0) {
+            for (int i = node.First; i < node.First + node.Count; ++i) {
+                const float distance = IntersectRay(Boxes[i], i_Origin, inv_direction, nearest);
+                if (distance < nearest) {
+                    nearest = distance;
+                    o_Primitive = Indices[i];
+                }
+            }
+            continue;
+        }
+
+        // Visit the nearer child first so the far one is more likely rejected
+        const float left = IntersectRay(Nodes[node.Left].Bounds, i_Origin, inv_direction, nearest);
+        const float right = IntersectRay(Nodes[node.Left + 1].Bounds, i_Origin, inv_direction, nearest);
+        if (left <= right) {
+            if (right < BVHInfinity) stack[stack_size++] = node.Left + 1;
+            if (left < BVHInfinity) stack[stack_size++] = node.Left;
+        }
+        else {
+            if (left < BVHInfinity) stack[stack_size++] = node.Left;
+            if (right < BVHInfinity) stack[stack_size++] = node.Left + 1;
+        }
+    }
+
+    o_Distance = nearest;
+    return o_Primitive >= 0;
+}
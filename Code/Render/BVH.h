@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include "Culling.h"
+
+// BVH node, children of an inner node are stored next to each other (Left, Left + 1)
+// and always after their parent so a reverse sweep visits children before parents
+struct BVHNode {
+	AABB            Bounds;
+	int             Left = -1;                                  // First child of inner node, -1 for leaves
+	int             First = 0;                                  // First entry of the subtree in primitive index list
+	int             Count = 0;                                  // Number of primitives in the subtree (contiguous entries)
+	int             Parent = -1;                                // Parent node, -1 for root
+};
+
+// Primitive box and center moved together while partitioning so the build reads memory sequentially
+struct BuildReference {
+	AABB            Box;
+	float           Centroid[3];
+	int             Primitive;
+};
+
+// Bounding volume hierarchy over primitive boxes, built with binned SAH
+class BVH {
+
+public:
+	// Build hierarchy over given boxes, primitive IDs are indices into i_Boxes
+	void Build(const AABB* i_Boxes, const size_t i_Count);
+
+	// Refit every node bottom-up after boxes moved (topology is kept)
+	void Refit(const AABB* i_Boxes);
+
+	// Refit only leaves containing changed primitives and their ancestors
+	void Refit(const AABB* i_Boxes, const int* i_Changed, const size_t i_ChangedCount);
+
+	// Mark primitives intersecting frustum in o_Visible (one byte per primitive),
+	// subtrees outside of a plane are rejected and fully inside subtrees are accepted without tests
+	void QueryFrustum(const Frustum& i_Frustum, unsigned char* o_Visible, CullingStats& io_Stats) const;
+
+	// Primitives whose boxes overlap given box
+	void QueryAABB(const AABB& i_Box, std::vector<int>& o_Primitives) const;
+
+	// Nearest primitive box hit by ray, returns false if nothing was hit
+	bool Raycast(const float* i_Origin, const float* i_Direction, float i_MaxDistance, int& o_Primitive, float& o_Distance) const;
+
+	size_t NodeCount() const { return Nodes.size(); }
+	size_t PrimitiveCount() const { return Boxes.size(); }
+
+private:
+	std::vector<BVHNode>        Nodes;
+	std::vector<int>            Indices;                    // Primitive IDs referenced by leaves
+	std::vector<int>            LeafOf;                     // Leaf node holding each primitive
+	std::vector<int>            SlotOf;                     // Position of each primitive in the index list
+	std::vector<AABB>           Boxes;                      // Copy of primitive boxes in index list order, so leaf tests read sequentially
+	std::vector<BuildReference> References;                 // Build-time primitive data, partitioned in place
+	std::vector<unsigned char>  NodeDirty;                  // Refit scratch flags
+	std::vector<int>            DirtyNodes;                 // Refit scratch list, reserved for every node so refits never allocate
+
+	void Subdivide(const int i_Node, const int i_Depth);
+	void UpdateNodeBounds(const int i_Node);
+	void AcceptSubtree(const int i_Node, unsigned char* o_Visible) const;
+};
@@ -0,0 +1,156 @@
+#include <cmath>
+#include <immintrin.h>
+#include "Culling.h"
+
+#define BOX_PADDING 8
+
+void BoxSoA::Resize(const size_t i_Count) {
+    Count = i_Count;
+
+    // Padding boxes are huge so they never get culled, results past Count are ignored anyway
+    const size_t padded = (i_Count + BOX_PADDING - 1) / BOX_PADDING * BOX_PADDING;
+    CenterX.assign(padded, 0.0f);
+    CenterY.assign(padded, 0.0f);
+    CenterZ.assign(padded, 0.0f);
+    ExtentX.assign(padded, 1e30f);
+    ExtentY.assign(padded, 1e30f);
+    ExtentZ.assign(padded, 1e30f);
+}
+
+void BoxSoA::Set(const size_t i_Index, const AABB& i_Box) {
+    CenterX[i_Index] = (i_Box.Max[0] + i_Box.Min[0]) * 0.5f;
+    CenterY[i_Index] = (i_Box.Max[1] + i_Box.Min[1]) * 0.5f;
+    CenterZ[i_Index] = (i_Box.Max[2] + i_Box.Min[2]) * 0.5f;
+    ExtentX[i_Index] = (i_Box.Max[0] - i_Box.Min[0]) * 0.5f;
+    ExtentY[i_Index] = (i_Box.Max[1] - i_Box.Min[1]) * 0.5f;
+    ExtentZ[i_Index] = (i_Box.Max[2] - i_Box.Min[2]) * 0.5f;
+}
+
+void ExtractFrustumPlanes(const Mat4& i_Matrix, Frustum& o_Frustum) {
+    const float* m = i_Matrix.m;
+
+    for (int plane = 0; plane < 6; ++plane) {
+        // Plane = row 3 +/- row (plane / 2)
+        const int row = plane / 2;
+        const float sign = (plane % 2 == 0) ? 1.0f : -1.0f;
+
+        float* p = o_Frustum.Planes[plane];
+        for (int column = 0; column < 4; ++column) {
+            p[column] = m[column * 4 + 3] + sign * m[column * 4 + row];
+        }
+
+        const float length = sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+        if (length > 0.0f) {
+            for (int i = 0; i < 4; ++i) {
+                p[i] /= length;
+            }
+        }
+    }
+}
+
+AABB TransformAABB(const AABB& i_Box, const Affine& i_Matrix) {
+    AABB result;
+    for (int row = 0; row < 3; ++row) {
+        const float* r = &i_Matrix.m[row * 4];
+        result.Min[row] = result.Max[row] = r[3];
+        for (int column = 0; column < 3; ++column) {
+            const float a = r[column] * i_Box.Min[column];
+            const float b = r[column] * i_Box.Max[column];
+            result.Min[row] += a < b ? a : b;
+            result.Max[row] += a < b ? b : a;
+        }
+    }
+    return result;
+}
+
+void ExpandAABB(AABB& io_Box, const AABB& i_Other) {
+    for (int i = 0; i < 3; ++i) {
+        io_Box.Min[i] = i_Other.Min[i] < io_Box.Min[i] ? i_Other.Min[i] : io_Box.Min[i];
+        io_Box.Max[i] = i_Other.Max[i] > io_Box.Max[i] ? i_Other.Max[i] : io_Box.Max[i];
+    }
+}
+
+bool IsOutside(const Frustum& i_Frustum, const AABB& i_Box) {
+    for (int plane = 0; plane < 6; ++plane) {
+        const float* p = i_Frustum.Planes[plane];
+        // Distance of the box corner furthest along plane normal
+        float distance = p[3];
+        for (int i = 0; i < 3; ++i) {
+            distance += p[i] * (p[i] > 0.0f ? i_Box.Max[i] : i_Box.Min[i]);
+        }
+        if (distance < 0.0f) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Box is outside when for some plane: n . c + |n| . e + d < 0
+void CullBoxes(const Frustum& i_Frustum, const BoxSoA& i_Boxes, unsigned char* o_Visible, CullingStats& io_Stats) {
+    const size_t count = i_Boxes.Size();
+    uint32_t visible_count = 0;
+
+#if defined(__AVX__)
+    for (size_t i = 0; i < count; i += 8) {
+        const __m256 cx = _mm256_loadu_ps(&i_Boxes.CenterX[i]);
+        const __m256 cy = _mm256_loadu_ps(&i_Boxes.CenterY[i]);
+        const __m256 cz = _mm256_loadu_ps(&i_Boxes.CenterZ[i]);
+        const __m256 ex = _mm256_loadu_ps(&i_Boxes.ExtentX[i]);
+        const __m256 ey = _mm256_loadu_ps(&i_Boxes.ExtentY[i]);
+        const __m256 ez = _mm256_loadu_ps(&i_Boxes.ExtentZ[i]);
+
+        __m256 outside = _mm256_setzero_ps();
+        for (int plane = 0; plane < 6; ++plane) {
+            const float* p = i_Frustum.Planes[plane];
+            __m256 distance = _mm256_set1_ps(p[3]);
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(p[0]), cx));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(p[1]), cy));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(p[2]), cz));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(fabs(p[0])), ex));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(fabs(p[1])), ey));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(fabs(p[2])), ez));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_LT_OQ));
+        }
+
+        const int mask = _mm256_movemask_ps(outside);
+        const size_t lanes = count - i < 8 ? count - i : 8;
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            o_Visible[i + lane] = (mask >> lane) & 1 ? 0 : 1;
+            visible_count += o_Visible[i + lane];
+        }
+    }
+#else
+    for (size_t i = 0; i < count; i += 4) {
+        const __m128 cx = _mm_loadu_ps(&i_Boxes.CenterX[i]);
+        const __m128 cy = _mm_loadu_ps(&i_Boxes.CenterY[i]);
+        const __m128 cz = _mm_loadu_ps(&i_Boxes.CenterZ[i]);
+        const __m128 ex = _mm_loadu_ps(&i_Boxes.ExtentX[i]);
+        const __m128 ey = _mm_loadu_ps(&i_Boxes.ExtentY[i]);
+        const __m128 ez = _mm_loadu_ps(&i_Boxes.ExtentZ[i]);
+
+        __m128 outside = _mm_setzero_ps();
+        for (int plane = 0; plane < 6; ++plane) {
+            const float* p = i_Frustum.Planes[plane];
+            __m128 distance = _mm_set1_ps(p[3]);
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(p[0]), cx));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(p[1]), cy));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(p[2]), cz));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(fabs(p[0])), ex));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(fabs(p[1])), ey));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(fabs(p[2])), ez));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+        }
+
+        const int mask = _mm_movemask_ps(outside);
+        const size_t lanes = count - i < 4 ? count - i : 4;
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            o_Visible[i + lane] = (mask >> lane) & 1 ? 0 : 1;
+            visible_count += o_Visible[i + lane];
+        }
+    }
+#endif
+
+    io_Stats.Tested += (uint32_t)count;
+    io_Stats.Drawn += visible_count;
+    io_Stats.Culled += (uint32_t)count - visible_count;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "../MatrixAlgebra.h"
+
+// Axis aligned bounding box
+struct AABB {
+	float           Min[3] = { 0.0f, 0.0f, 0.0f };
+	float           Max[3] = { 0.0f, 0.0f, 0.0f };
+};
+
+// Six normalized planes ( a, b, c, d ), point p is inside when a*x + b*y + c*z + d >= 0
+// Order: left, right, bottom, top, near, far
+struct Frustum {
+	float           Planes[6][4];
+};
+
+// Culling counters of the last frame
+struct CullingStats {
+	uint32_t        Tested = 0;                                 // Boxes tested against frustum
+	uint32_t        Culled = 0;                                 // Boxes rejected
+	uint32_t        Drawn = 0;                                  // Boxes accepted
+	uint32_t        NodesVisited = 0;                           // Hierarchy nodes tested (BVH culling only)
+};
+
+// Bounding boxes in center / extent structure of arrays form, padded to a multiple of 8
+// so the frustum test can always run full SIMD lanes
+class BoxSoA {
+
+public:
+	std::vector<float> CenterX, CenterY, CenterZ;
+	std::vector<float> ExtentX, ExtentY, ExtentZ;
+
+	void Resize(const size_t i_Count);
+	void Set(const size_t i_Index, const AABB& i_Box);
+	size_t Size() const { return Count; }
+
+private:
+	size_t          Count = 0;
+};
+
+// Gribb-Hartmann plane extraction from a column-major clip matrix
+// With projection * model view the planes are expressed in model space
+void ExtractFrustumPlanes(const Mat4& i_Matrix, Frustum& o_Frustum);
+
+// Box enclosing the transformed box (Arvo's method)
+AABB TransformAABB(const AABB& i_Box, const Affine& i_Matrix);
+
+// Merge box into another one
+void ExpandAABB(AABB& io_Box, const AABB& i_Other);
+
+// Box is fully outside of frustum
+bool IsOutside(const Frustum& i_Frustum, const AABB& i_Box);
+
+// Test all boxes against frustum, 4 (SSE) or 8 (AVX) boxes at a time
+// o_Visible receives 1 for boxes intersecting frustum and 0 for culled ones
+void CullBoxes(const Frustum& i_Frustum, const BoxSoA& i_Boxes, unsigned char* o_Visible, CullingStats& io_Stats);
@@ -0,0 +1,174 @@
+#include "GPUTimer.h"
+
+// Query targets of GPUStatistic values
+static const GLenum StatisticTargets[GPUStatisticCount] = {
+    GL_VERTICES_SUBMITTED_ARB,
+    GL_PRIMITIVES_SUBMITTED_ARB,
+    GL_FRAGMENT_SHADER_INVOCATIONS_ARB,
+};
+
+void GPUPassTimer::Create() {
+    GLint major_version = 0, minor_version = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major_version);
+    glGetIntegerv(GL_MINOR_VERSION, &minor_version);
+
+    const bool core_timer_query = major_version > 3 || (major_version == 3 && minor_version >= 3);
+    Supported = glGetQueryObjectui64v != nullptr && glQueryCounter != nullptr && (core_timer_query || GLExtensions.Has("GL_ARB_timer_query"));
+    if (!Supported) {
+        return;
+    }
+
+    // Pipeline statistics are core only since 4.6
+    const bool core_statistics = major_version > 4 || (major_version == 4 && minor_version >= 6);
+    StatisticsSupported = core_statistics || GLExtensions.Has("GL_ARB_pipeline_statistics_query");
+
+    for (int i = 0; i < GPUQueryFrames; ++i) {
+        Sets[i] = QuerySet();
+        glGenQueries(GPUPassCount * 2, &Sets[i].Timestamps[0][0]);
+        if (StatisticsSupported) {
+            glGenQueries(GPUPassCount * GPUStatisticCount, &Sets[i].Statistics[0][0]);
+        }
+    }
+    Current = 0;
+    FrameIndex = 0;
+    Dropped = 0;
+}
+
+void GPUPassTimer::Destroy() {
+    if (Supported) {
+        for (int i = 0; i < GPUQueryFrames; ++i) {
+            glDeleteQueries(GPUPassCount * 2, &Sets[i].Timestamps[0][0]);
+            if (StatisticsSupported) {
+                glDeleteQueries(GPUPassCount * GPUStatisticCount, &Sets[i].Statistics[0][0]);
+            }
+        }
+    }
+    Supported = false;
+    StatisticsSupported = false;
+    ResultsValid = false;
+}
+
+void GPUPassTimer::Begin(const GPUPass i_Pass) {
+    if (!Supported) {
+        return;
+    }
+
+    QuerySet& set = Sets[Current];
+    glQueryCounter(set.Timestamps[i_Pass][0], GL_TIMESTAMP);
+    if (StatisticsSupported) {
+        // Every statistic has its own target so all of them can be active at once
+        for (int statistic = 0; statistic < GPUStatisticCount; ++statistic) {
+            glBeginQuery(StatisticTargets[statistic], set.Statistics[i_Pass][statistic]);
+        }
+    }
+}
+
+void GPUPassTimer::End(const GPUPass i_Pass) {
+    if (!Supported) {
+        return;
+    }
+
+    QuerySet& set = Sets[Current];
+    if (StatisticsSupported) {
+        for (int statistic = 0; statistic < GPUStatisticCount; ++statistic) {
+            glEndQuery(StatisticTargets[statistic]);
+        }
+    }
+    glQueryCounter(set.Timestamps[i_Pass][1], GL_TIMESTAMP);
+    set.Issued[i_Pass] = true;
+}
+
+void GPUPassTimer::EndFrame() {
+    if (!Supported) {
+        return;
+    }
+
+    QuerySet& current = Sets[Current];
+    current.Frame = FrameIndex++;
+    current.Pending = false;
+    for (int pass = 0; pass < GPUPassCount; ++pass) {
+        current.Pending = current.Pending || current.Issued[pass];
+    }
+
+    // Walk from the oldest set to the current one, GPU finishes frames in order
+    // so the first set that is not ready means none of the newer ones are
+    for (int i = 1; i <= GPUQueryFrames; ++i) {
+        QuerySet& set = Sets[(Current + i) % GPUQueryFrames];
+        if (!set.Pending) {
+            continue;
+        }
+        if (!IsAvailable(set)) {
+            break;
+        }
+        ReadBack(set);
+    }
+
+    // Next set is reused, results the GPU still has not delivered are lost
+    Current = (Current + 1) % GPUQueryFrames;
+    QuerySet& next = Sets[Current];
+    if (next.Pending) {
+        Dropped++;
+        next.Pending = false;
+    }
+    for (int pass = 0; pass < GPUPassCount; ++pass) {
+        next.Issued[pass] = false;
+    }
+}
+
+bool GPUPassTimer::IsAvailable(const QuerySet& i_Set) const {
+    for (int pass = 0; pass < GPUPassCount; ++pass) {
+        if (!i_Set.Issued[pass]) {
+            continue;
+        }
+
+        GLint available = 0;
+        glGetQueryObjectiv(i_Set.Timestamps[pass][1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            return false;
+        }
+        if (StatisticsSupported) {
+            for (int statistic = 0; statistic < GPUStatisticCount; ++statistic) {
+                glGetQueryObjectiv(i_Set.Statistics[pass][statistic], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void GPUPassTimer::ReadBack(QuerySet& io_Set) {
+    GPUFrameStats results;
+    results.Frame = io_Set.Frame;
+
+    GLuint64 frame_begin = 0, frame_end = 0;
+    bool first = true;
+    for (int pass = 0; pass < GPUPassCount; ++pass) {
+        if (!io_Set.Issued[pass]) {
+            continue;
+        }
+
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(io_Set.Timestamps[pass][0], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(io_Set.Timestamps[pass][1], GL_QUERY_RESULT, &end);
+        results.PassMilliseconds[pass] = (double)(end - begin) * 1e-6;
+
+        frame_begin = (first || begin < frame_begin) ? begin : frame_begin;
+        frame_end = (first || end > frame_end) ? end : frame_end;
+        first = false;
+
+        if (StatisticsSupported) {
+            for (int statistic = 0; statistic < GPUStatisticCount; ++statistic) {
+                GLuint64 count = 0;
+                glGetQueryObjectui64v(io_Set.Statistics[pass][statistic], GL_QUERY_RESULT, &count);
+                results.Statistics[pass][statistic] = count;
+            }
+        }
+    }
+    results.FrameMilliseconds = (double)(frame_end - frame_begin) * 1e-6;
+
+    Results = results;
+    ResultsValid = true;
+    io_Set.Pending = false;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include "OpenGLFunctions.h"
+
+// GPU timer predifinitions
+#define GPUQueryFrames 4                                            // Frames in flight before query results have to be available
+
+// Render passes measured on GPU
+enum GPUPass {
+	GPUPassBase = 0,                                            // G-Buffer fill
+	GPUPassLighting,                                            // Fullscreen lighting, SSDO and fog
+	GPUPassCount
+};
+
+// Pipeline statistics counted per pass (ARB_pipeline_statistics_query)
+enum GPUStatistic {
+	GPUStatisticVertices = 0,                                   // Vertices submitted
+	GPUStatisticPrimitives,                                     // Primitives submitted
+	GPUStatisticFragments,                                      // Fragment shader invocations
+	GPUStatisticCount
+};
+
+// Results of a single frame
+struct GPUFrameStats {
+	uint64_t        Frame = 0;                                  // Index of frame the results belong to
+	double          PassMilliseconds[GPUPassCount] = {};        // Time between timestamps around each pass
+	double          FrameMilliseconds = 0.0;                    // First pass start to last pass end
+	uint64_t        Statistics[GPUPassCount][GPUStatisticCount] = {};
+};
+
+// GL_TIMESTAMP pair around each pass and optional pipeline statistics queries
+// Queries live in a ring of GPUQueryFrames sets, a set is read back only when its results are available
+// so the CPU never waits for the GPU, results arrive a few frames late
+class GPUPassTimer {
+
+public:
+	// Queries are only created when timer queries are supported (3.3 or ARB_timer_query)
+	void Create();
+	void Destroy();
+
+	void Begin(const GPUPass i_Pass);
+	void End(const GPUPass i_Pass);
+
+	// Call after the last pass of a frame
+	void EndFrame();
+
+	bool IsSupported() const { return Supported; }
+	bool HasStatistics() const { return StatisticsSupported; }
+
+	// Results of the latest frame whose queries were read back
+	bool HasResults() const { return ResultsValid; }
+	const GPUFrameStats& LatestResults() const { return Results; }
+	double PassMilliseconds(const GPUPass i_Pass) const { return Results.PassMilliseconds[i_Pass]; }
+
+	// Index the results of the next frame will carry in GPUFrameStats::Frame
+	uint64_t NextFrame() const { return FrameIndex; }
+
+	// Frames whose results were overwritten before they became available
+	uint64_t DroppedFrames() const { return Dropped; }
+
+private:
+	struct QuerySet {
+		GLuint      Timestamps[GPUPassCount][2] = {};           // Begin and end of each pass
+		GLuint      Statistics[GPUPassCount][GPUStatisticCount] = {};
+		bool        Issued[GPUPassCount] = {};
+		bool        Pending = false;                            // Submitted and not read back yet
+		uint64_t    Frame = 0;
+	};
+
+	bool            IsAvailable(const QuerySet& i_Set) const;
+	void            ReadBack(QuerySet& io_Set);
+
+	bool            Supported = false;
+	bool            StatisticsSupported = false;
+	QuerySet        Sets[GPUQueryFrames];
+	int             Current = 0;                                // Set used by current frame
+	uint64_t        FrameIndex = 0;
+	uint64_t        Dropped = 0;
+	GPUFrameStats   Results;
+	bool            ResultsValid = false;
+};
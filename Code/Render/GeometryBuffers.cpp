@@ -0,0 +1,464 @@
+#include "GeometryBuffers.h"
+#include <cstring>
+
+#define BUFFER_OFFSET(i) ((char *)NULL + (i))
+
+// Float count and shader location of every attribute, in interleaved order
+static const int AttributeComponents[VertexAttributeCount] = { 3, 2, 3 };
+static const GLuint AttributeLocations[VertexAttributeCount] = { 0, 1, 2 };
+// Components, type, normalization and bytes of every attribute in quantized formats
+static const GLint QuantizedComponents[VertexAttributeCount] = { 4, 2, 2 };
+static const GLenum QuantizedTypes[VertexAttributeCount] = { GL_UNSIGNED_SHORT, GL_HALF_FLOAT, GL_SHORT };
+static const GLboolean QuantizedNormalized[VertexAttributeCount] = { GL_TRUE, GL_FALSE, GL_TRUE };
+static const GLsizei QuantizedBytes[VertexAttributeCount] = { QuantizedPositionBytes, QuantizedTexCoordBytes, QuantizedNormalBytes };
+
+void RangeAllocator::Reset(const size_t i_Capacity) {
+    FreeRanges.clear();
+    if (i_Capacity > 0) {
+        FreeRanges[0] = i_Capacity;
+    }
+    CapacityBytes = i_Capacity;
+    UsedBytes = 0;
+}
+
+size_t RangeAllocator::Allocate(const size_t i_Size, const size_t i_Alignment) {
+    for (auto range = FreeRanges.begin(); range != FreeRanges.end(); ++range) {
+        const size_t begin = range->first;
+        const size_t end = range->first + range->second;
+        const size_t offset = (begin + i_Alignment - 1) / i_Alignment * i_Alignment;
+        if (offset + i_Size > end) {
+            continue;
+        }
+
+        // Alignment padding and the rest of the range stay free
+        FreeRanges.erase(range);
+        if (offset > begin) {
+            FreeRanges[begin] = offset - begin;
+        }
+        if (offset + i_Size < end) {
+            FreeRanges[offset + i_Size] = end - offset - i_Size;
+        }
+        UsedBytes += i_Size;
+        return offset;
+    }
+    return InvalidAllocation;
+}
+
+void RangeAllocator::Free(const size_t i_Offset, const size_t i_Size) {
+    if (i_Size == 0) {
+        return;
+    }
+    UsedBytes -= i_Size;
+
+    auto range = FreeRanges.emplace(i_Offset, i_Size).first;
+    // Merge with following range
+    auto next = std::next(range);
+    if (next != FreeRanges.end() && range->first + range->second == next->first) {
+        range->second += next->second;
+        FreeRanges.erase(next);
+    }
+    // Merge with preceding range
+    if (range != FreeRanges.begin()) {
+        auto previous = std::prev(range);
+        if (previous->first + previous->second == range->first) {
+            previous->second += range->second;
+            FreeRanges.erase(range);
+        }
+    }
+}
+
+GLsizei GeometryBuffers::Stride(const uint32_t i_Attributes) {
+    const bool quantized = (i_Attributes & VertexAttributeQuantized) != 0;
+    GLsizei stride = 0;
+    for (int i = 0; i < VertexAttributeCount; ++i) {
+        if (i_Attributes & (1u << i)) {
+            stride += quantized ? QuantizedBytes[i] : AttributeComponents[i] * (GLsizei)sizeof(float);
+        }
+    }
+    return stride;
+}
+
+void GeometryBuffers::CreateArena(std::vector<Arena>& io_Arenas, const size_t i_Size) {
+    Arena arena;
+    arena.Allocator.Reset(i_Size);
+    glGenBuffers(1, &arena.Buffer);
+    // Copy write target does not touch element buffer binding of the current VAO
+    glBindBuffer(GL_COPY_WRITE_BUFFER, arena.Buffer);
+    if (glBufferStorage) {
+        glBufferStorage(GL_COPY_WRITE_BUFFER, i_Size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    }
+    else {
+        glBufferData(GL_COPY_WRITE_BUFFER, i_Size, nullptr, GL_STATIC_DRAW);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    io_Arenas.push_back(arena);
+}
+
+int GeometryBuffers::AllocateIn(std::vector<Arena>& io_Arenas, const size_t i_Size, const size_t i_Alignment, size_t& o_Offset) {
+    for (size_t i = 0; i < io_Arenas.size(); ++i) {
+        o_Offset = io_Arenas[i].Allocator.Allocate(i_Size, i_Alignment);
+        if (o_Offset != InvalidAllocation) {
+            return (int)i;
+        }
+    }
+
+    CreateArena(io_Arenas, i_Size > GeometryArenaBytes ? i_Size : GeometryArenaBytes);
+    o_Offset = io_Arenas.back().Allocator.Allocate(i_Size, i_Alignment);
+    return o_Offset != InvalidAllocation ? (int)io_Arenas.size() - 1 : -1;
+}
+
+int GeometryBuffers::FindFormat(const uint32_t i_Attributes) {
+    for (size_t i = 0; i < Formats.size(); ++i) {
+        if (Formats[i].Attributes == i_Attributes) {
+            return (int)i;
+        }
+    }
+    FormatArenas format;
+    format.Attributes = i_Attributes;
+    Formats.push_back(format);
+    return (int)Formats.size() - 1;
+}
+
+int GeometryBuffers::FindVertexArray(const int i_Format, const int i_VertexArena, const int i_IndexArena) {
+    const std::pair<std::pair<int, int>, int> key(std::make_pair(i_Format, i_VertexArena), i_IndexArena);
+    auto found = VertexArrayLookup.find(key);
+    if (found != VertexArrayLookup.end()) {
+        return found->second;
+    }
+
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, Formats[i_Format].Arenas[i_VertexArena].Buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IndexArenas[i_IndexArena].Buffer);
+
+    const uint32_t attributes = Formats[i_Format].Attributes;
+    const bool quantized = (attributes & VertexAttributeQuantized) != 0;
+    const GLsizei stride = Stride(attributes);
+    size_t offset = 0;
+    for (int i = 0; i < VertexAttributeCount; ++i) {
+        if (attributes & (1u << i)) {
+            glEnableVertexAttribArray(AttributeLocations[i]);
+            if (quantized) {
+                glVertexAttribPointer(AttributeLocations[i], QuantizedComponents[i], QuantizedTypes[i], QuantizedNormalized[i], stride, BUFFER_OFFSET(offset));
+                offset += QuantizedBytes[i];
+            }
+            else {
+                glVertexAttribPointer(AttributeLocations[i], AttributeComponents[i], GL_FLOAT, GL_FALSE, stride, BUFFER_OFFSET(offset));
+                offset += AttributeComponents[i] * sizeof(float);
+            }
+        }
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (DrawIndexBuffer) {
+        AttachDrawIndex(vao);
+    }
+
+    VertexArrays.push_back(vao);
+    VertexArrayLookup[key] = (int)VertexArrays.size() - 1;
+    return (int)VertexArrays.size() - 1;
+}
+
+void GeometryBuffers::Reserve(const uint32_t i_Attributes, const size_t i_VertexBytes, const size_t i_IndexBytes) {
+    std::vector<Arena>& vertex_arenas = Formats[FindFormat(i_Attributes)].Arenas;
+    size_t vertex_free = 0;
+    for (size_t i = 0; i < vertex_arenas.size(); ++i) {
+        vertex_free += vertex_arenas[i].Allocator.Capacity() - vertex_arenas[i].Allocator.Used();
+    }
+    if (i_VertexBytes > vertex_free) {
+        CreateArena(vertex_arenas, i_VertexBytes - vertex_free);
+    }
+
+    size_t index_free = 0;
+    for (size_t i = 0; i < IndexArenas.size(); ++i) {
+        index_free += IndexArenas[i].Allocator.Capacity() - IndexArenas[i].Allocator.Used();
+    }
+    if (i_IndexBytes > index_free) {
+        CreateArena(IndexArenas, i_IndexBytes - index_free);
+    }
+}
+
+int GeometryBuffers::Add(const uint32_t i_Attributes, const float* i_Vertices, const size_t i_VertexCount, const uint32_t* i_Indices, const size_t i_IndexCount,
+    const GLenum i_Mode, const GLenum i_IndexType) {
+    GeometryRange range;
+    range.Format = FindFormat(i_Attributes);
+    range.Mode = i_Mode;
+    range.IndexCount = (GLsizei)i_IndexCount;
+
+    // Vertex offsets are multiples of the stride so they can be addressed as base vertex
+    const GLsizei stride = Stride(i_Attributes);
+    range.VertexBytes = i_VertexCount * stride;
+    range.VertexArena = AllocateIn(Formats[range.Format].Arenas, range.VertexBytes, stride, range.VertexOffset);
+    if (range.VertexArena < 0) {
+        return -1;
+    }
+    const GLint base_vertex = (GLint)(range.VertexOffset / stride);
+    range.BaseVertex = glDrawElementsBaseVertex ? base_vertex : 0;
+
+    if (!UploadIndices(range, i_Indices, i_IndexCount, i_IndexType, i_VertexCount)) {
+        Formats[range.Format].Arenas[range.VertexArena].Allocator.Free(range.VertexOffset, range.VertexBytes);
+        return -1;
+    }
+
+    const void* vertex_data = i_Vertices;
+    std::vector<unsigned char> quantized;
+    if (i_Attributes & VertexAttributeQuantized) {
+        quantized.resize(range.VertexBytes);
+        QuantizeVertices(quantized.data(), i_Vertices, i_VertexCount, (i_Attributes & VertexAttributeTexCoord) != 0, (i_Attributes & VertexAttributeNormal) != 0,
+            range.PositionScale, range.PositionOffset);
+        vertex_data = quantized.data();
+    }
+
+    Write(Formats[range.Format].Arenas[range.VertexArena].Buffer, range.VertexOffset, range.VertexBytes, vertex_data);
+
+    Ranges.push_back(range);
+    return (int)Ranges.size() - 1;
+}
+
+int GeometryBuffers::AddIndices(const int i_Range, const uint32_t* i_Indices, const size_t i_IndexCount) {
+    // Vertices stay owned by the source range
+    GeometryRange range = Ranges[i_Range];
+    range.VertexBytes = 0;
+    range.IndexCount = (GLsizei)i_IndexCount;
+
+    const size_t vertex_count = Ranges[i_Range].VertexBytes / Stride(Formats[range.Format].Attributes);
+    if (!UploadIndices(range, i_Indices, i_IndexCount, Ranges[i_Range].IndexType, vertex_count)) {
+        return -1;
+    }
+
+    Ranges.push_back(range);
+    return (int)Ranges.size() - 1;
+}
+
+bool GeometryBuffers::UploadIndices(GeometryRange& io_Range, const uint32_t* i_Indices, const size_t i_IndexCount, const GLenum i_IndexType, const size_t i_VertexCount) {
+    // Without base vertex draws the vertex offset is added to indices once here
+    const uint32_t index_base = glDrawElementsBaseVertex ? 0 : (uint32_t)(io_Range.VertexOffset / Stride(Formats[io_Range.Format].Attributes));
+    io_Range.IndexType = i_IndexType == GL_UNSIGNED_SHORT && index_base + i_VertexCount <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    const size_t index_size = io_Range.IndexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    io_Range.IndexBytes = i_IndexCount * index_size;
+    io_Range.IndexArena = AllocateIn(IndexArenas, io_Range.IndexBytes, index_size, io_Range.IndexOffset);
+    if (io_Range.IndexArena < 0) {
+        return false;
+    }
+    io_Range.FirstIndex = (GLuint)(io_Range.IndexOffset / index_size);
+    io_Range.VertexArray = FindVertexArray(io_Range.Format, io_Range.VertexArena, io_Range.IndexArena);
+
+    const GLuint buffer = IndexArenas[io_Range.IndexArena].Buffer;
+    if (io_Range.IndexType == GL_UNSIGNED_SHORT) {
+        std::vector<uint16_t> narrow(i_IndexCount);
+        for (size_t i = 0; i < i_IndexCount; ++i) {
+            narrow[i] = (uint16_t)(i_Indices[i] + index_base);
+        }
+        Write(buffer, io_Range.IndexOffset, io_Range.IndexBytes, narrow.data());
+    }
+    else if (index_base) {
+        std::vector<uint32_t> rebased(i_Indices, i_Indices + i_IndexCount);
+        for (size_t i = 0; i < rebased.size(); ++i) {
+            rebased[i] += index_base;
+        }
+        Write(buffer, io_Range.IndexOffset, io_Range.IndexBytes, rebased.data());
+    }
+    else {
+        Write(buffer, io_Range.IndexOffset, io_Range.IndexBytes, i_Indices);
+    }
+    return true;
+}
+
+void GeometryBuffers::Write(const GLuint i_Buffer, const size_t i_Offset, const size_t i_Bytes, const void* i_Data) {
+    size_t staging_offset;
+    unsigned char* staging = Staging ? Staging->Allocate(i_Bytes, sizeof(uint32_t), staging_offset) : nullptr;
+
+    // Staged bytes are copied by the GPU, anything else is copied by the driver right away
+    glBindBuffer(GL_COPY_WRITE_BUFFER, i_Buffer);
+    if (staging) {
+        memcpy(staging, i_Data, i_Bytes);
+        glBindBuffer(GL_COPY_READ_BUFFER, Staging->Buffer());
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, staging_offset, i_Offset, i_Bytes);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+    else {
+        glBufferSubData(GL_COPY_WRITE_BUFFER, i_Offset, i_Bytes, i_Data);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void GeometryBuffers::Remove(const int i_Range) {
+    GeometryRange& range = Ranges[i_Range];
+    if (range.Format < 0) {
+        return;
+    }
+    if (range.VertexBytes) {
+        Formats[range.Format].Arenas[range.VertexArena].Allocator.Free(range.VertexOffset, range.VertexBytes);
+    }
+    IndexArenas[range.IndexArena].Allocator.Free(range.IndexOffset, range.IndexBytes);
+    range = GeometryRange();
+}
+
+void GeometryBuffers::SetDrawIndexStream(const GLuint i_Buffer) {
+    DrawIndexBuffer = i_Buffer;
+    if (DrawIndexBuffer) {
+        for (size_t i = 0; i < VertexArrays.size(); ++i) {
+            AttachDrawIndex(VertexArrays[i]);
+        }
+    }
+}
+
+void GeometryBuffers::AttachDrawIndex(const GLuint i_VertexArray) {
+    glBindVertexArray(i_VertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, DrawIndexBuffer);
+    glEnableVertexAttribArray(DrawIndexLocation);
+    glVertexAttribPointer(DrawIndexLocation, 1, GL_UNSIGNED_INT, GL_FALSE, sizeof(uint32_t), BUFFER_OFFSET(0));
+    glVertexAttribDivisor(DrawIndexLocation, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GeometryBuffers::Destroy() {
+    if (!VertexArrays.empty()) {
+        glDeleteVertexArrays((GLsizei)VertexArrays.size(), VertexArrays.data());
+    }
+    for (size_t i = 0; i < Formats.size(); ++i) {
+        for (size_t arena = 0; arena < Formats[i].Arenas.size(); ++arena) {
+            glDeleteBuffers(1, &Formats[i].Arenas[arena].Buffer);
+        }
+    }
+    for (size_t arena = 0; arena < IndexArenas.size(); ++arena) {
+        glDeleteBuffers(1, &IndexArenas[arena].Buffer);
+    }
+
+    Formats.clear();
+    IndexArenas.clear();
+    VertexArrays.clear();
+    VertexArrayLookup.clear();
+    Ranges.clear();
+    DrawIndexBuffer = 0;
+}
+
+size_t GeometryBuffers::VertexBytes() const {
+    size_t bytes = 0;
+    for (size_t i = 0; i < Formats.size(); ++i) {
+        for (size_t arena = 0; arena < Formats[i].Arenas.size(); ++arena) {
+            bytes += Formats[i].Arenas[arena].Allocator.Used();
+        }
+    }
+    return bytes;
+}
+
+size_t GeometryBuffers::IndexBytes() const {
+    size_t bytes = 0;
+    for (size_t arena = 0; arena < IndexArenas.size(); ++arena) {
+        bytes += IndexArenas[arena].Allocator.Used();
+    }
+    return bytes;
+}
+
+size_t GeometryBuffers::BufferCount() const {
+    size_t count = IndexArenas.size();
+    for (size_t i = 0; i < Formats.size(); ++i) {
+        count += Formats[i].Arenas.size();
+    }
+    return count;
+}
+
+// Element layout of an accessor inside its buffer, false if it does not fit
+static bool AccessorLayout(const tinygltf::Model& i_Model, const BufferSpans& i_Buffers, const tinygltf::Accessor& i_Accessor,
+    const unsigned char*& o_Data, size_t& o_Stride, int& o_Components, int& o_ComponentSize) {
+    if (i_Accessor.bufferView < 0 || i_Accessor.bufferView >= (int)i_Model.bufferViews.size()) {
+        return false;
+    }
+    const tinygltf::BufferView& view = i_Model.bufferViews[i_Accessor.bufferView];
+    if (view.buffer < 0 || view.buffer >= (int)i_Buffers.size()) {
+        return false;
+    }
+
+    o_Components = tinygltf::GetNumComponentsInType((uint32_t)i_Accessor.type);
+    o_ComponentSize = tinygltf::GetComponentSizeInBytes((uint32_t)i_Accessor.componentType);
+    if (o_Components <= 0 || o_ComponentSize <= 0) {
+        return false;
+    }
+    const size_t element_size = (size_t)o_Components * o_ComponentSize;
+    o_Stride = view.byteStride ? view.byteStride : element_size;
+
+    // View must lie inside the buffer and the last element end inside the view,
+    // compared by subtraction so offsets and counts from the file cannot overflow
+    const size_t buffer_size = i_Buffers[view.buffer].second;
+    if (view.byteOffset > buffer_size || view.byteLength > buffer_size - view.byteOffset) {
+        return false;
+    }
+    if (i_Accessor.count) {
+        if (i_Accessor.byteOffset > view.byteLength || element_size > view.byteLength - i_Accessor.byteOffset ||
+            i_Accessor.count - 1 > (view.byteLength - i_Accessor.byteOffset - element_size) / o_Stride) {
+            return false;
+        }
+    }
+    o_Data = i_Buffers[view.buffer].first + view.byteOffset + i_Accessor.byteOffset;
+    return true;
+}
+
+bool IsAccessorReadable(const tinygltf::Model& i_Model, const BufferSpans& i_Buffers, const int i_Accessor) {
+    if (i_Accessor < 0 || i_Accessor >= (int)i_Model.accessors.size()) {
+        return false;
+    }
+    const unsigned char* data;
+    size_t stride;
+    int components, component_size;
+    return AccessorLayout(i_Model, i_Buffers, i_Model.accessors[i_Accessor], data, stride, components, component_size);
+}
+
+bool ReadAccessorFloats(const tinygltf::Model& i_Model, const BufferSpans& i_Buffers, const int i_Accessor, const int i_Components, float* o_Values, const size_t i_Stride) {
+    if (i_Accessor < 0 || i_Accessor >= (int)i_Model.accessors.size()) {
+        return false;
+    }
+    const tinygltf::Accessor& accessor = i_Model.accessors[i_Accessor];
+    const unsigned char* data;
+    size_t stride;
+    int components, component_size;
+    if (!AccessorLayout(i_Model, i_Buffers, accessor, data, stride, components, component_size)) {
+        return false;
+    }
+    const int count = components < i_Components ? components : i_Components;
+
+    for (size_t i = 0; i < accessor.count; ++i) {
+        const unsigned char* element = data + i * stride;
+        float* output = o_Values + i * i_Stride;
+        for (int c = 0; c < count; ++c) {
+            const unsigned char* value = element + c * component_size;
+            switch (accessor.componentType) {
+                case TINYGLTF_COMPONENT_TYPE_FLOAT: { float v; memcpy(&v, value, 4); output[c] = v; break; }
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: { const float v = *value; output[c] = accessor.normalized ? v / 255.0f : v; break; }
+                case TINYGLTF_COMPONENT_TYPE_BYTE: { const float v = (float)(int8_t)*value; output[c] = accessor.normalized ? (v / 127.0f < -1.0f ? -1.0f : v / 127.0f) : v; break; }
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: { uint16_t v; memcpy(&v, value, 2); output[c] = accessor.normalized ? v / 65535.0f : v; break; }
+                case TINYGLTF_COMPONENT_TYPE_SHORT: { int16_t v; memcpy(&v, value, 2); output[c] = accessor.normalized ? (v / 32767.0f < -1.0f ? -1.0f : v / 32767.0f) : v; break; }
+                case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: { uint32_t v; memcpy(&v, value, 4); output[c] = (float)v; break; }
+                default: return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool ReadAccessorIndices(const tinygltf::Model& i_Model, const BufferSpans& i_Buffers, const int i_Accessor, uint32_t* o_Indices) {
+    if (i_Accessor < 0 || i_Accessor >= (int)i_Model.accessors.size()) {
+        return false;
+    }
+    const tinygltf::Accessor& accessor = i_Model.accessors[i_Accessor];
+    const unsigned char* data;
+    size_t stride;
+    int components, component_size;
+    if (!AccessorLayout(i_Model, i_Buffers, accessor, data, stride, components, component_size) || components != 1) {
+        return false;
+    }
+
+    for (size_t i = 0; i < accessor.count; ++i) {
+        const unsigned char* value = data + i * stride;
+        switch (accessor.componentType) {
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: o_Indices[i] = *value; break;
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: { uint16_t v; memcpy(&v, value, 2); o_Indices[i] = v; break; }
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: { uint32_t v; memcpy(&v, value, 4); o_Indices[i] = v; break; }
+            default: return false;
+        }
+    }
+    return true;
+}
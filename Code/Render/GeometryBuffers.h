@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+#include "OpenGLFunctions.h"
+#include "StagingRing.h"
+#include "VertexQuantization.h"
+#include "../tinyGLTF/tiny_gltf.h"
+
+// Geometry buffer predifinitions
+#define GeometryArenaBytes (16u << 20)                      // Size of an arena created on demand, larger requests get their own
+#define InvalidAllocation ((size_t)-1)
+#define VertexAttributeCount 3
+#define DrawIndexLocation 3                                 // Per instance draw index of indirect draws, after the vertex attributes
+
+// Attributes of interleaved vertex formats, stored in this order, locations match base pass bindings
+enum VertexAttribute {
+	VertexAttributePosition = 1 << 0,                       // 3 floats, location 0
+	VertexAttributeTexCoord = 1 << 1,                       // 2 floats, location 1
+	VertexAttributeNormal = 1 << 2,                         // 3 floats, location 2
+	VertexAttributeQuantized = 1 << 3,                      // Stored as unorm16 positions, half float texcoords and octahedral snorm16 normals
+};
+
+// First fit free list over [0, capacity), neighbouring free ranges are merged on release
+class RangeAllocator {
+
+public:
+	void Reset(const size_t i_Capacity);
+
+	// Offset of a range aligned to i_Alignment (any positive value), InvalidAllocation when nothing fits
+	size_t Allocate(const size_t i_Size, const size_t i_Alignment);
+	void Free(const size_t i_Offset, const size_t i_Size);
+
+	size_t Capacity() const { return CapacityBytes; }
+	size_t Used() const { return UsedBytes; }
+
+private:
+	std::map<size_t, size_t> FreeRanges;                        // Offset -> size
+	size_t          CapacityBytes = 0;
+	size_t          UsedBytes = 0;
+};
+
+// Placement of one primitive's geometry
+struct GeometryRange {
+	int             VertexArray = -1;                           // VAO to bind, see GeometryBuffers::VertexArray
+	GLint           BaseVertex = 0;                             // Added to indices by the draw, 0 when it is baked into them
+	GLuint          FirstIndex = 0;                             // First index in the index buffer, in elements of IndexType
+	GLsizei         IndexCount = 0;
+	GLenum          IndexType = GL_UNSIGNED_INT;                // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	GLenum          Mode = GL_TRIANGLES;
+	float           PositionScale[3] = { 1.0f, 1.0f, 1.0f };    // Position = offset + scale * stored position, identity for float vertices
+	float           PositionOffset[3] = { 0.0f, 0.0f, 0.0f };
+
+	int             Format = -1;                                // Allocation bookkeeping for Remove
+	int             VertexArena = -1;
+	size_t          VertexOffset = 0;
+	size_t          VertexBytes = 0;                            // 0 when vertices belong to another range
+	int             IndexArena = -1;
+	size_t          IndexOffset = 0;
+	size_t          IndexBytes = 0;
+};
+
+// Vertex and index data of the whole scene packed into a few large buffers
+// Every vertex format has its own arenas of interleaved vertices, indices of all formats share index arenas
+// Primitives in the same arenas share one VAO, so consecutive draws do not rebind any buffer
+class GeometryBuffers {
+
+public:
+	// Bytes of one interleaved vertex
+	static GLsizei Stride(const uint32_t i_Attributes);
+
+	// Copy uploads through given ring while it has room in the current frame, nullptr writes buffers directly
+	void SetStaging(StagingRing* i_Staging) { Staging = i_Staging; }
+
+	// Read DrawIndexLocation once per instance from given buffer of 32 bit indices, indirect draws pick an entry with their base instance
+	// Applies to existing and later vertex arrays
+	void SetDrawIndexStream(const GLuint i_Buffer);
+
+	// Make sure the format and the index arenas have room for given bytes, sizes the first arenas to the scene
+	void Reserve(const uint32_t i_Attributes, const size_t i_VertexBytes, const size_t i_IndexBytes);
+
+	// Copy interleaved float vertices and indices (relative to the first vertex) into arenas, range index or -1
+	// Quantized formats take the same float vertices and encode them on upload
+	// GL_UNSIGNED_SHORT stores indices as 16 bit unless the base vertex has to be baked into them and does not fit
+	int Add(const uint32_t i_Attributes, const float* i_Vertices, const size_t i_VertexCount, const uint32_t* i_Indices, const size_t i_IndexCount,
+		const GLenum i_Mode, const GLenum i_IndexType);
+	// Another index list over the vertices of an existing range (levels of detail), vertices are freed with the source range
+	int AddIndices(const int i_Range, const uint32_t* i_Indices, const size_t i_IndexCount);
+	void Remove(const int i_Range);
+
+	const GeometryRange& Range(const int i_Range) const { return Ranges[i_Range]; }
+	GLuint VertexArray(const int i_VertexArray) const { return VertexArrays[i_VertexArray]; }
+
+	void Destroy();
+
+	// Allocated bytes and number of GL buffers
+	size_t VertexBytes() const;
+	size_t IndexBytes() const;
+	size_t BufferCount() const;
+
+private:
+	struct Arena {
+		GLuint          Buffer = 0;
+		RangeAllocator  Allocator;
+	};
+
+	struct FormatArenas {
+		uint32_t        Attributes = 0;
+		std::vector<Arena> Arenas;
+	};
+
+	static int AllocateIn(std::vector<Arena>& io_Arenas, const size_t i_Size, const size_t i_Alignment, size_t& o_Offset);
+	static void CreateArena(std::vector<Arena>& io_Arenas, const size_t i_Size);
+	int FindFormat(const uint32_t i_Attributes);
+	int FindVertexArray(const int i_Format, const int i_VertexArena, const int i_IndexArena);
+	void AttachDrawIndex(const GLuint i_VertexArray);
+	bool UploadIndices(GeometryRange& io_Range, const uint32_t* i_Indices, const size_t i_IndexCount, const GLenum i_IndexType, const size_t i_VertexCount);
+	void Write(const GLuint i_Buffer, const size_t i_Offset, const size_t i_Bytes, const void* i_Data);
+
+	std::vector<FormatArenas> Formats;
+	std::vector<Arena> IndexArenas;
+	std::vector<GLuint> VertexArrays;
+	std::map<std::pair<std::pair<int, int>, int>, int> VertexArrayLookup; // (format, vertex arena), index arena -> VAO index
+	std::vector<GeometryRange> Ranges;
+	StagingRing*    Staging = nullptr;
+	GLuint          DrawIndexBuffer = 0;                        // See SetDrawIndexStream, 0 leaves the location disabled
+};
+
+// Buffer contents of a model, from the model itself or from a cooked package
+typedef std::vector<std::pair<const unsigned char*, size_t>> BufferSpans;
+
+// Accessor index, its buffer view and every element byte are inside the model buffers
+bool IsAccessorReadable(const tinygltf::Model& i_Model, const BufferSpans& i_Buffers, const int i_Accessor);
+// Convert accessor elements to i_Components floats each, written i_Stride floats apart
+// Normalized integers are mapped to [0, 1]/[-1, 1], false if accessor is unsupported or out of buffer range
+bool ReadAccessorFloats(const tinygltf::Model& i_Model, const BufferSpans& i_Buffers, const int i_Accessor, const int i_Components, float* o_Values, const size_t i_Stride);
+// Convert index accessor to 32 bit indices
+bool ReadAccessorIndices(const tinygltf::Model& i_Model, const BufferSpans& i_Buffers, const int i_Accessor, uint32_t* o_Indices);
@@ -0,0 +1,175 @@
+#include <immintrin.h>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include "ImageDecode.h"
+#include "../Utils/ThreadPool.h"
+#include "../tinyGLTF/stb_image.h"
+
+bool DeferImageDecode(tinygltf::Image* o_Image, const int i_ImageIndex, std::string* o_Error, std::string* /*o_Warning*/,
+    int /*i_RequestedWidth*/, int /*i_RequestedHeight*/, const unsigned char* i_Bytes, int i_Size, void* i_UserData) {
+    DeferredImages* images = (DeferredImages*)i_UserData;
+    if (!images || !i_Bytes || i_Size <= 0) {
+        if (o_Error) {
+            *o_Error += "Image " + std::to_string(i_ImageIndex) + " has no data\n";
+        }
+        return false;
+    }
+
+    // Bytes belong to the loader and are gone after the callback returns
+    DeferredImage image;
+    image.Index = i_ImageIndex;
+    image.Encoded.assign(i_Bytes, i_Bytes + i_Size);
+    images->Images.push_back(std::move(image));
+
+    o_Image->bits = 8;
+    o_Image->component = 4;
+    o_Image->pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+    return true;
+}
+
+void ExpandRGBToRGBA(const uint8_t* i_Source, uint8_t* o_Destination, const size_t i_Pixels) {
+    size_t i = 0;
+#if defined(__SSSE3__) || defined(__AVX__)
+    // 4 pixels per step, a 16 byte load reads 12 bytes of them so the last 2 steps are left for scalar tail
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+    for (; i + 6 <= i_Pixels; i += 4) {
+        const __m128i rgb = _mm_loadu_si128((const __m128i*)(i_Source + i * 3));
+        _mm_storeu_si128((__m128i*)(o_Destination + i * 4), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha));
+    }
+#endif
+    for (; i < i_Pixels; ++i) {
+        o_Destination[i * 4 + 0] = i_Source[i * 3 + 0];
+        o_Destination[i * 4 + 1] = i_Source[i * 3 + 1];
+        o_Destination[i * 4 + 2] = i_Source[i * 3 + 2];
+        o_Destination[i * 4 + 3] = 255;
+    }
+}
+
+void ExpandGreyToRGBA(const uint8_t* i_Source, uint8_t* o_Destination, const size_t i_Pixels, const int i_Components) {
+    for (size_t i = 0; i < i_Pixels; ++i) {
+        const uint8_t grey = i_Source[i * i_Components];
+        o_Destination[i * 4 + 0] = grey;
+        o_Destination[i * 4 + 1] = grey;
+        o_Destination[i * 4 + 2] = grey;
+        o_Destination[i * 4 + 3] = i_Components == 2 ? i_Source[i * 2 + 1] : 255;
+    }
+}
+
+void Convert16To8(const uint16_t* i_Source, uint8_t* o_Destination, const size_t i_Count) {
+    size_t i = 0;
+    // x = v + 128, (x - (x >> 8)) >> 8 equals round(v / 257) for every 16 bit value
+    const __m128i half = _mm_set1_epi16(128);
+    for (; i + 16 <= i_Count; i += 16) {
+        __m128i low = _mm_adds_epu16(_mm_loadu_si128((const __m128i*)(i_Source + i)), half);
+        __m128i high = _mm_adds_epu16(_mm_loadu_si128((const __m128i*)(i_Source + i + 8)), half);
+        low = _mm_srli_epi16(_mm_sub_epi16(low, _mm_srli_epi16(low, 8)), 8);
+        high = _mm_srli_epi16(_mm_sub_epi16(high, _mm_srli_epi16(high, 8)), 8);
+        _mm_storeu_si128((__m128i*)(o_Destination + i), _mm_packus_epi16(low, high));
+    }
+    for (; i < i_Count; ++i) {
+        o_Destination[i] = (uint8_t)(((uint32_t)i_Source[i] * 255 + 32767) / 65535);
+    }
+}
+
+// Decode one image into 8 bit RGBA, runs on worker threads
+static bool DecodeImage(const DeferredImage& i_Deferred, tinygltf::Image& o_Image) {
+    const stbi_uc* encoded = i_Deferred.Encoded.data();
+    const int size = (int)i_Deferred.Encoded.size();
+
+    int width = 0, height = 0, components = 0;
+    std::vector<uint8_t> pixels;
+    if (stbi_is_16_bit_from_memory(encoded, size)) {
+        stbi_us* data = stbi_load_16_from_memory(encoded, size, &width, &height, &components, 0);
+        if (!data) {
+            return false;
+        }
+        // Textures are sampled as 8 bit, 16 bit sources only cost upload bandwidth
+        pixels.resize((size_t)width * height * components);
+        Convert16To8(data, pixels.data(), pixels.size());
+        stbi_image_free(data);
+    }
+    else {
+        stbi_uc* data = stbi_load_from_memory(encoded, size, &width, &height, &components, 0);
+        if (!data) {
+            return false;
+        }
+        pixels.assign(data, data + (size_t)width * height * components);
+        stbi_image_free(data);
+    }
+
+    const size_t count = (size_t)width * height;
+    if (components == 4) {
+        o_Image.image.swap(pixels);
+    }
+    else {
+        o_Image.image.resize(count * 4);
+        if (components == 3) {
+            ExpandRGBToRGBA(pixels.data(), o_Image.image.data(), count);
+        }
+        else {
+            ExpandGreyToRGBA(pixels.data(), o_Image.image.data(), count, components);
+        }
+    }
+
+    o_Image.width = width;
+    o_Image.height = height;
+    o_Image.component = 4;
+    o_Image.bits = 8;
+    o_Image.pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+    return true;
+}
+
+void DecodeImages(tinygltf::Model& io_Model, DeferredImages& io_Images, const std::function<void(int)>& i_Decoded) {
+    if (io_Images.Images.empty()) {
+        return;
+    }
+
+    std::mutex mutex;
+    std::condition_variable ready_changed;
+    std::vector<int> ready;
+
+    {
+        ThreadPool pool((unsigned int)(io_Images.Images.size() < std::thread::hardware_concurrency() ? io_Images.Images.size() : 0));
+        size_t submitted = 0;
+        for (size_t i = 0; i < io_Images.Images.size(); ++i) {
+            const DeferredImage* deferred = &io_Images.Images[i];
+            if (deferred->Index < 0 || deferred->Index >= (int)io_Model.images.size()) {
+                continue;
+            }
+            // Every job writes a different model image, model image vector itself is not resized
+            tinygltf::Image* image = &io_Model.images[deferred->Index];
+            pool.Submit([deferred, image, &mutex, &ready_changed, &ready] {
+                if (!DecodeImage(*deferred, *image)) {
+                    image->bits = -1;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ready.push_back(deferred->Index);
+                }
+                ready_changed.notify_one();
+            });
+            submitted++;
+        }
+
+        // Hand over finished images while the rest is still decoding
+        size_t handled = 0;
+        std::vector<int> batch;
+        while (handled < submitted) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready_changed.wait(lock, [&ready] { return !ready.empty(); });
+                batch.swap(ready);
+            }
+            for (size_t i = 0; i < batch.size(); ++i) {
+                i_Decoded(batch[i]);
+            }
+            handled += batch.size();
+            batch.clear();
+        }
+    }
+
+    // Encoded copies are not needed anymore
+    std::vector<DeferredImage>().swap(io_Images.Images);
+}
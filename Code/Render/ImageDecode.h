@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "../tinyGLTF/tiny_gltf.h"
+
+// Encoded image kept by the loader callback until it is decoded
+struct DeferredImage {
+	int             Index = -1;                                 // Index in model images
+	std::vector<unsigned char> Encoded;                         // PNG/JPEG/... file contents
+};
+
+// Images collected while tinyGLTF parses the model
+struct DeferredImages {
+	std::vector<DeferredImage> Images;
+};
+
+// tinyGLTF image loader callback, only stores encoded bytes, user data is DeferredImages
+bool DeferImageDecode(tinygltf::Image* o_Image, const int i_ImageIndex, std::string* o_Error, std::string* o_Warning,
+	int i_RequestedWidth, int i_RequestedHeight, const unsigned char* i_Bytes, int i_Size, void* i_UserData);
+
+// Decode deferred images on worker threads into 8 bit RGBA model images
+// i_Decoded runs on the calling thread for every image as soon as it is ready, failed images have bits == -1
+void DecodeImages(tinygltf::Model& io_Model, DeferredImages& io_Images, const std::function<void(int)>& i_Decoded);
+
+// Pixel conversion kernels, SSE2/SSSE3 with scalar tails
+void ExpandRGBToRGBA(const uint8_t* i_Source, uint8_t* o_Destination, const size_t i_Pixels);
+void ExpandGreyToRGBA(const uint8_t* i_Source, uint8_t* o_Destination, const size_t i_Pixels, const int i_Components);
+// Rounded v * 255 / 65535
+void Convert16To8(const uint16_t* i_Source, uint8_t* o_Destination, const size_t i_Count);
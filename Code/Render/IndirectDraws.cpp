@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <cstring>
+#include "IndirectDraws.h"
+
+#define BUFFER_OFFSET(i) ((char *)NULL + (i))
+
+static const size_t RecordFloats = DrawRecordTexels * 4;
+
+bool IndirectDraws::IsSupported() {
+    return glMultiDrawElementsIndirect && glTexBuffer && glVertexAttribDivisor;
+}
+
+bool IndirectDraws::Create() {
+    if (!IsSupported()) {
+        return false;
+    }
+
+    glGenBuffers(1, &DrawIndexBuffer);
+    glGenBuffers(1, &RecordBuffer);
+    glGenBuffers(1, &CommandBuffer);
+    glGenTextures(1, &RecordTexture);
+
+    // Texture keeps referring to the buffer object while its storage is replaced every frame
+    glBindBuffer(GL_TEXTURE_BUFFER, RecordBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, RecordFloats * sizeof(float), nullptr, GL_STREAM_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, RecordTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, RecordBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    return true;
+}
+
+void IndirectDraws::Destroy() {
+    if (CommandBuffer) {
+        glDeleteTextures(1, &RecordTexture);
+        glDeleteBuffers(1, &DrawIndexBuffer);
+        glDeleteBuffers(1, &RecordBuffer);
+        glDeleteBuffers(1, &CommandBuffer);
+    }
+    DrawIndexBuffer = 0;
+    RecordBuffer = 0;
+    RecordTexture = 0;
+    CommandBuffer = 0;
+    DrawCapacity = 0;
+    ClearBuckets();
+}
+
+void IndirectDraws::ClearBuckets() {
+    Buckets.clear();
+    BucketLookup.clear();
+    BucketOrder.clear();
+}
+
+int IndirectDraws::Bucket(const GLuint i_VertexArray, const GLenum i_Mode, const GLenum i_IndexType, const int i_Material) {
+    const std::pair<std::pair<GLuint, int>, std::pair<GLenum, GLenum>> key(std::make_pair(i_VertexArray, i_Material), std::make_pair(i_Mode, i_IndexType));
+    auto found = BucketLookup.find(key);
+    if (found != BucketLookup.end()) {
+        return found->second;
+    }
+
+    const BucketState bucket = { i_VertexArray, i_Mode, i_IndexType, i_Material };
+    Buckets.push_back(bucket);
+    BucketLookup[key] = (int)Buckets.size() - 1;
+    return (int)Buckets.size() - 1;
+}
+
+bool IndirectDraws::Reserve(const size_t i_Draws, const size_t i_Commands, GeometryBuffers& io_Geometry) {
+    if (!IsCreated()) {
+        return false;
+    }
+
+    GLint max_texels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+    const size_t max_draws = (size_t)max_texels / DrawRecordTexels;
+    if (i_Draws > max_draws) {
+        return false;
+    }
+
+    // Capacity doubles, so streaming the scene in piece by piece rewrites the draw index stream only a few times
+    if (i_Draws > DrawCapacity || DrawCapacity == 0) {
+        size_t capacity = DrawCapacity ? DrawCapacity : MinIndirectDraws;
+        while (capacity < i_Draws) {
+            capacity *= 2;
+        }
+        capacity = capacity < max_draws ? capacity : max_draws;
+
+        std::vector<uint32_t> indices(capacity);
+        for (size_t i = 0; i < capacity; ++i) {
+            indices[i] = (uint32_t)i;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, DrawIndexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        Records.resize(capacity * RecordFloats);
+        DrawCapacity = capacity;
+    }
+    io_Geometry.SetDrawIndexStream(DrawIndexBuffer);
+
+    // Frames then never grow any array
+    Pending.reserve(i_Commands);
+    PendingBuckets.reserve(i_Commands);
+    Sorted.reserve(i_Commands);
+    BucketFirst.resize(Buckets.size() + 1);
+    BucketCursor.resize(Buckets.size());
+
+    BucketOrder.resize(Buckets.size());
+    for (size_t i = 0; i < Buckets.size(); ++i) {
+        BucketOrder[i] = (int)i;
+    }
+    std::sort(BucketOrder.begin(), BucketOrder.end(), [this](const int a, const int b) {
+        if (Buckets[a].Material != Buckets[b].Material) {
+            return Buckets[a].Material < Buckets[b].Material;
+        }
+        return Buckets[a].VertexArray < Buckets[b].VertexArray;
+    });
+    return true;
+}
+
+void IndirectDraws::BeginFrame() {
+    DrawCount = 0;
+    Pending.clear();
+    PendingBuckets.clear();
+}
+
+int IndirectDraws::AddDraw(const float* i_MVP, const float* i_ModelView, const float* i_PositionScale, const float* i_PositionOffset) {
+    // Matrices are column major like uniform uploads, vectors take a whole texel each
+    float* record = &Records[DrawCount * RecordFloats];
+    memcpy(record, i_MVP, 16 * sizeof(float));
+    memcpy(record + 16, i_ModelView, 16 * sizeof(float));
+    memcpy(record + 32, i_PositionScale, 3 * sizeof(float));
+    record[35] = 0.0f;
+    memcpy(record + 36, i_PositionOffset, 3 * sizeof(float));
+    record[39] = 0.0f;
+    return (int)DrawCount++;
+}
+
+void IndirectDraws::AddCommand(const int i_Bucket, const GLsizei i_IndexCount, const GLuint i_FirstIndex, const GLint i_BaseVertex, const int i_Draw) {
+    const DrawElementsIndirectCommand command = { (GLuint)i_IndexCount, 1, i_FirstIndex, i_BaseVertex, (GLuint)i_Draw };
+    Pending.push_back(command);
+    PendingBuckets.push_back(i_Bucket);
+}
+
+void IndirectDraws::Submit(const MaterialLibrary& i_Materials, DrawStats& io_Stats) {
+    if (Pending.empty()) {
+        return;
+    }
+
+    // Counting sort by bucket
+    std::fill(BucketFirst.begin(), BucketFirst.end(), 0);
+    for (size_t i = 0; i < PendingBuckets.size(); ++i) {
+        BucketFirst[PendingBuckets[i] + 1]++;
+    }
+    for (size_t i = 1; i < BucketFirst.size(); ++i) {
+        BucketFirst[i] += BucketFirst[i - 1];
+    }
+    std::copy(BucketFirst.begin(), BucketFirst.end() - 1, BucketCursor.begin());
+    Sorted.resize(Pending.size());
+    for (size_t i = 0; i < Pending.size(); ++i) {
+        Sorted[BucketCursor[PendingBuckets[i]]++] = Pending[i];
+    }
+
+    // Previous storage may still be read by last frame's draws, orphaning gives fresh storage instead of a wait
+    glBindBuffer(GL_TEXTURE_BUFFER, RecordBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, DrawCapacity * RecordFloats * sizeof(float), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, DrawCount * RecordFloats * sizeof(float), Records.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, CommandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, Sorted.capacity() * sizeof(DrawElementsIndirectCommand), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, Sorted.size() * sizeof(DrawElementsIndirectCommand), Sorted.data());
+
+    glActiveTexture(GL_TEXTURE0 + DrawDataTextureUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, RecordTexture);
+
+    GLuint current_vertex_array = 0;
+    int current_material = -1;
+    for (size_t i = 0; i < BucketOrder.size(); ++i) {
+        const int b = BucketOrder[i];
+        const GLuint first = BucketFirst[b];
+        const GLsizei count = (GLsizei)(BucketFirst[b + 1] - first);
+        if (count == 0) {
+            continue;
+        }
+
+        const BucketState& bucket = Buckets[b];
+        if (bucket.Material != current_material) {
+            current_material = bucket.Material;
+            i_Materials.Bind(current_material);
+            io_Stats.MaterialBinds++;
+        }
+        if (bucket.VertexArray != current_vertex_array) {
+            current_vertex_array = bucket.VertexArray;
+            glBindVertexArray(current_vertex_array);
+            io_Stats.VertexArrayBinds++;
+        }
+        glMultiDrawElementsIndirect(bucket.Mode, bucket.IndexType, BUFFER_OFFSET(first * sizeof(DrawElementsIndirectCommand)), count, 0);
+
+        io_Stats.DrawCalls++;
+        io_Stats.IndirectCommands += count;
+        for (GLuint c = first; c < first + count; ++c) {
+            const GLuint indices = Sorted[c].Count;
+            if (bucket.Mode == GL_TRIANGLES) {
+                io_Stats.Triangles += indices / 3;
+            }
+            else if ((bucket.Mode == GL_TRIANGLE_STRIP || bucket.Mode == GL_TRIANGLE_FAN) && indices > 2) {
+                io_Stats.Triangles += indices - 2;
+            }
+        }
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+#include "OpenGLFunctions.h"
+#include "RenderStructs.h"
+#include "Materials.h"
+#include "GeometryBuffers.h"
+
+// Indirect draw predifinitions
+#define DrawRecordTexels 10                                 // RGBA32F texels of a draw record: MVP columns, model view columns, position scale, position offset
+#define DrawDataTextureUnit 6                               // Buffer texture of draw records, after material and G-Buffer units
+#define MinIndirectDraws 64                                 // Smallest record capacity, it doubles from there
+
+// Command layout read by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+	GLuint          Count;
+	GLuint          InstanceCount;                              // Always 1
+	GLuint          FirstIndex;
+	GLint           BaseVertex;
+	GLuint          BaseInstance;                               // Draw record of the command, arrives through the draw index stream
+};
+
+// Model draws of a frame submitted with one glMultiDrawElementsIndirect per bucket
+// A bucket groups draws that share vertex array, primitive mode, index type and material, everything else a draw
+// changes (matrices and dequantization) goes into a draw record the base pass fetches from a buffer texture
+// CPU cost per draw is writing a record and a command, GL calls only grow with the number of buckets
+class IndirectDraws {
+
+public:
+	// Multi draw indirect, buffer textures and instanced attributes (4.3 or the matching extensions)
+	static bool IsSupported();
+	bool Create();
+	void Destroy();
+	bool IsCreated() const { return CommandBuffer != 0; }
+
+	// Buckets are assigned while draw packets are compiled, forget them before packets are compiled again
+	void ClearBuckets();
+	// Bucket of given state, created on first use
+	int Bucket(const GLuint i_VertexArray, const GLenum i_Mode, const GLenum i_IndexType, const int i_Material);
+	// Room for given draw records and commands per frame, geometry vertex arrays get the draw index stream
+	// False when records would not fit a buffer texture, the model is then drawn packet by packet
+	bool Reserve(const size_t i_Draws, const size_t i_Commands, GeometryBuffers& io_Geometry);
+
+	// Frame: a record is added first, then the commands drawn with it
+	void BeginFrame();
+	int AddDraw(const float* i_MVP, const float* i_ModelView, const float* i_PositionScale, const float* i_PositionOffset);
+	void AddCommand(const int i_Bucket, const GLsizei i_IndexCount, const GLuint i_FirstIndex, const GLint i_BaseVertex, const int i_Draw);
+	// Upload records and commands and draw every bucket that got commands, base pass built with INDIRECT_DRAW has to be active
+	void Submit(const MaterialLibrary& i_Materials, DrawStats& io_Stats);
+
+	size_t BucketCount() const { return Buckets.size(); }
+
+private:
+	struct BucketState {
+		GLuint          VertexArray;
+		GLenum          Mode;
+		GLenum          IndexType;
+		int             Material;
+	};
+
+	GLuint          DrawIndexBuffer = 0;                        // 0, 1, 2... one entry per record
+	GLuint          RecordBuffer = 0;                           // Storage of RecordTexture, orphaned every frame
+	GLuint          RecordTexture = 0;
+	GLuint          CommandBuffer = 0;                          // Orphaned every frame
+	size_t          DrawCapacity = 0;
+	std::vector<BucketState> Buckets;
+	std::map<std::pair<std::pair<GLuint, int>, std::pair<GLenum, GLenum>>, int> BucketLookup; // (vertex array, material), (mode, index type) -> bucket
+	std::vector<int> BucketOrder;                               // Buckets sorted by material then vertex array, fewest binds
+	std::vector<float> Records;                                 // Records of the frame, sized to DrawCapacity
+	size_t          DrawCount = 0;
+	std::vector<DrawElementsIndirectCommand> Pending;           // Commands of the frame in packet order
+	std::vector<int> PendingBuckets;
+	std::vector<DrawElementsIndirectCommand> Sorted;            // Same commands grouped by bucket, packet order inside a bucket
+	std::vector<GLuint> BucketFirst;                            // First command of every bucket in Sorted, one extra entry at the end
+	std::vector<GLuint> BucketCursor;
+};
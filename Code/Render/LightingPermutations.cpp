@@ -0,0 +1,87 @@
+#include "LightingPermutations.h"
+#include <cstring>
+
+static const char* LightingQualityNames[LightingQualityCount] = { "low", "medium", "high" };
+
+const char* LightingQualityName(const LightingQuality i_Quality) {
+    return i_Quality >= 0 && i_Quality < LightingQualityCount ? LightingQualityNames[i_Quality] : "unknown";
+}
+
+bool LightingQualityFromName(const char* i_Name, LightingQuality& o_Quality) {
+    for (int i = 0; i < LightingQualityCount; ++i) {
+        if (strcmp(i_Name, LightingQualityNames[i]) == 0) {
+            o_Quality = (LightingQuality)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+LightingFeatures LightingFeatures::Preset(const LightingQuality i_Quality) {
+    LightingFeatures features;
+    switch (i_Quality) {
+        case LightingQualityLow: {
+            features.AO = false;
+            features.SSDOSamples = 0;
+            features.BRDF = LightingBRDFPhong;
+            features.Fog = false;
+            break;
+        }
+        case LightingQualityMedium: {
+            features.SSDOSamples = 4;
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+    return features;
+}
+
+uint32_t LightingFeatures::Key() const {
+    // Sample count only matters with AO on
+    const int samples = !AO ? 0 : (SSDOSamples < 1 ? 1 : (SSDOSamples > MaxSSDOSamples ? MaxSSDOSamples : SSDOSamples));
+    return (uint32_t)samples | (AO ? 1u << 4 : 0u) | ((uint32_t)BRDF << 5) | (Fog ? 1u << 7 : 0u);
+}
+
+std::string LightingFeatures::Defines() const {
+    const uint32_t key = Key();
+    return "#define AO " + std::to_string((key >> 4) & 1u) + "\n" +
+        "#define SSDO_SAMPLES " + std::to_string(key & 15u) + "\n" +
+        "#define BRDF_MODEL " + std::to_string((key >> 5) & 3u) + "\n" +
+        "#define FOG " + std::to_string((key >> 7) & 1u) + "\n";
+}
+
+void LightingPermutations::Destroy() {
+    for (std::map<uint32_t, LightingVariant>::iterator it = Variants.begin(); it != Variants.end(); ++it) {
+        glDeleteProgram(it->second.Program);
+    }
+    Variants.clear();
+}
+
+const LightingVariant* LightingPermutations::Get(const LightingFeatures& i_Features) {
+    const uint32_t key = i_Features.Key();
+    std::map<uint32_t, LightingVariant>::iterator found = Variants.find(key);
+    if (found != Variants.end()) {
+        return &found->second;
+    }
+
+    LightingVariant variant;
+    variant.Program = Build ? Build(i_Features.Defines()) : 0;
+    if (!variant.Program) {
+        return nullptr;
+    }
+    variant.ColorTextureHandle = glGetUniformLocation(variant.Program, "uColor");
+    variant.NormalTextureHandle = glGetUniformLocation(variant.Program, "uNormal");
+    variant.PositionTextureHandle = glGetUniformLocation(variant.Program, "uPosition");
+    variant.LightDistanceHandle = glGetUniformLocation(variant.Program, "uLightDistance");
+    variant.PMatrixHandle = glGetUniformLocation(variant.Program, "uPMatrix");
+
+    // G-Buffer targets stay on units 1-3 for every variant
+    glUseProgram(variant.Program);
+    glUniform1i(variant.ColorTextureHandle, 1);
+    glUniform1i(variant.NormalTextureHandle, 2);
+    glUniform1i(variant.PositionTextureHandle, 3);
+
+    return &(Variants[key] = variant);
+}
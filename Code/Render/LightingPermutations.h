@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include "OpenGLFunctions.h"
+
+// Lighting permutation predifinitions
+#define MaxSSDOSamples 10                                   // Size of the hemisphere kernel in LightingPass.fp
+
+enum LightingBRDF {
+	LightingBRDFPhong = 0,                                  // Normalized Phong lobe
+	LightingBRDFMetalRough = 1,                             // Exponent and scale driven by metalness and roughness
+};
+
+enum LightingQuality {
+	LightingQualityLow = 0,
+	LightingQualityMedium,
+	LightingQualityHigh,
+	LightingQualityCount
+};
+
+// "low", "medium" or "high"
+const char* LightingQualityName(const LightingQuality i_Quality);
+bool LightingQualityFromName(const char* i_Name, LightingQuality& o_Quality);
+
+// Features compiled into a lighting pass variant, disabled ones are removed from the shader instead of skipped at runtime
+struct LightingFeatures {
+	bool            AO = true;                                  // SSDO with colored AO
+	int             SSDOSamples = 8;                            // Occlusion samples when AO is on
+	LightingBRDF    BRDF = LightingBRDFMetalRough;
+	bool            Fog = true;
+
+	// Feature set of a quality preset, high is what the shader does without injected defines
+	static LightingFeatures Preset(const LightingQuality i_Quality);
+
+	// Same key for every feature set that compiles to the same program
+	uint32_t Key() const;
+
+	// #define block injected after the #version line of both shader sources
+	std::string Defines() const;
+};
+
+// Program of one permutation with the uniform locations it was linked with
+struct LightingVariant {
+	GLuint          Program = 0;
+	GLint           ColorTextureHandle = -1;
+	GLint           NormalTextureHandle = -1;
+	GLint           PositionTextureHandle = -1;
+	GLint           LightDistanceHandle = -1;
+	GLint           PMatrixHandle = -1;                         // -1 in variants without AO
+};
+
+// Lighting pass programs specialized by feature set, a variant is built the first time it is asked for and kept until Destroy
+class LightingPermutations {
+
+public:
+	// Builds a linked program from given define block, 0 when it fails
+	typedef std::function<GLuint(const std::string& i_Defines)> Builder;
+
+	void Create(const Builder& i_Build) { Build = i_Build; }
+	void Destroy();
+
+	// Variant for given features, nullptr when it could not be built
+	// New variants get their G-Buffer sampler units assigned, the variant is left bound
+	const LightingVariant* Get(const LightingFeatures& i_Features);
+
+	size_t Count() const { return Variants.size(); }
+
+private:
+	Builder         Build;
+	std::map<uint32_t, LightingVariant> Variants;
+};
@@ -0,0 +1,114 @@
+#include "Materials.h"
+
+// Base pass texture units, lighting pass samples G-Buffer from units 1-3
+static const GLenum MaterialTextureUnits[MaterialSlotCount] = { 0, 5, 4 };
+
+// Default slot values: white, full occlusion term with rough dielectric, flat normal
+static const unsigned char MaterialDefaultTexels[MaterialSlotCount][4] = {
+    { 255, 255, 255, 255 },
+    { 255, 255, 0, 255 },
+    { 128, 128, 255, 255 },
+};
+
+// Image of a glTF texture index, -1 when there is none
+static int TextureImage(const tinygltf::Model& i_Model, const int i_Texture) {
+    if (i_Texture < 0 || i_Texture >= (int)i_Model.textures.size()) {
+        return -1;
+    }
+    const int image = i_Model.textures[i_Texture].source;
+    return image >= 0 && image < (int)i_Model.images.size() ? image : -1;
+}
+
+void MaterialLibrary::Build(const tinygltf::Model& i_Model) {
+    Materials.clear();
+    ImageUsed.assign(i_Model.images.size(), 0);
+    ImageContents.assign(i_Model.images.size(), MipContentLinear);
+    ImageTextures.assign(i_Model.images.size(), 0);
+
+    const MipContent slot_contents[MaterialSlotCount] = { MipContentSRGB, MipContentLinear, MipContentNormal };
+    for (size_t i = 0; i < i_Model.materials.size(); ++i) {
+        const tinygltf::Material& source = i_Model.materials[i];
+
+        Material material;
+        material.Images[MaterialSlotBaseColor] = TextureImage(i_Model, source.pbrMetallicRoughness.baseColorTexture.index);
+        material.Images[MaterialSlotPBR] = TextureImage(i_Model, source.pbrMetallicRoughness.metallicRoughnessTexture.index);
+        material.Images[MaterialSlotNormal] = TextureImage(i_Model, source.normalTexture.index);
+        // Occlusion is packed with roughness and metalness, a separate occlusion image is only a fallback
+        if (material.Images[MaterialSlotPBR] < 0) {
+            material.Images[MaterialSlotPBR] = TextureImage(i_Model, source.occlusionTexture.index);
+        }
+
+        for (int slot = 0; slot < MaterialSlotCount; ++slot) {
+            const int image = material.Images[slot];
+            if (image >= 0) {
+                ImageUsed[image] = 1;
+                ImageContents[image] = slot_contents[slot];
+            }
+        }
+        Materials.push_back(material);
+    }
+
+    Material default_material;
+    for (int slot = 0; slot < MaterialSlotCount; ++slot) {
+        default_material.Images[slot] = -1;
+    }
+    Materials.push_back(default_material);
+}
+
+void MaterialLibrary::CreateDefaults() {
+    glGenTextures(MaterialSlotCount, DefaultTextures);
+    for (int slot = 0; slot < MaterialSlotCount; ++slot) {
+        glBindTexture(GL_TEXTURE_2D, DefaultTextures[slot]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, MaterialDefaultTexels[slot]);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void MaterialLibrary::Destroy() {
+    for (size_t i = 0; i < ImageTextures.size(); ++i) {
+        if (ImageTextures[i]) {
+            glDeleteTextures(1, &ImageTextures[i]);
+        }
+    }
+    ImageTextures.assign(ImageTextures.size(), 0);
+
+    if (DefaultTextures[0]) {
+        glDeleteTextures(MaterialSlotCount, DefaultTextures);
+        for (int slot = 0; slot < MaterialSlotCount; ++slot) {
+            DefaultTextures[slot] = 0;
+        }
+    }
+}
+
+size_t MaterialLibrary::UploadedImages() const {
+    size_t count = 0;
+    for (size_t i = 0; i < ImageTextures.size(); ++i) {
+        count += ImageTextures[i] != 0;
+    }
+    return count;
+}
+
+void MaterialLibrary::Bind(const int i_Material) const {
+    const Material& material = Materials[i_Material];
+    for (int slot = 0; slot < MaterialSlotCount; ++slot) {
+        const int image = material.Images[slot];
+        // Images that failed to load or are still decoding sample the default
+        const GLuint texture = image >= 0 && ImageTextures[image] ? ImageTextures[image] : DefaultTextures[slot];
+        glActiveTexture(GL_TEXTURE0 + MaterialTextureUnits[slot]);
+        glBindTexture(GL_TEXTURE_2D, texture);
+    }
+}
+
+void MaterialLibrary::BindDefaults() const {
+    for (int slot = 0; slot < MaterialSlotCount; ++slot) {
+        glActiveTexture(GL_TEXTURE0 + MaterialTextureUnits[slot]);
+        glBindTexture(GL_TEXTURE_2D, DefaultTextures[slot]);
+    }
+}
+
+GLenum MaterialLibrary::TextureUnit(const MaterialSlot i_Slot) {
+    return MaterialTextureUnits[i_Slot];
+}
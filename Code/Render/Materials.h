@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "OpenGLFunctions.h"
+#include "MipChain.h"
+#include "../tinyGLTF/tiny_gltf.h"
+
+// Texture inputs of the base pass
+enum MaterialSlot {
+	MaterialSlotBaseColor = 0,                                  // Diffuse color, sRGB
+	MaterialSlotPBR,                                            // Occlusion, roughness, metalness
+	MaterialSlotNormal,                                         // Tangent space normal map
+	MaterialSlotCount
+};
+
+// Minification filter of material textures, benchmarks compare them
+enum MaterialFilter {
+	MaterialFilterBaseLevel = 0,                                // Bilinear from the base level only, as before mip chains
+	MaterialFilterTrilinear,
+	MaterialFilterAnisotropic,                                  // Trilinear with up to MaxMaterialAnisotropy samples, trilinear where unsupported
+	MaterialFilterCount
+};
+
+// Flat material, only what the base pass samples
+struct Material {
+	int32_t         Images[MaterialSlotCount];                  // glTF image index of every slot, -1 samples the slot default
+};
+
+// Material table built from glTF materials and a texture registry keyed by glTF image index
+// Every image is uploaded once no matter how many materials or primitives use it, draws refer to materials by index
+class MaterialLibrary {
+
+public:
+	// Fill material table and image usage from model materials, textures are not created yet
+	// One extra default material is appended for primitives without a material
+	void Build(const tinygltf::Model& i_Model);
+
+	// 1x1 textures sampled by slots without an image
+	void CreateDefaults();
+	void Destroy();
+
+	// Image is referenced by some material and needs a texture
+	bool IsImageUsed(const int i_Image) const { return i_Image >= 0 && i_Image < (int)ImageUsed.size() && ImageUsed[i_Image]; }
+	// How mip levels of the image are filtered, from the slot it is used in
+	MipContent ImageContent(const int i_Image) const { return ImageContents[i_Image]; }
+	// Register texture uploaded for an image, the library owns it from now on
+	void SetImageTexture(const int i_Image, const GLuint i_Texture) { ImageTextures[i_Image] = i_Texture; }
+	size_t UploadedImages() const;
+
+	// Table index of glTF primitive material
+	int MaterialIndex(const int i_GLTFMaterial) const { return i_GLTFMaterial >= 0 && i_GLTFMaterial < DefaultMaterial() ? i_GLTFMaterial : DefaultMaterial(); }
+	int DefaultMaterial() const { return (int)Materials.size() - 1; }
+	size_t Size() const { return Materials.size(); }
+
+	// Bind textures of a material to base pass texture units
+	void Bind(const int i_Material) const;
+	// Bind slot defaults, usable before the table is built
+	void BindDefaults() const;
+
+	// Texture unit every slot is sampled from in the base pass
+	static GLenum TextureUnit(const MaterialSlot i_Slot);
+
+private:
+	std::vector<Material> Materials;
+	std::vector<unsigned char> ImageUsed;
+	std::vector<MipContent> ImageContents;
+	std::vector<GLuint> ImageTextures;                          // 0 until uploaded
+	GLuint          DefaultTextures[MaterialSlotCount] = {};
+};
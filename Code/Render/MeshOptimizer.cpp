@@ -0,0 +1,529 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <vector>
+#include "GeometryBuffers.h"
+#include "../Utils/Hash.h"
+
+#define InvalidVertex 0xFFFFFFFFu
+#define ForsythValenceTableSize 32                          // Valence scores above this are taken from the last entry
+
+VertexCacheStats AnalyzeVertexCache(const uint32_t* i_Indices, const size_t i_IndexCount, const size_t i_VertexCount, const size_t i_CacheSize) {
+    VertexCacheStats stats;
+    stats.Triangles = i_IndexCount / 3;
+
+    // FIFO cache, a vertex stays in it for i_CacheSize misses
+    std::vector<size_t> inserted(i_VertexCount, 0);
+    std::vector<unsigned char> used(i_VertexCount, 0);
+    for (size_t i = 0; i < i_IndexCount; ++i) {
+        const uint32_t vertex = i_Indices[i];
+        if (vertex >= i_VertexCount) {
+            continue;
+        }
+        stats.Vertices += !used[vertex];
+        used[vertex] = 1;
+
+        if (!inserted[vertex] || stats.Misses + 1 - inserted[vertex] > i_CacheSize) {
+            stats.Misses++;
+            inserted[vertex] = stats.Misses;
+        }
+    }
+    return stats;
+}
+
+size_t WeldVertices(float* io_Vertices, const size_t i_VertexCount, const size_t i_Stride, uint32_t* io_Indices, const size_t i_IndexCount) {
+    const size_t vertex_bytes = i_Stride * sizeof(float);
+
+    // Open addressing table of unique vertices, at most half full
+    size_t table_size = 16;
+    while (table_size < i_VertexCount * 2) {
+        table_size <<= 1;
+    }
+    std::vector<uint32_t> table(table_size, InvalidVertex);
+    std::vector<uint32_t> remap(i_VertexCount);
+
+    size_t unique = 0;
+    for (size_t vertex = 0; vertex < i_VertexCount; ++vertex) {
+        const float* source = io_Vertices + vertex * i_Stride;
+        size_t slot = (size_t)HashBytes((const unsigned char*)source, vertex_bytes) & (table_size - 1);
+        while (true) {
+            if (table[slot] == InvalidVertex) {
+                // Unique vertices are moved down, never over one not visited yet
+                if (unique != vertex) {
+                    std::memmove(io_Vertices + unique * i_Stride, source, vertex_bytes);
+                }
+                table[slot] = (uint32_t)unique;
+                remap[vertex] = (uint32_t)unique++;
+                break;
+            }
+            if (std::memcmp(io_Vertices + table[slot] * i_Stride, source, vertex_bytes) == 0) {
+                remap[vertex] = table[slot];
+                break;
+            }
+            slot = (slot + 1) & (table_size - 1);
+        }
+    }
+
+    for (size_t i = 0; i < i_IndexCount; ++i) {
+        io_Indices[i] = remap[io_Indices[i]];
+    }
+    return unique;
+}
+
+// Score tables of Forsyth's algorithm: last triangle's vertices get a fixed score, older ones decay,
+// vertices with few triangles left are preferred so no lonely triangles are left behind
+struct ForsythScores {
+    float Cache[VertexCacheSize];
+    float Valence[ForsythValenceTableSize];
+
+    ForsythScores() {
+        for (int position = 0; position < VertexCacheSize; ++position) {
+            Cache[position] = position < 3 ? 0.75f : powf(1.0f - (float)(position - 3) / (VertexCacheSize - 3), 1.5f);
+        }
+        Valence[0] = 0.0f;
+        for (int valence = 1; valence < ForsythValenceTableSize; ++valence) {
+            Valence[valence] = 2.0f / sqrtf((float)valence);
+        }
+    }
+
+    float Vertex(const int i_CachePosition, const uint32_t i_Remaining) const {
+        if (i_Remaining == 0) {
+            return -1.0f;
+        }
+        const float cache = i_CachePosition >= 0 && i_CachePosition < VertexCacheSize ? Cache[i_CachePosition] : 0.0f;
+        return cache + Valence[i_Remaining < ForsythValenceTableSize ? i_Remaining : ForsythValenceTableSize - 1];
+    }
+};
+
+void OptimizeVertexCache(uint32_t* o_Indices, const uint32_t* i_Indices, const size_t i_IndexCount, const size_t i_VertexCount) {
+    static const ForsythScores scores;
+    const size_t face_count = i_IndexCount / 3;
+
+    // Triangles of every vertex, live ones are kept at the front of each list
+    std::vector<uint32_t> remaining(i_VertexCount, 0);
+    for (size_t i = 0; i < face_count * 3; ++i) {
+        remaining[i_Indices[i]]++;
+    }
+    std::vector<uint32_t> offsets(i_VertexCount + 1, 0);
+    for (size_t vertex = 0; vertex < i_VertexCount; ++vertex) {
+        offsets[vertex + 1] = offsets[vertex] + remaining[vertex];
+    }
+    std::vector<uint32_t> adjacency(face_count * 3);
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < face_count * 3; ++i) {
+        adjacency[fill[i_Indices[i]]++] = (uint32_t)(i / 3);
+    }
+
+    std::vector<int> cache_positions(i_VertexCount, -1);
+    std::vector<float> vertex_scores(i_VertexCount);
+    for (size_t vertex = 0; vertex < i_VertexCount; ++vertex) {
+        vertex_scores[vertex] = scores.Vertex(-1, remaining[vertex]);
+    }
+
+    std::vector<float> face_scores(face_count);
+    std::vector<unsigned char> emitted(face_count, 0);
+    size_t best_face = 0;
+    for (size_t face = 0; face < face_count; ++face) {
+        const uint32_t* triangle = i_Indices + face * 3;
+        face_scores[face] = vertex_scores[triangle[0]] + vertex_scores[triangle[1]] + vertex_scores[triangle[2]];
+        best_face = face_scores[face] > face_scores[best_face] ? face : best_face;
+    }
+
+    uint32_t cache[VertexCacheSize + 3];
+    uint32_t new_cache[VertexCacheSize + 3];
+    size_t cache_count = 0;
+    size_t input_cursor = 0;
+    for (size_t output = 0; output < face_count; ++output) {
+        // No triangle touches the cache, continue with the first one left in input order
+        if (best_face == (size_t)-1) {
+            while (emitted[input_cursor]) {
+                input_cursor++;
+            }
+            best_face = input_cursor;
+        }
+
+        const uint32_t* triangle = i_Indices + best_face * 3;
+        o_Indices[output * 3 + 0] = triangle[0];
+        o_Indices[output * 3 + 1] = triangle[1];
+        o_Indices[output * 3 + 2] = triangle[2];
+        emitted[best_face] = 1;
+
+        // Triangle vertices go to the front of the cache, the rest is pushed back
+        size_t new_count = 0;
+        for (int corner = 0; corner < 3; ++corner) {
+            const uint32_t vertex = triangle[corner];
+            uint32_t* faces = adjacency.data() + offsets[vertex];
+            for (uint32_t i = 0; i < remaining[vertex]; ++i) {
+                if (faces[i] == best_face) {
+                    faces[i] = faces[remaining[vertex] - 1];
+                    break;
+                }
+            }
+            remaining[vertex]--;
+            new_cache[new_count++] = vertex;
+        }
+        for (size_t i = 0; i < cache_count; ++i) {
+            const uint32_t vertex = cache[i];
+            if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2]) {
+                new_cache[new_count++] = vertex;
+            }
+        }
+
+        // Vertices past the cache size fall out but still get their scores lowered
+        for (size_t i = 0; i < new_count; ++i) {
+            const uint32_t vertex = new_cache[i];
+            cache_positions[vertex] = i < VertexCacheSize ? (int)i : -1;
+            vertex_scores[vertex] = scores.Vertex(cache_positions[vertex], remaining[vertex]);
+        }
+
+        // Best next triangle is one touching the cache
+        best_face = (size_t)-1;
+        float best_score = -1e30f;
+        for (size_t i = 0; i < new_count; ++i) {
+            const uint32_t vertex = new_cache[i];
+            const uint32_t* faces = adjacency.data() + offsets[vertex];
+            for (uint32_t j = 0; j < remaining[vertex]; ++j) {
+                const uint32_t* face = i_Indices + faces[j] * 3;
+                const float score = vertex_scores[face[0]] + vertex_scores[face[1]] + vertex_scores[face[2]];
+                face_scores[faces[j]] = score;
+                if (score > best_score) {
+                    best_score = score;
+                    best_face = faces[j];
+                }
+            }
+        }
+
+        cache_count = new_count < VertexCacheSize ? new_count : VertexCacheSize;
+        std::memcpy(cache, new_cache, cache_count * sizeof(uint32_t));
+    }
+}
+
+void OptimizeOverdraw(uint32_t* o_Indices, const uint32_t* i_Indices, const size_t i_IndexCount, const float* i_Positions, const size_t i_Stride, const size_t i_VertexCount) {
+    const size_t face_count = i_IndexCount / 3;
+
+    // Cluster boundaries where the cache restarts, a triangle missing on all three vertices
+    std::vector<size_t> clusters;
+    std::vector<size_t> inserted(i_VertexCount, 0);
+    size_t misses = 0;
+    for (size_t face = 0; face < face_count; ++face) {
+        size_t face_misses = 0;
+        for (int corner = 0; corner < 3; ++corner) {
+            const uint32_t vertex = i_Indices[face * 3 + corner];
+            if (!inserted[vertex] || misses + 1 - inserted[vertex] > VertexCacheAnalysisSize) {
+                inserted[vertex] = ++misses;
+                face_misses++;
+            }
+        }
+        if (face == 0 || face_misses == 3) {
+            clusters.push_back(face);
+        }
+    }
+    clusters.push_back(face_count);
+
+    // Area weighted centroid and normal of every cluster and of the whole mesh
+    const size_t cluster_count = clusters.size() - 1;
+    std::vector<std::array<float, 6>> cluster_data(cluster_count);
+    float mesh_centroid[3] = { 0.0f, 0.0f, 0.0f };
+    float mesh_area = 0.0f;
+    for (size_t cluster = 0; cluster < cluster_count; ++cluster) {
+        float centroid[3] = { 0.0f, 0.0f, 0.0f };
+        float normal[3] = { 0.0f, 0.0f, 0.0f };
+        float area = 0.0f;
+        for (size_t face = clusters[cluster]; face < clusters[cluster + 1]; ++face) {
+            const float* a = i_Positions + i_Indices[face * 3 + 0] * i_Stride;
+            const float* b = i_Positions + i_Indices[face * 3 + 1] * i_Stride;
+            const float* c = i_Positions + i_Indices[face * 3 + 2] * i_Stride;
+            const float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            const float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+            const float cross[3] = { ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0] };
+            const float face_area = sqrtf(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+            for (int axis = 0; axis < 3; ++axis) {
+                centroid[axis] += (a[axis] + b[axis] + c[axis]) * (face_area / 3.0f);
+                normal[axis] += cross[axis];
+            }
+            area += face_area;
+        }
+        for (int axis = 0; axis < 3; ++axis) {
+            mesh_centroid[axis] += centroid[axis];
+            cluster_data[cluster][axis] = area > 0.0f ? centroid[axis] / area : 0.0f;
+            cluster_data[cluster][3 + axis] = normal[axis];
+        }
+        mesh_area += area;
+    }
+    for (int axis = 0; axis < 3; ++axis) {
+        mesh_centroid[axis] = mesh_area > 0.0f ? mesh_centroid[axis] / mesh_area : 0.0f;
+    }
+
+    // Clusters facing away from the mesh center are on the outside and occlude the rest
+    std::vector<std::pair<float, size_t>> order(cluster_count);
+    for (size_t cluster = 0; cluster < cluster_count; ++cluster) {
+        const std::array<float, 6>& data = cluster_data[cluster];
+        const float length = sqrtf(data[3] * data[3] + data[4] * data[4] + data[5] * data[5]);
+        float facing = 0.0f;
+        for (int axis = 0; axis < 3; ++axis) {
+            facing += (data[axis] - mesh_centroid[axis]) * data[3 + axis];
+        }
+        order[cluster] = std::make_pair(length > 0.0f ? -facing / length : 0.0f, cluster);
+    }
+    std::stable_sort(order.begin(), order.end());
+
+    size_t output = 0;
+    for (size_t i = 0; i < cluster_count; ++i) {
+        const size_t cluster = order[i].second;
+        const size_t count = (clusters[cluster + 1] - clusters[cluster]) * 3;
+        std::memcpy(o_Indices + output, i_Indices + clusters[cluster] * 3, count * sizeof(uint32_t));
+        output += count;
+    }
+}
+
+size_t OptimizeVertexFetch(float* o_Vertices, uint32_t* io_Indices, const size_t i_IndexCount, const float* i_Vertices, const size_t i_VertexCount, const size_t i_Stride) {
+    std::vector<uint32_t> remap(i_VertexCount, InvalidVertex);
+    size_t next = 0;
+    for (size_t i = 0; i < i_IndexCount; ++i) {
+        const uint32_t vertex = io_Indices[i];
+        if (remap[vertex] == InvalidVertex) {
+            std::memcpy(o_Vertices + next * i_Stride, i_Vertices + vertex * i_Stride, i_Stride * sizeof(float));
+            remap[vertex] = (uint32_t)next++;
+        }
+        io_Indices[i] = remap[vertex];
+    }
+    return next;
+}
+
+// Append bytes to a buffer at 4 byte alignment, returns their offset
+static size_t AppendAligned(std::vector<unsigned char>& io_Buffer, const void* i_Data, const size_t i_Size) {
+    io_Buffer.resize((io_Buffer.size() + 3) & ~(size_t)3, 0);
+    const size_t offset = io_Buffer.size();
+    io_Buffer.insert(io_Buffer.end(), (const unsigned char*)i_Data, (const unsigned char*)i_Data + i_Size);
+    return offset;
+}
+
+static void AccumulateStats(VertexCacheStats& io_Total, const VertexCacheStats& i_Stats) {
+    io_Total.Triangles += i_Stats.Triangles;
+    io_Total.Vertices += i_Stats.Vertices;
+    io_Total.Misses += i_Stats.Misses;
+}
+
+bool OptimizeModelMeshes(tinygltf::Model& io_Model, MeshOptimizationStats& o_Stats) {
+    BufferSpans buffers(io_Model.buffers.size());
+    for (size_t i = 0; i < io_Model.buffers.size(); ++i) {
+        buffers[i] = std::make_pair(io_Model.buffers[i].data.data(), io_Model.buffers[i].data.size());
+    }
+
+    // Same grouping as geometry upload: accessors of every attribute, indices and mode
+    typedef std::array<int, VertexAttributeCount + 2> GeometryKey;
+    const char* attribute_names[VertexAttributeCount] = { "POSITION", "TEXCOORD_0", "NORMAL" };
+    std::map<GeometryKey, std::vector<tinygltf::Primitive*>> groups;
+    for (size_t mesh = 0; mesh < io_Model.meshes.size(); ++mesh) {
+        for (size_t i = 0; i < io_Model.meshes[mesh].primitives.size(); ++i) {
+            tinygltf::Primitive& primitive = io_Model.meshes[mesh].primitives[i];
+            GeometryKey key;
+            for (int attribute = 0; attribute < VertexAttributeCount; ++attribute) {
+                auto found = primitive.attributes.find(attribute_names[attribute]);
+                key[attribute] = found != primitive.attributes.end() ? found->second : -1;
+            }
+            key[VertexAttributeCount] = primitive.indices;
+            key[VertexAttributeCount + 1] = primitive.mode;
+            groups[key].push_back(&primitive);
+        }
+    }
+
+    const int buffer_index = (int)io_Model.buffers.size();
+    tinygltf::Buffer output;
+    std::vector<float> vertices, optimized_vertices;
+    std::vector<uint32_t> indices, cache_order, overdraw_order;
+    for (auto it = groups.begin(); it != groups.end(); ++it) {
+        const GeometryKey& key = it->first;
+        const int mode = key[VertexAttributeCount + 1];
+        if (key[0] < 0 || (mode >= 0 && mode != TINYGLTF_MODE_TRIANGLES)) {
+            continue;
+        }
+        // Accessor indices and ranges come from the file, primitives referencing anything outside the model are left as they are
+        bool readable = true;
+        for (int entry = 0; entry <= VertexAttributeCount; ++entry) {
+            readable = readable && (key[entry] < 0 || IsAccessorReadable(io_Model, buffers, key[entry]));
+        }
+        if (!readable || io_Model.accessors[key[0]].count == 0) {
+            continue;
+        }
+        const size_t vertex_count = io_Model.accessors[key[0]].count;
+
+        uint32_t attributes = 0;
+        for (int attribute = 0; attribute < VertexAttributeCount; ++attribute) {
+            if (key[attribute] >= 0 && io_Model.accessors[key[attribute]].count == vertex_count) {
+                attributes |= 1u << attribute;
+            }
+        }
+        const size_t stride = GeometryBuffers::Stride(attributes) / sizeof(float);
+        const int components[VertexAttributeCount] = { 3, 2, 3 };
+        vertices.assign(vertex_count * stride, 0.0f);
+        size_t offset = 0;
+        bool valid = true;
+        for (int attribute = 0; attribute < VertexAttributeCount; ++attribute) {
+            if (attributes & (1u << attribute)) {
+                valid = valid && ReadAccessorFloats(io_Model, buffers, key[attribute], components[attribute], vertices.data() + offset, stride);
+                offset += components[attribute];
+            }
+        }
+
+        const bool was_narrow = key[VertexAttributeCount] >= 0 && io_Model.accessors[key[VertexAttributeCount]].componentType != TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT;
+        if (key[VertexAttributeCount] >= 0) {
+            indices.resize(io_Model.accessors[key[VertexAttributeCount]].count);
+            valid = valid && ReadAccessorIndices(io_Model, buffers, key[VertexAttributeCount], indices.data());
+        }
+        else {
+            indices.resize(vertex_count);
+            for (size_t i = 0; i < vertex_count; ++i) {
+                indices[i] = (uint32_t)i;
+            }
+        }
+        // Broken primitives are left for upload to report
+        for (size_t i = 0; valid && i < indices.size(); ++i) {
+            valid = indices[i] < vertex_count;
+        }
+        if (!valid || indices.empty() || indices.size() % 3 != 0) {
+            continue;
+        }
+        const size_t index_count = indices.size();
+        const VertexCacheStats before = AnalyzeVertexCache(indices.data(), index_count, vertex_count, VertexCacheAnalysisSize);
+
+        const size_t welded_count = WeldVertices(vertices.data(), vertex_count, stride, indices.data(), index_count);
+
+        cache_order.resize(index_count);
+        OptimizeVertexCache(cache_order.data(), indices.data(), index_count, welded_count);
+        // Overdraw order is kept only when it costs little vertex cache efficiency
+        overdraw_order.resize(index_count);
+        OptimizeOverdraw(overdraw_order.data(), cache_order.data(), index_count, vertices.data(), stride, welded_count);
+        const double cache_acmr = AnalyzeVertexCache(cache_order.data(), index_count, welded_count, VertexCacheAnalysisSize).ACMR();
+        const double overdraw_acmr = AnalyzeVertexCache(overdraw_order.data(), index_count, welded_count, VertexCacheAnalysisSize).ACMR();
+        std::vector<uint32_t>& order = overdraw_acmr <= cache_acmr * OverdrawCacheThreshold ? overdraw_order : cache_order;
+
+        optimized_vertices.resize(welded_count * stride);
+        const size_t optimized_count = OptimizeVertexFetch(optimized_vertices.data(), order.data(), index_count, vertices.data(), welded_count, stride);
+        const VertexCacheStats after = AnalyzeVertexCache(order.data(), index_count, optimized_count, VertexCacheAnalysisSize);
+
+        // Interleaved vertices in one view, bounds are recomputed since welding keeps only used vertices
+        tinygltf::BufferView vertex_view;
+        vertex_view.buffer = buffer_index;
+        vertex_view.byteOffset = AppendAligned(output.data, optimized_vertices.data(), optimized_count * stride * sizeof(float));
+        vertex_view.byteLength = optimized_count * stride * sizeof(float);
+        vertex_view.byteStride = stride * sizeof(float);
+        vertex_view.target = TINYGLTF_TARGET_ARRAY_BUFFER;
+        const int vertex_view_index = (int)io_Model.bufferViews.size();
+        io_Model.bufferViews.push_back(vertex_view);
+
+        int new_accessors[VertexAttributeCount] = { -1, -1, -1 };
+        offset = 0;
+        for (int attribute = 0; attribute < VertexAttributeCount; ++attribute) {
+            if (!(attributes & (1u << attribute))) {
+                continue;
+            }
+            tinygltf::Accessor accessor;
+            accessor.bufferView = vertex_view_index;
+            accessor.byteOffset = offset * sizeof(float);
+            accessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+            accessor.count = optimized_count;
+            accessor.type = components[attribute] == 2 ? TINYGLTF_TYPE_VEC2 : TINYGLTF_TYPE_VEC3;
+            if (attribute == 0) {
+                accessor.minValues.assign(3, 1e30);
+                accessor.maxValues.assign(3, -1e30);
+                for (size_t vertex = 0; vertex < optimized_count; ++vertex) {
+                    for (int axis = 0; axis < 3; ++axis) {
+                        const double value = optimized_vertices[vertex * stride + axis];
+                        accessor.minValues[axis] = value < accessor.minValues[axis] ? value : accessor.minValues[axis];
+                        accessor.maxValues[axis] = value > accessor.maxValues[axis] ? value : accessor.maxValues[axis];
+                    }
+                }
+            }
+            new_accessors[attribute] = (int)io_Model.accessors.size();
+            io_Model.accessors.push_back(accessor);
+            offset += components[attribute];
+        }
+
+        // 16 bit indices whenever the vertices allow it
+        tinygltf::Accessor index_accessor;
+        index_accessor.count = index_count;
+        index_accessor.type = TINYGLTF_TYPE_SCALAR;
+        tinygltf::BufferView index_view;
+        index_view.buffer = buffer_index;
+        index_view.target = TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER;
+        if (optimized_count <= 65536) {
+            std::vector<uint16_t> narrow(order.begin(), order.end());
+            index_accessor.componentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+            index_view.byteOffset = AppendAligned(output.data, narrow.data(), index_count * sizeof(uint16_t));
+            index_view.byteLength = index_count * sizeof(uint16_t);
+            o_Stats.NarrowedPrimitives += !was_narrow;
+        }
+        else {
+            index_accessor.componentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT;
+            index_view.byteOffset = AppendAligned(output.data, order.data(), index_count * sizeof(uint32_t));
+            index_view.byteLength = index_count * sizeof(uint32_t);
+        }
+        index_accessor.bufferView = (int)io_Model.bufferViews.size();
+        io_Model.bufferViews.push_back(index_view);
+        const int new_indices = (int)io_Model.accessors.size();
+        io_Model.accessors.push_back(index_accessor);
+
+        // Attributes render does not read are dropped so their buffers can be released
+        for (size_t i = 0; i < it->second.size(); ++i) {
+            tinygltf::Primitive& primitive = *it->second[i];
+            primitive.attributes.clear();
+            for (int attribute = 0; attribute < VertexAttributeCount; ++attribute) {
+                if (new_accessors[attribute] >= 0) {
+                    primitive.attributes[attribute_names[attribute]] = new_accessors[attribute];
+                }
+            }
+            primitive.indices = new_indices;
+            primitive.mode = TINYGLTF_MODE_TRIANGLES;
+            primitive.targets.clear();
+        }
+
+        o_Stats.Primitives++;
+        o_Stats.VerticesBefore += vertex_count;
+        o_Stats.VerticesAfter += optimized_count;
+        AccumulateStats(o_Stats.Before, before);
+        AccumulateStats(o_Stats.After, after);
+    }
+
+    if (!o_Stats.Primitives) {
+        return false;
+    }
+    output.uri.clear();
+    io_Model.buffers.push_back(output);
+
+    // Release source buffers nothing draws from anymore, image views of binary scenes still need theirs
+    std::vector<unsigned char> referenced(io_Model.buffers.size(), 0);
+    referenced[buffer_index] = 1;
+    const auto reference_accessor = [&](const int i_Accessor) {
+        if (i_Accessor >= 0 && i_Accessor < (int)io_Model.accessors.size()) {
+            const int view = io_Model.accessors[i_Accessor].bufferView;
+            if (view >= 0 && view < (int)io_Model.bufferViews.size() && io_Model.bufferViews[view].buffer >= 0) {
+                referenced[io_Model.bufferViews[view].buffer] = 1;
+            }
+        }
+    };
+    for (size_t mesh = 0; mesh < io_Model.meshes.size(); ++mesh) {
+        for (size_t i = 0; i < io_Model.meshes[mesh].primitives.size(); ++i) {
+            const tinygltf::Primitive& primitive = io_Model.meshes[mesh].primitives[i];
+            for (auto attribute = primitive.attributes.begin(); attribute != primitive.attributes.end(); ++attribute) {
+                reference_accessor(attribute->second);
+            }
+            reference_accessor(primitive.indices);
+        }
+    }
+    for (size_t i = 0; i < io_Model.images.size(); ++i) {
+        const int view = io_Model.images[i].bufferView;
+        if (view >= 0 && view < (int)io_Model.bufferViews.size() && io_Model.bufferViews[view].buffer >= 0) {
+            referenced[io_Model.bufferViews[view].buffer] = 1;
+        }
+    }
+    for (size_t i = 0; i < io_Model.buffers.size(); ++i) {
+        if (!referenced[i]) {
+            std::vector<unsigned char>().swap(io_Model.buffers[i].data);
+        }
+    }
+    return true;
+}
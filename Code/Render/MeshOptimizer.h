@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "../tinyGLTF/tiny_gltf.h"
+
+// Mesh optimizer predifinitions
+#define MeshOptimizerVersion 1                              // Part of cooked scene key, bump whenever output changes
+#define VertexCacheSize 32                                  // LRU cache the Forsyth vertex scores are tuned for
+#define VertexCacheAnalysisSize 16                          // FIFO post-transform cache used for ACMR/ATVR and clustering
+#define OverdrawCacheThreshold 1.05                         // Cluster reordering may raise ACMR at most by this factor
+
+// Post-transform cache efficiency of an index list
+struct VertexCacheStats {
+	size_t          Triangles = 0;
+	size_t          Vertices = 0;                               // Referenced vertices
+	size_t          Misses = 0;                                 // Vertex shader invocations
+
+	double ACMR() const { return Triangles ? (double)Misses / Triangles : 0.0; }   // Average cache miss ratio, 0.5 - 3
+	double ATVR() const { return Vertices ? (double)Misses / Vertices : 0.0; }     // Average transformed vertex ratio, 1 is ideal
+};
+
+// Totals over every optimized primitive
+struct MeshOptimizationStats {
+	size_t          Primitives = 0;
+	size_t          VerticesBefore = 0;
+	size_t          VerticesAfter = 0;
+	size_t          NarrowedPrimitives = 0;                     // Primitives whose indices went from 32 bit (or none) to 16 bit
+	VertexCacheStats Before;
+	VertexCacheStats After;
+};
+
+VertexCacheStats AnalyzeVertexCache(const uint32_t* i_Indices, const size_t i_IndexCount, const size_t i_VertexCount, const size_t i_CacheSize);
+
+// Merge bitwise identical interleaved vertices, vertices are compacted in place, returns new vertex count
+size_t WeldVertices(float* io_Vertices, const size_t i_VertexCount, const size_t i_Stride, uint32_t* io_Indices, const size_t i_IndexCount);
+
+// Triangle order for the post-transform cache, Tom Forsyth's linear-speed vertex cache optimization
+void OptimizeVertexCache(uint32_t* o_Indices, const uint32_t* i_Indices, const size_t i_IndexCount, const size_t i_VertexCount);
+
+// Split cache ordered triangles into clusters at cache restarts and draw outward facing clusters first
+// i_Positions are the first 3 floats of every i_Stride floats
+void OptimizeOverdraw(uint32_t* o_Indices, const uint32_t* i_Indices, const size_t i_IndexCount, const float* i_Positions, const size_t i_Stride, const size_t i_VertexCount);
+
+// Renumber vertices in order of first use and drop unused ones, returns vertex count written to o_Vertices
+size_t OptimizeVertexFetch(float* o_Vertices, uint32_t* io_Indices, const size_t i_IndexCount, const float* i_Vertices, const size_t i_VertexCount, const size_t i_Stride);
+
+// Weld, reorder and remap every triangle primitive, geometry is rewritten into one new interleaved buffer
+// with 16 bit indices where the vertex count allows, buffers no longer referenced are released
+// Only attributes the render reads are kept, false when nothing was optimized
+bool OptimizeModelMeshes(tinygltf::Model& io_Model, MeshOptimizationStats& o_Stats);
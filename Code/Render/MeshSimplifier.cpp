@@ -0,0 +1,298 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#define MinCollapseNormalCos 0.25f                          // Collapse may not turn a triangle normal further than this
+
+// Symmetric 4x4 plane quadric, weighted by triangle area
+struct Quadric {
+    float           A00 = 0.0f, A11 = 0.0f, A22 = 0.0f;
+    float           A01 = 0.0f, A02 = 0.0f, A12 = 0.0f;
+    float           B0 = 0.0f, B1 = 0.0f, B2 = 0.0f;
+    float           C = 0.0f;
+    float           Weight = 0.0f;
+};
+
+// Candidate collapse of vertex From onto vertex To
+struct Collapse {
+    uint32_t        From;
+    uint32_t        To;
+    float           Error;                                      // Squared distance, relative to mesh extent
+};
+
+static void AddPlaneQuadric(Quadric& io_Quadric, const float* i_Normal, const float i_Distance, const float i_Weight) {
+    const float a = i_Normal[0], b = i_Normal[1], c = i_Normal[2], d = i_Distance;
+    io_Quadric.A00 += a * a * i_Weight;
+    io_Quadric.A11 += b * b * i_Weight;
+    io_Quadric.A22 += c * c * i_Weight;
+    io_Quadric.A01 += a * b * i_Weight;
+    io_Quadric.A02 += a * c * i_Weight;
+    io_Quadric.A12 += b * c * i_Weight;
+    io_Quadric.B0 += a * d * i_Weight;
+    io_Quadric.B1 += b * d * i_Weight;
+    io_Quadric.B2 += c * d * i_Weight;
+    io_Quadric.C += d * d * i_Weight;
+    io_Quadric.Weight += i_Weight;
+}
+
+static void AddQuadric(Quadric& io_Quadric, const Quadric& i_Quadric) {
+    io_Quadric.A00 += i_Quadric.A00;
+    io_Quadric.A11 += i_Quadric.A11;
+    io_Quadric.A22 += i_Quadric.A22;
+    io_Quadric.A01 += i_Quadric.A01;
+    io_Quadric.A02 += i_Quadric.A02;
+    io_Quadric.A12 += i_Quadric.A12;
+    io_Quadric.B0 += i_Quadric.B0;
+    io_Quadric.B1 += i_Quadric.B1;
+    io_Quadric.B2 += i_Quadric.B2;
+    io_Quadric.C += i_Quadric.C;
+    io_Quadric.Weight += i_Quadric.Weight;
+}
+
+// Average squared distance of a point to the planes of the quadric
+static float QuadricError(const Quadric& i_Quadric, const float* i_Point) {
+    const float x = i_Point[0], y = i_Point[1], z = i_Point[2];
+    const float rx = i_Quadric.A00 * x + i_Quadric.A01 * y + i_Quadric.A02 * z;
+    const float ry = i_Quadric.A01 * x + i_Quadric.A11 * y + i_Quadric.A12 * z;
+    const float rz = i_Quadric.A02 * x + i_Quadric.A12 * y + i_Quadric.A22 * z;
+    const float error = rx * x + ry * y + rz * z + 2.0f * (i_Quadric.B0 * x + i_Quadric.B1 * y + i_Quadric.B2 * z) + i_Quadric.C;
+    return fabsf(error) / (i_Quadric.Weight > 0.0f ? i_Quadric.Weight : 1.0f);
+}
+
+static void TriangleNormal(const float* i_A, const float* i_B, const float* i_C, float* o_Normal) {
+    const float ab[3] = { i_B[0] - i_A[0], i_B[1] - i_A[1], i_B[2] - i_A[2] };
+    const float ac[3] = { i_C[0] - i_A[0], i_C[1] - i_A[1], i_C[2] - i_A[2] };
+    o_Normal[0] = ab[1] * ac[2] - ab[2] * ac[1];
+    o_Normal[1] = ab[2] * ac[0] - ab[0] * ac[2];
+    o_Normal[2] = ab[0] * ac[1] - ab[1] * ac[0];
+}
+
+// Moving From onto To would turn some remaining triangle around or too far
+static bool CollapseFlips(const Collapse& i_Collapse, const uint32_t* i_Indices, const uint32_t* i_Faces, const size_t i_FaceCount, const std::vector<float>& i_Positions) {
+    for (size_t i = 0; i < i_FaceCount; ++i) {
+        const uint32_t* face = i_Indices + i_Faces[i] * 3;
+        if (face[0] == i_Collapse.To || face[1] == i_Collapse.To || face[2] == i_Collapse.To) {
+            continue;
+        }
+
+        const float* before[3];
+        const float* after[3];
+        for (int corner = 0; corner < 3; ++corner) {
+            before[corner] = &i_Positions[face[corner] * 3];
+            after[corner] = face[corner] == i_Collapse.From ? &i_Positions[i_Collapse.To * 3] : before[corner];
+        }
+        float normal_before[3], normal_after[3];
+        TriangleNormal(before[0], before[1], before[2], normal_before);
+        TriangleNormal(after[0], after[1], after[2], normal_after);
+        // Triangles turning more than ~75 degrees are flips or slivers about to become one
+        const float dot = normal_before[0] * normal_after[0] + normal_before[1] * normal_after[1] + normal_before[2] * normal_after[2];
+        const float before_length = normal_before[0] * normal_before[0] + normal_before[1] * normal_before[1] + normal_before[2] * normal_before[2];
+        const float after_length = normal_after[0] * normal_after[0] + normal_after[1] * normal_after[1] + normal_after[2] * normal_after[2];
+        if (dot <= 0.0f || dot * dot < MinCollapseNormalCos * MinCollapseNormalCos * before_length * after_length) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Link condition: endpoints of an interior edge may share only the two vertices opposite to it
+static bool KeepsManifold(const Collapse& i_Collapse, const uint32_t* i_Indices, const uint32_t* i_FromFaces, const size_t i_FromFaceCount,
+    const uint32_t* i_ToFaces, const size_t i_ToFaceCount, std::vector<uint32_t>& io_Ring) {
+    io_Ring.clear();
+    for (size_t i = 0; i < i_FromFaceCount; ++i) {
+        for (int corner = 0; corner < 3; ++corner) {
+            const uint32_t vertex = i_Indices[i_FromFaces[i] * 3 + corner];
+            if (vertex != i_Collapse.From && vertex != i_Collapse.To && std::find(io_Ring.begin(), io_Ring.end(), vertex) == io_Ring.end()) {
+                io_Ring.push_back(vertex);
+            }
+        }
+    }
+
+    size_t shared = 0;
+    for (size_t i = 0; i < io_Ring.size(); ++i) {
+        for (size_t j = 0; j < i_ToFaceCount; ++j) {
+            const uint32_t* face = i_Indices + i_ToFaces[j] * 3;
+            if (face[0] == io_Ring[i] || face[1] == io_Ring[i] || face[2] == io_Ring[i]) {
+                shared++;
+                break;
+            }
+        }
+    }
+    return shared <= 2;
+}
+
+size_t SimplifyMesh(uint32_t* o_Indices, const uint32_t* i_Indices, const size_t i_IndexCount, const float* i_Positions, const size_t i_Stride, const size_t i_VertexCount,
+    const size_t i_TargetIndexCount, const float i_TargetError, float* o_Error) {
+    size_t index_count = i_IndexCount - i_IndexCount % 3;
+    std::memcpy(o_Indices, i_Indices, index_count * sizeof(uint32_t));
+    *o_Error = 0.0f;
+
+    // Positions scaled to unit extent so errors do not depend on model units
+    float minimum[3] = { 1e30f, 1e30f, 1e30f };
+    float maximum[3] = { -1e30f, -1e30f, -1e30f };
+    for (size_t vertex = 0; vertex < i_VertexCount; ++vertex) {
+        for (int axis = 0; axis < 3; ++axis) {
+            const float value = i_Positions[vertex * i_Stride + axis];
+            minimum[axis] = value < minimum[axis] ? value : minimum[axis];
+            maximum[axis] = value > maximum[axis] ? value : maximum[axis];
+        }
+    }
+    float extent = 0.0f;
+    for (int axis = 0; axis < 3; ++axis) {
+        extent = maximum[axis] - minimum[axis] > extent ? maximum[axis] - minimum[axis] : extent;
+    }
+    if (index_count <= i_TargetIndexCount || extent <= 0.0f) {
+        return index_count;
+    }
+    std::vector<float> positions(i_VertexCount * 3);
+    for (size_t vertex = 0; vertex < i_VertexCount; ++vertex) {
+        for (int axis = 0; axis < 3; ++axis) {
+            positions[vertex * 3 + axis] = (i_Positions[vertex * i_Stride + axis] - minimum[axis]) / extent;
+        }
+    }
+
+    // Vertices sharing a position with another vertex are attribute seams, moving them would open cracks
+    std::vector<unsigned char> locked(i_VertexCount, 0);
+    std::vector<uint32_t> by_position(i_VertexCount);
+    for (size_t vertex = 0; vertex < i_VertexCount; ++vertex) {
+        by_position[vertex] = (uint32_t)vertex;
+    }
+    std::sort(by_position.begin(), by_position.end(), [&positions](const uint32_t i_A, const uint32_t i_B) {
+        return std::memcmp(&positions[i_A * 3], &positions[i_B * 3], 3 * sizeof(float)) < 0;
+    });
+    for (size_t i = 1; i < i_VertexCount; ++i) {
+        if (std::memcmp(&positions[by_position[i - 1] * 3], &positions[by_position[i] * 3], 3 * sizeof(float)) == 0) {
+            locked[by_position[i - 1]] = 1;
+            locked[by_position[i]] = 1;
+        }
+    }
+
+    // Border and non-manifold edges lock their vertices, a directed edge must appear once with its opposite once
+    std::vector<uint64_t> edges(index_count);
+    for (size_t i = 0; i < index_count; ++i) {
+        edges[i] = (uint64_t)o_Indices[i] << 32 | o_Indices[i % 3 == 2 ? i - 2 : i + 1];
+    }
+    std::sort(edges.begin(), edges.end());
+    for (size_t i = 0; i < index_count; ++i) {
+        const uint32_t a = (uint32_t)(edges[i] >> 32);
+        const uint32_t b = (uint32_t)edges[i];
+        const bool repeated = (i > 0 && edges[i - 1] == edges[i]) || (i + 1 < index_count && edges[i + 1] == edges[i]);
+        const auto opposite = std::equal_range(edges.begin(), edges.end(), (uint64_t)b << 32 | a);
+        if (repeated || opposite.second - opposite.first != 1) {
+            locked[a] = 1;
+            locked[b] = 1;
+        }
+    }
+
+    std::vector<Quadric> quadrics(i_VertexCount);
+    for (size_t face = 0; face < index_count / 3; ++face) {
+        const uint32_t* triangle = o_Indices + face * 3;
+        float normal[3];
+        TriangleNormal(&positions[triangle[0] * 3], &positions[triangle[1] * 3], &positions[triangle[2] * 3], normal);
+        const float area = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (area <= 0.0f) {
+            continue;
+        }
+        for (int axis = 0; axis < 3; ++axis) {
+            normal[axis] /= area;
+        }
+        const float* point = &positions[triangle[0] * 3];
+        const float distance = -(normal[0] * point[0] + normal[1] * point[1] + normal[2] * point[2]);
+        for (int corner = 0; corner < 3; ++corner) {
+            AddPlaneQuadric(quadrics[triangle[corner]], normal, distance, area);
+        }
+    }
+
+    // Passes of cheapest independent collapses until the target count or error is reached
+    const float target_error = i_TargetError * i_TargetError;
+    float max_error = 0.0f;
+    std::vector<uint32_t> offsets(i_VertexCount + 1), faces, remap(i_VertexCount);
+    std::vector<Collapse> collapses;
+    std::vector<unsigned char> touched(i_VertexCount);
+    std::vector<uint32_t> ring;
+    while (index_count > i_TargetIndexCount) {
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (size_t i = 0; i < index_count; ++i) {
+            offsets[o_Indices[i] + 1]++;
+        }
+        for (size_t vertex = 0; vertex < i_VertexCount; ++vertex) {
+            offsets[vertex + 1] += offsets[vertex];
+        }
+        faces.resize(index_count);
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < index_count; ++i) {
+            faces[fill[o_Indices[i]]++] = (uint32_t)(i / 3);
+        }
+
+        // Every edge once, in the cheaper allowed direction
+        collapses.clear();
+        for (size_t i = 0; i < index_count; ++i) {
+            const uint32_t a = o_Indices[i];
+            const uint32_t b = o_Indices[i % 3 == 2 ? i - 2 : i + 1];
+            if (a > b || (locked[a] && locked[b])) {
+                continue;
+            }
+            Quadric merged = quadrics[a];
+            AddQuadric(merged, quadrics[b]);
+            Collapse collapse = { a, b, locked[a] ? 1e30f : QuadricError(merged, &positions[b * 3]) };
+            const float reverse = locked[b] ? 1e30f : QuadricError(merged, &positions[a * 3]);
+            if (reverse < collapse.Error) {
+                collapse = { b, a, reverse };
+            }
+            if (collapse.Error <= target_error) {
+                collapses.push_back(collapse);
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& i_A, const Collapse& i_B) { return i_A.Error < i_B.Error; });
+
+        // A collapse removes about two triangles, vertices already moved this pass are left for the next one
+        const size_t goal = (index_count - i_TargetIndexCount) / 6 + 1;
+        size_t applied = 0;
+        for (size_t vertex = 0; vertex < i_VertexCount; ++vertex) {
+            remap[vertex] = (uint32_t)vertex;
+        }
+        std::fill(touched.begin(), touched.end(), 0);
+        for (size_t i = 0; i < collapses.size() && applied < goal; ++i) {
+            const Collapse& collapse = collapses[i];
+            if (touched[collapse.From] || touched[collapse.To]) {
+                continue;
+            }
+            const uint32_t* from_faces = faces.data() + offsets[collapse.From];
+            const size_t from_face_count = offsets[collapse.From + 1] - offsets[collapse.From];
+            if (!KeepsManifold(collapse, o_Indices, from_faces, from_face_count, faces.data() + offsets[collapse.To], offsets[collapse.To + 1] - offsets[collapse.To], ring)
+                || CollapseFlips(collapse, o_Indices, from_faces, from_face_count, positions)) {
+                continue;
+            }
+            remap[collapse.From] = collapse.To;
+            AddQuadric(quadrics[collapse.To], quadrics[collapse.From]);
+            // Whole neighbourhood stays fixed for the rest of the pass, so the checks above see final geometry
+            for (size_t face = 0; face < from_face_count; ++face) {
+                for (int corner = 0; corner < 3; ++corner) {
+                    touched[o_Indices[from_faces[face] * 3 + corner]] = 1;
+                }
+            }
+            max_error = collapse.Error > max_error ? collapse.Error : max_error;
+            applied++;
+        }
+        if (!applied) {
+            break;
+        }
+
+        // Triangles that lost an edge disappear
+        size_t write = 0;
+        for (size_t i = 0; i < index_count; i += 3) {
+            const uint32_t a = remap[o_Indices[i]], b = remap[o_Indices[i + 1]], c = remap[o_Indices[i + 2]];
+            if (a != b && b != c && a != c) {
+                o_Indices[write++] = a;
+                o_Indices[write++] = b;
+                o_Indices[write++] = c;
+            }
+        }
+        index_count = write;
+    }
+
+    *o_Error = sqrtf(max_error);
+    return index_count;
+}
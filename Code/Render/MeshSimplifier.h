@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Mesh simplifier predifinitions
+#define MaxLodLevels 5                                      // Full detail level plus up to 4 simplified ones
+#define LodReductionRatio 0.5f                              // Target index count of a level relative to the previous one
+#define LodMinReduction 0.85f                               // Level is dropped when it keeps more of the previous level's indices
+#define LodMaxError 0.05f                                   // Largest simplification error relative to mesh extent
+
+// Quadric error metric edge collapse simplification of an indexed triangle list
+// Vertices are collapsed onto their neighbours, so the result indexes the same vertex buffer as the source
+// Border and attribute seam vertices (several vertices at one position) are never moved
+// i_Positions are the first 3 floats of every i_Stride floats, o_Indices needs room for i_IndexCount indices
+// Returns index count of the result, o_Error receives the largest collapse error relative to mesh extent
+size_t SimplifyMesh(uint32_t* o_Indices, const uint32_t* i_Indices, const size_t i_IndexCount, const float* i_Positions, const size_t i_Stride, const size_t i_VertexCount,
+	const size_t i_TargetIndexCount, const float i_TargetError, float* o_Error);
@@ -0,0 +1,144 @@
+#include "Meshlets.h"
+#include <cmath>
+
+// Close cluster over triangles [i_First, i_End) and compute its sphere and normal cone
+static void FinishMeshlet(std::vector<Meshlet>& io_Meshlets, const uint32_t* i_Indices, const size_t i_First, const size_t i_End,
+    const float* i_Positions, const size_t i_Stride, const std::vector<float>& i_Normals) {
+    Meshlet meshlet;
+    meshlet.FirstIndex = (uint32_t)(i_First * 3);
+    meshlet.IndexCount = (uint32_t)((i_End - i_First) * 3);
+
+    // Sphere around box center, close to minimal for the compact clusters built here
+    float minimum[3] = { 1e30f, 1e30f, 1e30f };
+    float maximum[3] = { -1e30f, -1e30f, -1e30f };
+    for (size_t i = i_First * 3; i < i_End * 3; ++i) {
+        const float* position = i_Positions + i_Indices[i] * i_Stride;
+        for (int axis = 0; axis < 3; ++axis) {
+            minimum[axis] = position[axis] < minimum[axis] ? position[axis] : minimum[axis];
+            maximum[axis] = position[axis] > maximum[axis] ? position[axis] : maximum[axis];
+        }
+    }
+    for (int axis = 0; axis < 3; ++axis) {
+        meshlet.Center[axis] = (minimum[axis] + maximum[axis]) * 0.5f;
+    }
+    float radius = 0.0f;
+    for (size_t i = i_First * 3; i < i_End * 3; ++i) {
+        const float* position = i_Positions + i_Indices[i] * i_Stride;
+        const float offset[3] = { position[0] - meshlet.Center[0], position[1] - meshlet.Center[1], position[2] - meshlet.Center[2] };
+        const float distance = offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2];
+        radius = distance > radius ? distance : radius;
+    }
+    meshlet.Radius = sqrtf(radius);
+
+    float axis[3] = { 0.0f, 0.0f, 0.0f };
+    for (size_t face = i_First; face < i_End; ++face) {
+        for (int component = 0; component < 3; ++component) {
+            axis[component] += i_Normals[face * 3 + component];
+        }
+    }
+    const float length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    float spread = 1.0f;
+    for (int component = 0; component < 3; ++component) {
+        meshlet.ConeAxis[component] = length > 0.0f ? axis[component] / length : 0.0f;
+    }
+    for (size_t face = i_First; face < i_End; ++face) {
+        const float* normal = &i_Normals[face * 3];
+        // Degenerate triangles have no normal and never show
+        if (normal[0] == 0.0f && normal[1] == 0.0f && normal[2] == 0.0f) {
+            continue;
+        }
+        const float dot = normal[0] * meshlet.ConeAxis[0] + normal[1] * meshlet.ConeAxis[1] + normal[2] * meshlet.ConeAxis[2];
+        spread = dot < spread ? dot : spread;
+    }
+    meshlet.ConeCos = spread > 0.0f ? spread : 0.0f;
+    meshlet.ConeSin = spread > 0.0f ? sqrtf(1.0f - spread * spread) : 1.0f;
+
+    io_Meshlets.push_back(meshlet);
+}
+
+size_t BuildMeshlets(std::vector<Meshlet>& io_Meshlets, const uint32_t* i_Indices, const size_t i_IndexCount, const float* i_Positions, const size_t i_Stride, const size_t i_VertexCount) {
+    const size_t face_count = i_IndexCount / 3;
+    const size_t first_meshlet = io_Meshlets.size();
+
+    // Unit normals of all triangles, zero for degenerate ones
+    std::vector<float> normals(face_count * 3, 0.0f);
+    for (size_t face = 0; face < face_count; ++face) {
+        const float* a = i_Positions + i_Indices[face * 3 + 0] * i_Stride;
+        const float* b = i_Positions + i_Indices[face * 3 + 1] * i_Stride;
+        const float* c = i_Positions + i_Indices[face * 3 + 2] * i_Stride;
+        const float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        const float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+        const float normal[3] = { ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0] };
+        const float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (length > 0.0f) {
+            for (int axis = 0; axis < 3; ++axis) {
+                normals[face * 3 + axis] = normal[axis] / length;
+            }
+        }
+    }
+
+    // Vertices are counted per cluster with a stamp instead of clearing a set
+    std::vector<uint32_t> vertex_stamp(i_VertexCount, 0);
+    uint32_t stamp = 1;
+    size_t first = 0;
+    size_t vertices = 0;
+    float normal_sum[3] = { 0.0f, 0.0f, 0.0f };
+    for (size_t face = 0; face < face_count; ++face) {
+        const uint32_t* triangle = i_Indices + face * 3;
+        size_t new_vertices = 0;
+        for (int corner = 0; corner < 3; ++corner) {
+            new_vertices += vertex_stamp[triangle[corner]] != stamp;
+        }
+
+        bool split = face - first >= MeshletMaxTriangles || vertices + new_vertices > MeshletMaxVertices;
+        if (!split && face - first >= MeshletMinTriangles) {
+            const float* normal = &normals[face * 3];
+            const float dot = normal[0] * normal_sum[0] + normal[1] * normal_sum[1] + normal[2] * normal_sum[2];
+            const float length = sqrtf(normal_sum[0] * normal_sum[0] + normal_sum[1] * normal_sum[1] + normal_sum[2] * normal_sum[2]);
+            split = dot < MeshletSplitNormalCos * length;
+        }
+        if (split) {
+            FinishMeshlet(io_Meshlets, i_Indices, first, face, i_Positions, i_Stride, normals);
+            first = face;
+            vertices = 0;
+            normal_sum[0] = normal_sum[1] = normal_sum[2] = 0.0f;
+            stamp++;
+            new_vertices = 3;
+        }
+
+        for (int corner = 0; corner < 3; ++corner) {
+            vertex_stamp[triangle[corner]] = stamp;
+        }
+        for (int axis = 0; axis < 3; ++axis) {
+            normal_sum[axis] += normals[face * 3 + axis];
+        }
+        vertices += new_vertices;
+    }
+    if (first < face_count) {
+        FinishMeshlet(io_Meshlets, i_Indices, first, face_count, i_Positions, i_Stride, normals);
+    }
+    return io_Meshlets.size() - first_meshlet;
+}
+
+bool MeshletVisible(const Meshlet& i_Meshlet, const Frustum& i_Frustum, const float* i_Camera, const bool i_TestCone) {
+    for (int plane = 0; plane < 6; ++plane) {
+        const float* p = i_Frustum.Planes[plane];
+        if (p[0] * i_Meshlet.Center[0] + p[1] * i_Meshlet.Center[1] + p[2] * i_Meshlet.Center[2] + p[3] < -i_Meshlet.Radius) {
+            return false;
+        }
+    }
+    if (!i_TestCone) {
+        return true;
+    }
+
+    // Backfacing when every point of the sphere sees every cone normal pointing away:
+    // |v| * cos(angle(v, axis) + cone angle) > radius, v from camera to sphere center
+    const float view[3] = { i_Meshlet.Center[0] - i_Camera[0], i_Meshlet.Center[1] - i_Camera[1], i_Meshlet.Center[2] - i_Camera[2] };
+    const float distance = sqrtf(view[0] * view[0] + view[1] * view[1] + view[2] * view[2]);
+    if (distance <= i_Meshlet.Radius) {
+        return true;
+    }
+    const float cos_view = (view[0] * i_Meshlet.ConeAxis[0] + view[1] * i_Meshlet.ConeAxis[1] + view[2] * i_Meshlet.ConeAxis[2]) / distance;
+    const float sin_view = sqrtf(1.0f - cos_view * cos_view > 0.0f ? 1.0f - cos_view * cos_view : 0.0f);
+    return distance * (cos_view * i_Meshlet.ConeCos - sin_view * i_Meshlet.ConeSin) <= i_Meshlet.Radius;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Culling.h"
+
+// Meshlet predifinitions
+#define MeshletMaxVertices 64                               // Unique vertices of one cluster
+#define MeshletMaxTriangles 128
+#define MeshletMinTriangles 64                              // Clusters are split on normal changes only past this size
+#define MeshletSplitNormalCos 0.5f                          // Triangle turned further than this from cluster normal starts a new one
+#define MeshletMinPrimitiveTriangles 256                    // Smaller primitives are culled as a whole
+
+// Contiguous run of triangles in a primitive's index list with its bounds in primitive local space
+struct Meshlet {
+	float           Center[3];                              // Bounding sphere
+	float           Radius;
+	float           ConeAxis[3];                            // Average triangle normal
+	float           ConeCos;                                // Cosine and sine of the largest angle of a triangle normal to the axis,
+	float           ConeSin;                                // 0 and 1 when normals spread over a hemisphere and the cone never culls
+	uint32_t        FirstIndex;                             // Relative to the first index of the primitive
+	uint32_t        IndexCount;
+};
+
+// Split triangle list into consecutive clusters and append them, returns number of clusters added
+// Triangle order is kept, so cache optimized lists give spatially coherent clusters
+size_t BuildMeshlets(std::vector<Meshlet>& io_Meshlets, const uint32_t* i_Indices, const size_t i_IndexCount, const float* i_Positions, const size_t i_Stride, const size_t i_VertexCount);
+
+// Cluster is inside the frustum and, when i_TestCone is set, some of its triangles may face the camera
+// Frustum and camera position are in primitive local space
+bool MeshletVisible(const Meshlet& i_Meshlet, const Frustum& i_Frustum, const float* i_Camera, const bool i_TestCone);
@@ -0,0 +1,332 @@
+#include "MipChain.h"
+#include <immintrin.h>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include "../Utils/Hash.h"
+
+#define MipChainMagic 0x5350494Du                           // "MIPS"
+#define MipPi 3.14159265358979323846
+
+// Cache file header, followed by level data exactly as MipChain stores it
+struct MipCacheHeader {
+    uint32_t        Magic;
+    uint32_t        Version;
+    uint64_t        Key;
+    int32_t         Width;                                  // Base image size the chain belongs to
+    int32_t         Height;
+    uint64_t        Size;                                   // Bytes of level data after the header
+};
+
+// Modified Bessel function of the first kind, order 0
+static double BesselI0(const double i_X) {
+    double sum = 1.0, term = 1.0;
+    const double quarter_square = i_X * i_X * 0.25;
+    for (int k = 1; k < 32; ++k) {
+        term *= quarter_square / ((double)k * k);
+        sum += term;
+    }
+    return sum;
+}
+
+// Normalized weights of the 2:1 Kaiser windowed sinc, source texel 2x - 2 + k for destination texel x
+static const float* KaiserWeights() {
+    static const struct Weights {
+        float Values[KaiserTaps];
+        Weights() {
+            const double radius = KaiserTaps / 2;
+            double total = 0.0;
+            double weights[KaiserTaps];
+            for (int k = 0; k < KaiserTaps; ++k) {
+                // Distance of source texel center from destination texel center, in source texels
+                const double distance = k - (KaiserTaps - 1) * 0.5;
+                const double t = distance * 0.5;
+                const double sinc = t == 0.0 ? 1.0 : sin(MipPi * t) / (MipPi * t);
+                const double u = distance / radius;
+                const double window = BesselI0(KaiserAlpha * sqrt(1.0 - u * u)) / BesselI0(KaiserAlpha);
+                weights[k] = sinc * window;
+                total += weights[k];
+            }
+            for (int k = 0; k < KaiserTaps; ++k) {
+                Values[k] = (float)(weights[k] / total);
+            }
+        }
+    } weights;
+    return weights.Values;
+}
+
+// sRGB transfer tables, decoding is exact for every byte, encoding uses 12 bit linear input
+#define LinearToSRGBSteps 4096
+struct SRGBTables {
+    float           ToLinear[256];
+    uint8_t         ToSRGB[LinearToSRGBSteps];
+
+    SRGBTables() {
+        for (int i = 0; i < 256; ++i) {
+            const double c = i / 255.0;
+            ToLinear[i] = (float)(c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4));
+        }
+        for (int i = 0; i < LinearToSRGBSteps; ++i) {
+            const double l = i / (double)(LinearToSRGBSteps - 1);
+            const double c = l <= 0.0031308 ? l * 12.92 : 1.055 * pow(l, 1.0 / 2.4) - 0.055;
+            ToSRGB[i] = (uint8_t)(c * 255.0 + 0.5);
+        }
+    }
+};
+
+static const SRGBTables& GetSRGBTables() {
+    static const SRGBTables tables;
+    return tables;
+}
+
+// One RGBA8 texel as float, normals decoded to [-1, 1] XYZ, alpha always [0, 1]
+static inline __m128 LoadTexel(const uint8_t* i_Texel, const MipContent i_Content) {
+    if (i_Content == MipContentSRGB) {
+        const float* to_linear = GetSRGBTables().ToLinear;
+        return _mm_setr_ps(to_linear[i_Texel[0]], to_linear[i_Texel[1]], to_linear[i_Texel[2]], i_Texel[3] * (1.0f / 255.0f));
+    }
+
+    int packed;
+    memcpy(&packed, i_Texel, 4);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 texel = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero));
+    if (i_Content == MipContentNormal) {
+        const float s = 2.0f / 255.0f;
+        return _mm_add_ps(_mm_mul_ps(texel, _mm_setr_ps(s, s, s, 1.0f / 255.0f)), _mm_setr_ps(-1.0f, -1.0f, -1.0f, 0.0f));
+    }
+    return _mm_mul_ps(texel, _mm_set1_ps(1.0f / 255.0f));
+}
+
+// Inverse of LoadTexel, normals are renormalized before encoding
+static inline void StoreTexel(__m128 i_Value, const MipContent i_Content, uint8_t* o_Texel) {
+    if (i_Content == MipContentSRGB) {
+        const uint8_t* to_srgb = GetSRGBTables().ToSRGB;
+        const __m128 clamped = _mm_min_ps(_mm_max_ps(i_Value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+        alignas(16) int32_t steps[4];
+        _mm_store_si128((__m128i*)steps, _mm_cvtps_epi32(_mm_mul_ps(clamped, _mm_setr_ps(LinearToSRGBSteps - 1, LinearToSRGBSteps - 1, LinearToSRGBSteps - 1, 255.0f))));
+        o_Texel[0] = to_srgb[steps[0]];
+        o_Texel[1] = to_srgb[steps[1]];
+        o_Texel[2] = to_srgb[steps[2]];
+        o_Texel[3] = (uint8_t)steps[3];
+        return;
+    }
+
+    __m128 scaled;
+    if (i_Content == MipContentNormal) {
+        const __m128 square = _mm_mul_ps(i_Value, i_Value);
+        const __m128 length_squared = _mm_add_ps(_mm_add_ps(_mm_shuffle_ps(square, square, _MM_SHUFFLE(0, 0, 0, 0)),
+            _mm_shuffle_ps(square, square, _MM_SHUFFLE(1, 1, 1, 1))), _mm_shuffle_ps(square, square, _MM_SHUFFLE(2, 2, 2, 2)));
+        // Opposite normals cancelling out fall back to the surface normal
+        const __m128 xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+        __m128 normal = _mm_setr_ps(0.0f, 0.0f, 1.0f, 0.0f);
+        if (_mm_cvtss_f32(length_squared) > 1e-12f) {
+            normal = _mm_div_ps(i_Value, _mm_sqrt_ps(length_squared));
+        }
+        const __m128 value = _mm_or_ps(_mm_and_ps(xyz, normal), _mm_andnot_ps(xyz, i_Value));
+        scaled = _mm_add_ps(_mm_mul_ps(value, _mm_setr_ps(127.5f, 127.5f, 127.5f, 255.0f)), _mm_setr_ps(127.5f, 127.5f, 127.5f, 0.0f));
+    }
+    else {
+        scaled = _mm_mul_ps(i_Value, _mm_set1_ps(255.0f));
+    }
+
+    // Saturating packs clamp to [0, 255]
+    const __m128i words = _mm_packs_epi32(_mm_cvtps_epi32(scaled), _mm_setzero_si128());
+    const int packed = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+    memcpy(o_Texel, &packed, 4);
+}
+
+void DownsampleBox(const uint8_t* i_Source, const int i_Width, const int i_Height, uint8_t* o_Destination, const MipContent i_Content) {
+    const int width = MipChain::Dimension(i_Width, 1);
+    const int height = MipChain::Dimension(i_Height, 1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rounding = _mm_set1_epi16(2);
+
+    for (int y = 0; y < height; ++y) {
+        // Odd sizes clamp the second row/column to the edge
+        const uint8_t* row0 = i_Source + (size_t)(2 * y) * i_Width * 4;
+        const uint8_t* row1 = i_Source + (size_t)(2 * y + 1 < i_Height ? 2 * y + 1 : i_Height - 1) * i_Width * 4;
+        uint8_t* output = o_Destination + (size_t)y * width * 4;
+
+        int x = 0;
+        if (i_Content != MipContentNormal) {
+            // 4 destination texels from 8 source texels of both rows, (a + b + c + d + 2) >> 2 per channel
+            for (; x + 4 <= width && 2 * x + 8 <= i_Width; x += 4) {
+                for (int half = 0; half < 2; ++half) {
+                    const __m128i top = _mm_loadu_si128((const __m128i*)(row0 + (size_t)(2 * x + 4 * half) * 4));
+                    const __m128i bottom = _mm_loadu_si128((const __m128i*)(row1 + (size_t)(2 * x + 4 * half) * 4));
+                    const __m128i first = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+                    const __m128i second = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+                    const __m128i sums = _mm_unpacklo_epi64(_mm_add_epi16(first, _mm_srli_si128(first, 8)), _mm_add_epi16(second, _mm_srli_si128(second, 8)));
+                    const __m128i averages = _mm_srli_epi16(_mm_add_epi16(sums, rounding), 2);
+                    _mm_storel_epi64((__m128i*)(output + (size_t)(x + 2 * half) * 4), _mm_packus_epi16(averages, averages));
+                }
+            }
+        }
+
+        for (; x < width; ++x) {
+            const int x0 = 2 * x;
+            const int x1 = 2 * x + 1 < i_Width ? 2 * x + 1 : i_Width - 1;
+            if (i_Content == MipContentNormal) {
+                const __m128 sum = _mm_add_ps(_mm_add_ps(LoadTexel(row0 + x0 * 4, i_Content), LoadTexel(row0 + x1 * 4, i_Content)),
+                    _mm_add_ps(LoadTexel(row1 + x0 * 4, i_Content), LoadTexel(row1 + x1 * 4, i_Content)));
+                StoreTexel(_mm_mul_ps(sum, _mm_set1_ps(0.25f)), i_Content, output + x * 4);
+                continue;
+            }
+            for (int c = 0; c < 4; ++c) {
+                output[x * 4 + c] = (uint8_t)((row0[x0 * 4 + c] + row0[x1 * 4 + c] + row1[x0 * 4 + c] + row1[x1 * 4 + c] + 2) >> 2);
+            }
+        }
+    }
+}
+
+void DownsampleKaiser(const float* i_Source, const int i_Width, const int i_Height, float* o_Destination) {
+    const int width = MipChain::Dimension(i_Width, 1);
+    const int height = MipChain::Dimension(i_Height, 1);
+    const float* weights = KaiserWeights();
+    __m128 tap_weights[KaiserTaps];
+    for (int k = 0; k < KaiserTaps; ++k) {
+        tap_weights[k] = _mm_set1_ps(weights[k]);
+    }
+
+    // Horizontal pass into width x i_Height, one texel per register, edges clamped
+    std::vector<float> horizontal((size_t)width * i_Height * 4);
+    for (int y = 0; y < i_Height; ++y) {
+        const float* row = i_Source + (size_t)y * i_Width * 4;
+        float* output = horizontal.data() + (size_t)y * width * 4;
+        for (int x = 0; x < width; ++x) {
+            __m128 sum = _mm_setzero_ps();
+            for (int k = 0; k < KaiserTaps; ++k) {
+                int source = 2 * x - (KaiserTaps / 2 - 1) + k;
+                source = source < 0 ? 0 : (source >= i_Width ? i_Width - 1 : source);
+                sum = _mm_add_ps(sum, _mm_mul_ps(tap_weights[k], _mm_loadu_ps(row + source * 4)));
+            }
+            _mm_storeu_ps(output + x * 4, sum);
+        }
+    }
+
+    // Vertical pass, whole rows are weighted at once
+    const size_t row_floats = (size_t)width * 4;
+    for (int y = 0; y < height; ++y) {
+        const float* rows[KaiserTaps];
+        for (int k = 0; k < KaiserTaps; ++k) {
+            int source = 2 * y - (KaiserTaps / 2 - 1) + k;
+            source = source < 0 ? 0 : (source >= i_Height ? i_Height - 1 : source);
+            rows[k] = horizontal.data() + source * row_floats;
+        }
+        float* output = o_Destination + y * row_floats;
+        for (size_t i = 0; i < row_floats; i += 4) {
+            __m128 sum = _mm_setzero_ps();
+            for (int k = 0; k < KaiserTaps; ++k) {
+                sum = _mm_add_ps(sum, _mm_mul_ps(tap_weights[k], _mm_loadu_ps(rows[k] + i)));
+            }
+            _mm_storeu_ps(output + i, sum);
+        }
+    }
+}
+
+uint64_t MipChain::Key(const uint8_t* i_Pixels, const int i_Width, const int i_Height, const MipFilter i_Filter, const MipContent i_Content) {
+    const int32_t settings[] = { MipChainVersion, i_Width, i_Height, i_Filter, i_Content, (int32_t)(KaiserAlpha * 1000.0f), KaiserTaps };
+    const uint64_t hash = HashBytes((const unsigned char*)settings, sizeof(settings));
+    return HashBytes(i_Pixels, (size_t)i_Width * i_Height * 4, hash);
+}
+
+void MipChain::Layout(const int i_Width, const int i_Height) {
+    BaseWidth = i_Width;
+    BaseHeight = i_Height;
+    LevelCount = 1;
+    Size = 0;
+    while (LevelCount < MipChainMaxLevels && (LevelWidth(LevelCount - 1) > 1 || LevelHeight(LevelCount - 1) > 1)) {
+        Offsets[LevelCount] = Size;
+        Size += (size_t)LevelWidth(LevelCount) * LevelHeight(LevelCount) * 4;
+        LevelCount++;
+    }
+}
+
+void MipChain::Generate(const uint8_t* i_Pixels, const int i_Width, const int i_Height, const MipFilter i_Filter, const MipContent i_Content) {
+    Release();
+    Layout(i_Width, i_Height);
+    Storage.resize(Size);
+    Data = Storage.data();
+
+    if (i_Filter == MipFilterBox) {
+        const uint8_t* source = i_Pixels;
+        for (int level = 1; level < LevelCount; ++level) {
+            uint8_t* destination = Storage.data() + Offsets[level];
+            DownsampleBox(source, LevelWidth(level - 1), LevelHeight(level - 1), destination, i_Content);
+            source = destination;
+        }
+        return;
+    }
+
+    // Every level is filtered from the unquantized previous one so rounding does not accumulate
+    std::vector<float> current((size_t)i_Width * i_Height * 4);
+    for (size_t i = 0; i < (size_t)i_Width * i_Height; ++i) {
+        _mm_storeu_ps(current.data() + i * 4, LoadTexel(i_Pixels + i * 4, i_Content));
+    }
+    std::vector<float> next;
+    for (int level = 1; level < LevelCount; ++level) {
+        const size_t texels = (size_t)LevelWidth(level) * LevelHeight(level);
+        next.resize(texels * 4);
+        DownsampleKaiser(current.data(), LevelWidth(level - 1), LevelHeight(level - 1), next.data());
+
+        uint8_t* destination = Storage.data() + Offsets[level];
+        for (size_t i = 0; i < texels; ++i) {
+            StoreTexel(_mm_loadu_ps(next.data() + i * 4), i_Content, destination + i * 4);
+        }
+        current.swap(next);
+    }
+}
+
+bool MipChain::Load(const char* i_Filename, const uint64_t i_Key, const int i_Width, const int i_Height) {
+    Release();
+    if (!File.Open(i_Filename)) {
+        return false;
+    }
+
+    MipCacheHeader header;
+    if (File.GetSize() < sizeof(header)) {
+        Release();
+        return false;
+    }
+    memcpy(&header, File.GetData(), sizeof(header));
+
+    Layout(i_Width, i_Height);
+    if (header.Magic != MipChainMagic || header.Version != MipChainVersion || header.Key != i_Key ||
+        header.Width != i_Width || header.Height != i_Height || header.Size != Size || File.GetSize() != sizeof(header) + Size) {
+        Release();
+        return false;
+    }
+
+    Data = File.GetData() + sizeof(header);
+    return true;
+}
+
+bool MipChain::Save(const char* i_Filename, const uint64_t i_Key) const {
+    if (!Data) {
+        return false;
+    }
+
+    MipCacheHeader header = {};
+    header.Magic = MipChainMagic;
+    header.Version = MipChainVersion;
+    header.Key = i_Key;
+    header.Width = BaseWidth;
+    header.Height = BaseHeight;
+    header.Size = Size;
+
+    std::ofstream file(i_Filename, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)Data, (std::streamsize)Size);
+    return file.good();
+}
+
+void MipChain::Release() {
+    File.Close();
+    std::vector<uint8_t>().swap(Storage);
+    Data = nullptr;
+    LevelCount = 0;
+    Size = 0;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../Utils/MappedFile.h"
+
+// Mip chain predifinitions
+#define MipChainVersion 1                                   // Bump whenever filters or file layout change
+#define MipChainMaxLevels 32
+#define KaiserAlpha 4.0f                                    // Kaiser window shape, higher is smoother with less ringing
+#define KaiserTaps 6                                        // Source texels weighted for every destination texel along one axis
+
+// Downsampling filter
+enum MipFilter {
+	MipFilterBox = 0,                                       // 2x2 average of 8 bit texels, fast
+	MipFilterKaiser = 1,                                    // Kaiser windowed sinc in float, sharper and without box aliasing
+};
+
+// How texel values are interpreted while filtering
+enum MipContent {
+	MipContentLinear = 0,                                   // Data textures (metallic/roughness/occlusion)
+	MipContentSRGB = 1,                                     // Color textures, RGB filtered in linear space
+	MipContentNormal = 2,                                   // Tangent space normals, XYZ renormalized after filtering
+};
+
+// Mip levels below the base image of an 8 bit RGBA texture, generated on CPU or loaded from a cache file
+// Level 0 is the source image itself and is not stored, levels 1..Levels()-1 are tightly packed after each other
+class MipChain {
+
+public:
+	// Cache key of the chain made from given base image with given filter
+	static uint64_t Key(const uint8_t* i_Pixels, const int i_Width, const int i_Height, const MipFilter i_Filter, const MipContent i_Content);
+
+	// Build every level down to 1x1
+	void Generate(const uint8_t* i_Pixels, const int i_Width, const int i_Height, const MipFilter i_Filter, const MipContent i_Content);
+
+	// Map cache file, fails if it is missing, damaged, or made for another key or size
+	bool Load(const char* i_Filename, const uint64_t i_Key, const int i_Width, const int i_Height);
+	bool Save(const char* i_Filename, const uint64_t i_Key) const;
+
+	int Levels() const { return LevelCount; }
+	int LevelWidth(const int i_Level) const { return Dimension(BaseWidth, i_Level); }
+	int LevelHeight(const int i_Level) const { return Dimension(BaseHeight, i_Level); }
+	const uint8_t* LevelData(const int i_Level) const { return Data + Offsets[i_Level]; }
+
+	// Drop generated data or unmap cache file
+	void Release();
+
+	static int Dimension(const int i_Base, const int i_Level) { return (i_Base >> i_Level) > 0 ? i_Base >> i_Level : 1; }
+
+private:
+	void Layout(const int i_Width, const int i_Height);
+
+	int             BaseWidth = 0;
+	int             BaseHeight = 0;
+	int             LevelCount = 0;                             // Including level 0
+	size_t          Offsets[MipChainMaxLevels] = {};            // Byte offset of every level from Data, level 0 unused
+	size_t          Size = 0;                                   // Bytes of levels 1..LevelCount-1
+	const uint8_t*  Data = nullptr;                             // Storage or cache file mapping
+	std::vector<uint8_t> Storage;
+	MappedFile      File;
+};
+
+// Downsample kernels, both take 8 bit RGBA and write a level of Dimension(width/height, 1)
+void DownsampleBox(const uint8_t* i_Source, const int i_Width, const int i_Height, uint8_t* o_Destination, const MipContent i_Content);
+// Float RGBA (linear or decoded normals), destination must hold Dimension(width, 1) * Dimension(height, 1) texels
+void DownsampleKaiser(const float* i_Source, const int i_Width, const int i_Height, float* o_Destination);
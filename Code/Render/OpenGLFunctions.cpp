@@ -1,14 +1,31 @@
 #include "OpenGLFunctions.h"
+#include "../Utils/Utils.h"
 
+#define GLFUNCTION( x ) { (void**)&x, #x, true }
+#define GLOPTIONALFUNCTION( x ) { (void**)&x, #x, false }
+
+// Entry point variable and name it is loaded by
+struct OpenGLFunction {
+    void**          Address;
+    const char*     Name;
+    bool            Required;                   // Optional functions stay nullptr if unavailable, users check them
+};
+
+// Extensions of current context
+ExtensionSet                        GLExtensions;
+
+#ifdef _WIN32
 // WGL
 PFNWGLGETEXTENSIONSSTRINGARBPROC    wglGetExtensionsStringARB;
 PFNWGLCHOOSEPIXELFORMATARBPROC      wglChoosePixelFormatARB;
 PFNWGLCREATECONTEXTATTRIBSARBPROC   wglCreateContextAttribsARB;
+#endif
 
 // OGL
 PFNGLGETSTRINGPROC                  glGetString;
 PFNGLGETSTRINGIPROC                 glGetStringi;
 PFNGLGETINTEGERVPROC                glGetIntegerv;
+PFNGLGETFLOATVPROC                  glGetFloatv;
 PFNGLGETERRORPROC                   glGetError;
 PFNGLVIEWPORTPROC                   glViewport;
 PFNGLCLEARPROC                      glClear;
@@ -23,6 +40,7 @@ PFNGLFRONTFACEPROC                  glFrontFace;
 PFNGLCULLFACEPROC                   glCullFace;
 PFNGLPOLYGONMODEPROC                glPolygonMode;
 PFNGLSAMPLECOVERAGEPROC             glSampleCoverage;
+PFNGLFINISHPROC                     glFinish;
 
 // Shaders
 PFNGLCREATESHADERPROC               glCreateShader;
@@ -39,6 +57,9 @@ PFNGLGETPROGRAMINFOLOGPROC          glGetProgramInfoLog;
 PFNGLUSEPROGRAMPROC                 glUseProgram;
 PFNGLDETACHSHADERPROC               glDetachShader;
 PFNGLDELETEPROGRAMPROC              glDeleteProgram;
+PFNGLGETPROGRAMBINARYPROC           glGetProgramBinary;
+PFNGLPROGRAMBINARYPROC              glProgramBinary;
+PFNGLPROGRAMPARAMETERIPROC          glProgramParameteri;
 
 // Vertex arrays
 PFNGLGENVERTEXARRAYSPROC            glGenVertexArrays;
@@ -51,14 +72,26 @@ PFNGLBINDBUFFERPROC                 glBindBuffer;
 PFNGLBUFFERDATAPROC                 glBufferData;
 PFNGLBUFFERSUBDATAPROC              glBufferSubData;
 PFNGLDELETEBUFFERSPROC              glDeleteBuffers;
+PFNGLBUFFERSTORAGEPROC              glBufferStorage;
+PFNGLMAPBUFFERRANGEPROC             glMapBufferRange;
+PFNGLUNMAPBUFFERPROC                glUnmapBuffer;
+PFNGLCOPYBUFFERSUBDATAPROC          glCopyBufferSubData;
+
+// Sync objects
+PFNGLFENCESYNCPROC                  glFenceSync;
+PFNGLCLIENTWAITSYNCPROC             glClientWaitSync;
+PFNGLDELETESYNCPROC                 glDeleteSync;
 
 // Framebuffer
 PFNGLGENFRAMEBUFFERSPROC            glGenFramebuffers;
 PFNGLBINDFRAMEBUFFERPROC            glBindFramebuffer;
+PFNGLDELETEFRAMEBUFFERSPROC         glDeleteFramebuffers;
 PFNGLFRAMEBUFFERTEXTURE2DPROC       glFramebufferTexture2D;
 PFNGLCHECKFRAMEBUFFERSTATUSPROC     glCheckFramebufferStatus;
 PFNGLDRAWBUFFERPROC                 glDrawBuffer;
 PFNGLDRAWBUFFERSPROC                glDrawBuffers;
+PFNGLREADBUFFERPROC                 glReadBuffer;
+PFNGLREADPIXELSPROC                 glReadPixels;
 
 // Vertex attribs
 PFNGLVERTEXATTRIBPOINTERPROC        glVertexAttribPointer;
@@ -69,6 +102,7 @@ PFNGLGETACTIVEATTRIBPROC            glGetActiveAttrib;
 PFNGLENABLEVERTEXATTRIBARRAYPROC    glEnableVertexAttribArray;
 PFNGLDISABLEVERTEXATTRIBARRAYPROC   glDisableVertexAttribArray;
 PFNGLGETVERTEXATTRIBIVPROC          glGetVertexAttribiv;
+PFNGLVERTEXATTRIBDIVISORPROC        glVertexAttribDivisor;
 
 // Textures
 PFNGLGENTEXTURESPROC                glGenTextures;
@@ -77,7 +111,15 @@ PFNGLBINDTEXTUREPROC                glBindTexture;
 PFNGLACTIVETEXTUREPROC              glActiveTexture;
 PFNGLTEXPARAMETERIPROC              glTexParameteri;
 PFNGLTEXIMAGE2DPROC                 glTexImage2D;
+PFNGLTEXSUBIMAGE2DPROC              glTexSubImage2D;
+PFNGLPIXELSTOREIPROC                glPixelStorei;
 PFNGLGENERATEMIPMAPPROC             glGenerateMipmap;
+PFNGLGENSAMPLERSPROC                glGenSamplers;
+PFNGLDELETESAMPLERSPROC             glDeleteSamplers;
+PFNGLBINDSAMPLERPROC                glBindSampler;
+PFNGLSAMPLERPARAMETERIPROC          glSamplerParameteri;
+PFNGLSAMPLERPARAMETERFPROC          glSamplerParameterf;
+PFNGLTEXBUFFERPROC                  glTexBuffer;
 
 // Uniform Parameters
 PFNGLGETACTIVEUNIFORMPROC           glGetActiveUniform;
@@ -97,3 +139,188 @@ PFNGLUNIFORMMATRIX4FVPROC           glUniformMatrix4fv;
 // Drawing
 PFNGLDRAWARRAYSPROC                 glDrawArrays;
 PFNGLDRAWELEMENTSPROC               glDrawElements;
+PFNGLDRAWELEMENTSBASEVERTEXPROC     glDrawElementsBaseVertex;
+PFNGLMULTIDRAWELEMENTSBASEVERTEXPROC glMultiDrawElementsBaseVertex;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC  glMultiDrawElementsIndirect;
+
+// Queries
+PFNGLGENQUERIESPROC                 glGenQueries;
+PFNGLDELETEQUERIESPROC              glDeleteQueries;
+PFNGLBEGINQUERYPROC                 glBeginQuery;
+PFNGLENDQUERYPROC                   glEndQuery;
+PFNGLGETQUERYOBJECTIVPROC           glGetQueryObjectiv;
+PFNGLGETQUERYOBJECTUI64VPROC        glGetQueryObjectui64v;
+PFNGLQUERYCOUNTERPROC               glQueryCounter;
+
+// Every core function loaded from the context, glGetIntegerv is loaded first to check version
+static const OpenGLFunction CoreFunctions[] = {
+    GLFUNCTION( glGetString ),
+    GLFUNCTION( glGetStringi ),
+    GLFUNCTION( glGetFloatv ),
+    GLFUNCTION( glGetError ),
+    GLFUNCTION( glClearColor ),
+    GLFUNCTION( glClear ),
+    GLFUNCTION( glViewport ),
+    GLFUNCTION( glClearDepth ),
+    GLFUNCTION( glDepthFunc ),
+    GLFUNCTION( glDepthMask ),
+    GLFUNCTION( glBlendFunc ),
+    GLFUNCTION( glEnable ),
+    GLFUNCTION( glDisable ),
+    GLFUNCTION( glFrontFace ),
+    GLFUNCTION( glCullFace ),
+    GLFUNCTION( glPolygonMode ),
+    GLFUNCTION( glSampleCoverage ),
+    GLFUNCTION( glFinish ),
+
+    // Shaders
+    GLFUNCTION( glCreateShader ),
+    GLFUNCTION( glShaderSource ),
+    GLFUNCTION( glCompileShader ),
+    GLFUNCTION( glGetShaderiv ),
+    GLFUNCTION( glGetShaderInfoLog ),
+    GLFUNCTION( glDeleteShader ),
+    GLFUNCTION( glCreateProgram ),
+    GLFUNCTION( glAttachShader ),
+    GLFUNCTION( glLinkProgram ),
+    GLFUNCTION( glGetProgramiv ),
+    GLFUNCTION( glGetProgramInfoLog ),
+    GLFUNCTION( glUseProgram ),
+    GLFUNCTION( glDetachShader ),
+    GLFUNCTION( glDeleteProgram ),
+    GLOPTIONALFUNCTION( glGetProgramBinary ),                   // 4.1 or ARB_get_program_binary
+    GLOPTIONALFUNCTION( glProgramBinary ),
+    GLOPTIONALFUNCTION( glProgramParameteri ),
+
+    // Vertex arrays
+    GLFUNCTION( glGenVertexArrays ),
+    GLFUNCTION( glBindVertexArray ),
+    GLFUNCTION( glDeleteVertexArrays ),
+
+    // Buffers
+    GLFUNCTION( glGenBuffers ),
+    GLFUNCTION( glBindBuffer ),
+    GLFUNCTION( glBufferData ),
+    GLFUNCTION( glBufferSubData ),
+    GLFUNCTION( glDeleteBuffers ),
+    GLOPTIONALFUNCTION( glBufferStorage ),                      // 4.4 or ARB_buffer_storage
+    GLFUNCTION( glMapBufferRange ),
+    GLFUNCTION( glUnmapBuffer ),
+    GLOPTIONALFUNCTION( glCopyBufferSubData ),                  // 3.1 or ARB_copy_buffer
+
+    // Sync objects
+    GLOPTIONALFUNCTION( glFenceSync ),                          // 3.2 or ARB_sync
+    GLOPTIONALFUNCTION( glClientWaitSync ),
+    GLOPTIONALFUNCTION( glDeleteSync ),
+
+    // Framebuffers
+    GLFUNCTION( glGenFramebuffers ),
+    GLFUNCTION( glBindFramebuffer ),
+    GLFUNCTION( glDeleteFramebuffers ),
+    GLFUNCTION( glFramebufferTexture2D ),
+    GLFUNCTION( glCheckFramebufferStatus ),
+    GLFUNCTION( glDrawBuffer ),
+    GLFUNCTION( glDrawBuffers ),
+    GLFUNCTION( glReadBuffer ),
+    GLFUNCTION( glReadPixels ),
+
+    // Vertex attribs
+    GLFUNCTION( glVertexAttribPointer ),
+    GLFUNCTION( glBindAttribLocation ),
+    GLFUNCTION( glBindFragDataLocation ),
+    GLFUNCTION( glGetAttribLocation ),
+    GLFUNCTION( glGetActiveAttrib ),
+    GLFUNCTION( glEnableVertexAttribArray ),
+    GLFUNCTION( glDisableVertexAttribArray ),
+    GLFUNCTION( glGetVertexAttribiv ),
+    GLOPTIONALFUNCTION( glVertexAttribDivisor ),                // 3.3 or ARB_instanced_arrays
+
+    // Textures
+    GLFUNCTION( glGenTextures ),
+    GLFUNCTION( glDeleteTextures ),
+    GLFUNCTION( glBindTexture ),
+    GLFUNCTION( glActiveTexture ),
+    GLFUNCTION( glTexParameteri ),
+    GLFUNCTION( glTexImage2D ),
+    GLFUNCTION( glTexSubImage2D ),
+    GLFUNCTION( glPixelStorei ),
+    GLFUNCTION( glGenerateMipmap ),
+    GLOPTIONALFUNCTION( glGenSamplers ),                        // 3.3 or ARB_sampler_objects
+    GLOPTIONALFUNCTION( glDeleteSamplers ),
+    GLOPTIONALFUNCTION( glBindSampler ),
+    GLOPTIONALFUNCTION( glSamplerParameteri ),
+    GLOPTIONALFUNCTION( glSamplerParameterf ),
+    GLOPTIONALFUNCTION( glTexBuffer ),                          // 3.1 or ARB_texture_buffer_object
+
+    // Uniform paramters
+    GLFUNCTION( glGetActiveUniform ),
+    GLFUNCTION( glGetUniformLocation ),
+    GLFUNCTION( glUniform1fv ),
+    GLFUNCTION( glUniform2fv ),
+    GLFUNCTION( glUniform3fv ),
+    GLFUNCTION( glUniform4fv ),
+    GLFUNCTION( glUniform1iv ),
+    GLFUNCTION( glUniform2iv ),
+    GLFUNCTION( glUniform3iv ),
+    GLFUNCTION( glUniform4iv ),
+    GLFUNCTION( glUniform1i ),
+    GLFUNCTION( glUniformMatrix3fv ),
+    GLFUNCTION( glUniformMatrix4fv ),
+
+    // Drawing
+    GLFUNCTION( glDrawArrays ),
+    GLFUNCTION( glDrawElements ),
+    GLOPTIONALFUNCTION( glDrawElementsBaseVertex ),             // 3.2 or ARB_draw_elements_base_vertex
+    GLOPTIONALFUNCTION( glMultiDrawElementsBaseVertex ),        // 3.2 or ARB_draw_elements_base_vertex
+    GLOPTIONALFUNCTION( glMultiDrawElementsIndirect ),          // 4.3 or ARB_multi_draw_indirect
+
+    // Queries
+    GLFUNCTION( glGenQueries ),
+    GLFUNCTION( glDeleteQueries ),
+    GLFUNCTION( glBeginQuery ),
+    GLFUNCTION( glEndQuery ),
+    GLFUNCTION( glGetQueryObjectiv ),
+    GLOPTIONALFUNCTION( glGetQueryObjectui64v ),                // 3.3 or ARB_timer_query
+    GLOPTIONALFUNCTION( glQueryCounter ),                       // 3.3 or ARB_timer_query
+};
+
+bool LoadOpenGLCoreFunctions(const OpenGLProcLoader i_Loader) {
+    glGetIntegerv = (PFNGLGETINTEGERVPROC)i_Loader("glGetIntegerv");
+    if (!glGetIntegerv) {
+        UtilsInstance->ErrorMessage("Error Getting Function Address", "glGetIntegerv");
+        return false;
+    }
+
+    int MajorVersion, MinorVersion;
+    glGetIntegerv(GL_MAJOR_VERSION, &MajorVersion);
+    glGetIntegerv(GL_MINOR_VERSION, &MinorVersion);
+
+    // Application is designed for 3.0+ OGL version and forward compatible mode
+    // so if version is earlier than 3.0 there is no need to get entry points for other functions
+    if (MajorVersion < 3) {
+        return true;
+    }
+
+    // Acquire addresses of all core OpenGL functions in one pass, every missing one is reported
+    bool result = true;
+    for (size_t i = 0; i < sizeof(CoreFunctions) / sizeof(CoreFunctions[0]); ++i) {
+        *CoreFunctions[i].Address = i_Loader(CoreFunctions[i].Name);
+        if (!*CoreFunctions[i].Address && CoreFunctions[i].Required) {
+            UtilsInstance->ErrorMessage("Error Getting Function Address", CoreFunctions[i].Name);
+            result = false;
+        }
+    }
+    if (!result) {
+        return false;
+    }
+
+    // Hash extension names once so later checks are single lookups
+    GLint extension_count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+    GLExtensions.Clear();
+    for (GLint i = 0; i < extension_count; ++i) {
+        GLExtensions.Add((const char*)glGetStringi(GL_EXTENSIONS, i));
+    }
+
+    return true;
+}
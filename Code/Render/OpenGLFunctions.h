@@ -1,19 +1,35 @@
 #ifndef _OPENGL_FUNCTIONS_HEADER_
 #define _OPENGL_FUNCTIONS_HEADER_
 
+#ifdef _WIN32
 #include <Windows.h>
-#include <GL\glcorearb.h>
-#include <GL\wglext.h>
+#endif
+#include <GL/glcorearb.h>
+#include "../Utils/ExtensionSet.h"
+
+#ifdef _WIN32
+#include <GL/wglext.h>
 
 // WGL
 extern PFNWGLGETEXTENSIONSSTRINGARBPROC		wglGetExtensionsStringARB;
 extern PFNWGLCHOOSEPIXELFORMATARBPROC		wglChoosePixelFormatARB;
 extern PFNWGLCREATECONTEXTATTRIBSARBPROC	wglCreateContextAttribsARB;
+#endif
+
+// Extensions supported by current context, filled by LoadOpenGLCoreFunctions
+extern ExtensionSet GLExtensions;
+
+// Platform function returning address of OpenGL function of given name, nullptr if unavailable
+typedef void* (*OpenGLProcLoader)(const char* i_Name);
+
+// Get addresses of all OpenGL functions used by render from current context
+bool LoadOpenGLCoreFunctions(const OpenGLProcLoader i_Loader);
 
 // OGL
 extern PFNGLGETSTRINGPROC                   glGetString;
 extern PFNGLGETSTRINGIPROC                  glGetStringi;
 extern PFNGLGETINTEGERVPROC                 glGetIntegerv;
+extern PFNGLGETFLOATVPROC                   glGetFloatv;
 extern PFNGLGETERRORPROC                    glGetError;
 extern PFNGLVIEWPORTPROC                    glViewport;
 extern PFNGLCLEARPROC                       glClear;
@@ -28,6 +44,7 @@ extern PFNGLFRONTFACEPROC                   glFrontFace;
 extern PFNGLCULLFACEPROC                    glCullFace;
 extern PFNGLPOLYGONMODEPROC                 glPolygonMode;
 extern PFNGLSAMPLECOVERAGEPROC              glSampleCoverage;
+extern PFNGLFINISHPROC                      glFinish;
 
 // Shaders
 extern PFNGLCREATESHADERPROC                glCreateShader;
@@ -44,6 +61,9 @@ extern PFNGLGETPROGRAMINFOLOGPROC           glGetProgramInfoLog;
 extern PFNGLUSEPROGRAMPROC                  glUseProgram;
 extern PFNGLDETACHSHADERPROC                glDetachShader;
 extern PFNGLDELETEPROGRAMPROC               glDeleteProgram;
+extern PFNGLGETPROGRAMBINARYPROC            glGetProgramBinary;
+extern PFNGLPROGRAMBINARYPROC               glProgramBinary;
+extern PFNGLPROGRAMPARAMETERIPROC           glProgramParameteri;
 
 // Vertex arrays
 extern PFNGLGENVERTEXARRAYSPROC             glGenVertexArrays;
@@ -56,14 +76,26 @@ extern PFNGLBINDBUFFERPROC                  glBindBuffer;
 extern PFNGLBUFFERDATAPROC                  glBufferData;
 extern PFNGLBUFFERSUBDATAPROC               glBufferSubData;
 extern PFNGLDELETEBUFFERSPROC               glDeleteBuffers;
+extern PFNGLBUFFERSTORAGEPROC               glBufferStorage;
+extern PFNGLMAPBUFFERRANGEPROC              glMapBufferRange;
+extern PFNGLUNMAPBUFFERPROC                 glUnmapBuffer;
+extern PFNGLCOPYBUFFERSUBDATAPROC           glCopyBufferSubData;
+
+// Sync objects
+extern PFNGLFENCESYNCPROC                   glFenceSync;
+extern PFNGLCLIENTWAITSYNCPROC              glClientWaitSync;
+extern PFNGLDELETESYNCPROC                  glDeleteSync;
 
 // Framebuffer
 extern PFNGLGENFRAMEBUFFERSPROC             glGenFramebuffers;
 extern PFNGLBINDFRAMEBUFFERPROC             glBindFramebuffer;
+extern PFNGLDELETEFRAMEBUFFERSPROC          glDeleteFramebuffers;
 extern PFNGLFRAMEBUFFERTEXTURE2DPROC        glFramebufferTexture2D;
 extern PFNGLCHECKFRAMEBUFFERSTATUSPROC      glCheckFramebufferStatus;
 extern PFNGLDRAWBUFFERPROC                  glDrawBuffer;
 extern PFNGLDRAWBUFFERSPROC                 glDrawBuffers;
+extern PFNGLREADBUFFERPROC                  glReadBuffer;
+extern PFNGLREADPIXELSPROC                  glReadPixels;
 
 // Vertex attribs
 extern PFNGLVERTEXATTRIBPOINTERPROC         glVertexAttribPointer;
@@ -74,6 +106,7 @@ extern PFNGLGETACTIVEATTRIBPROC             glGetActiveAttrib;
 extern PFNGLENABLEVERTEXATTRIBARRAYPROC     glEnableVertexAttribArray;
 extern PFNGLDISABLEVERTEXATTRIBARRAYPROC    glDisableVertexAttribArray;
 extern PFNGLGETVERTEXATTRIBIVPROC           glGetVertexAttribiv;
+extern PFNGLVERTEXATTRIBDIVISORPROC         glVertexAttribDivisor;
 
 // Textures
 extern PFNGLGENTEXTURESPROC                 glGenTextures;
@@ -82,7 +115,15 @@ extern PFNGLBINDTEXTUREPROC                 glBindTexture;
 extern PFNGLACTIVETEXTUREPROC               glActiveTexture;
 extern PFNGLTEXPARAMETERIPROC               glTexParameteri;
 extern PFNGLTEXIMAGE2DPROC                  glTexImage2D;
+extern PFNGLTEXSUBIMAGE2DPROC               glTexSubImage2D;
+extern PFNGLPIXELSTOREIPROC                 glPixelStorei;
 extern PFNGLGENERATEMIPMAPPROC              glGenerateMipmap;
+extern PFNGLGENSAMPLERSPROC                 glGenSamplers;
+extern PFNGLDELETESAMPLERSPROC              glDeleteSamplers;
+extern PFNGLBINDSAMPLERPROC                 glBindSampler;
+extern PFNGLSAMPLERPARAMETERIPROC           glSamplerParameteri;
+extern PFNGLSAMPLERPARAMETERFPROC           glSamplerParameterf;
+extern PFNGLTEXBUFFERPROC                   glTexBuffer;
 
 // Uniform Parameters
 extern PFNGLGETACTIVEUNIFORMPROC            glGetActiveUniform;
@@ -102,5 +143,17 @@ extern PFNGLUNIFORMMATRIX4FVPROC            glUniformMatrix4fv;
 // Drawing
 extern PFNGLDRAWARRAYSPROC                  glDrawArrays;
 extern PFNGLDRAWELEMENTSPROC                glDrawElements;
+extern PFNGLDRAWELEMENTSBASEVERTEXPROC      glDrawElementsBaseVertex;
+extern PFNGLMULTIDRAWELEMENTSBASEVERTEXPROC glMultiDrawElementsBaseVertex;
+extern PFNGLMULTIDRAWELEMENTSINDIRECTPROC   glMultiDrawElementsIndirect;
+
+// Queries
+extern PFNGLGENQUERIESPROC                  glGenQueries;
+extern PFNGLDELETEQUERIESPROC               glDeleteQueries;
+extern PFNGLBEGINQUERYPROC                  glBeginQuery;
+extern PFNGLENDQUERYPROC                    glEndQuery;
+extern PFNGLGETQUERYOBJECTIVPROC            glGetQueryObjectiv;
+extern PFNGLGETQUERYOBJECTUI64VPROC         glGetQueryObjectui64v;
+extern PFNGLQUERYCOUNTERPROC                glQueryCounter;
 
 #endif // _OPENGL_FUNCTIONS_HEADER_
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "ProgramCache.h"
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include "../Utils/Hash.h"
+#include "../Utils/MappedFile.h"
+
+#define ProgramCacheMagic 0x47525053u                       // "SPRG"
+
+// Fixed part of a cache file, binary of BinaryLength bytes follows
+struct ProgramCacheHeader {
+    uint32_t        Magic;
+    uint32_t        Version;
+    uint64_t        Key;
+    uint32_t        BinaryFormat;
+    uint32_t        BinaryLength;
+};
+
+bool ProgramCache::IsSupported() {
+    if (!glGetProgramBinary || !glProgramBinary || !glProgramParameteri) {
+        return false;
+    }
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+uint64_t ProgramCache::HashDriver() {
+    const GLenum names[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    uint64_t hash = FNVOffsetBasis;
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+        const char* value = (const char*)glGetString(names[i]);
+        if (value) {
+            // Terminator keeps "ab"+"c" apart from "a"+"bc"
+            hash = HashBytes((const unsigned char*)value, strlen(value) + 1, hash);
+        }
+    }
+    return hash;
+}
+
+GLuint ProgramCache::Load(const char* i_Filename, const uint64_t i_Key) {
+    MappedFile file;
+    if (!file.Open(i_Filename) || file.GetSize() < sizeof(ProgramCacheHeader)) {
+        return 0;
+    }
+
+    ProgramCacheHeader header;
+    memcpy(&header, file.GetData(), sizeof(header));
+    if (header.Magic != ProgramCacheMagic || header.Version != ProgramCacheVersion || header.Key != i_Key ||
+        header.BinaryLength > file.GetSize() - sizeof(header)) {
+        return 0;
+    }
+
+    // Driver may still refuse the binary (e.g. after an update that kept its version string), caller then compiles
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.BinaryFormat, file.GetData() + sizeof(header), (GLsizei)header.BinaryLength);
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE) {
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+bool ProgramCache::Save(const char* i_Filename, const uint64_t i_Key, const GLuint i_Program) {
+    GLint length = 0;
+    glGetProgramiv(i_Program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return false;
+    }
+
+    std::vector<unsigned char> out(sizeof(ProgramCacheHeader) + (size_t)length);
+    GLsizei written = 0;
+    GLenum format = 0;
+    glGetProgramBinary(i_Program, length, &written, &format, out.data() + sizeof(ProgramCacheHeader));
+    if (written <= 0) {
+        return false;
+    }
+
+    const ProgramCacheHeader header = { ProgramCacheMagic, ProgramCacheVersion, i_Key, (uint32_t)format, (uint32_t)written };
+    memcpy(out.data(), &header, sizeof(header));
+
+    std::ofstream file(i_Filename, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    file.write((const char*)out.data(), (std::streamsize)(sizeof(header) + (size_t)written));
+    return file.good();
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include "OpenGLFunctions.h"
+
+// Program cache predifinitions
+#define ProgramCacheVersion 1                               // Bump whenever stored data or layout changes
+#define ProgramCacheExtension ".program"                    // Binary of Shaders/<name>.vp/.fp is stored as Shaders/<name>.program
+
+// Linked program binaries stored next to shader sources, keyed by a hash of sources, bound locations and driver
+// A binary only loads on the driver that wrote it, anything missing, stale or rejected is rebuilt from source
+class ProgramCache {
+
+public:
+	// Driver exposes program binaries in at least one format
+	static bool IsSupported();
+
+	// FNV-1a of vendor, renderer and version strings of the current context, part of every key
+	static uint64_t HashDriver();
+
+	// New linked program from stored binary, 0 when there is no usable one
+	static GLuint Load(const char* i_Filename, const uint64_t i_Key);
+
+	// Write binary of a linked program, program has to be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+	static bool Save(const char* i_Filename, const uint64_t i_Key, const GLuint i_Program);
+};
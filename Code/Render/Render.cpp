@@ -1,4 +1,8 @@
 #include "Render.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 
 #define TINYGLTF_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -9,15 +13,26 @@
 // G-Buffer buffer defs
 GLenum buffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
 
+// Loaded model placement: scaled by ModelScale after being moved by (-100, -200, -600) model units
+const float ModelScale = 0.0075f;
+const float ModelTranslation[3] = { -100.0f * ModelScale, -200.0f * ModelScale, -600.0f * ModelScale };
+// Ground plane placement
+const float PlaneTranslation[3] = { 0.0f, -2.0f, -5.0f };
+
 // Create render
-RenderClass::RenderClass(HDC* inDeviceContext, float* iWidth, float* iHeight) {
-    DeviceContext = inDeviceContext;
+RenderClass::RenderClass(float* iWidth, float* iHeight, const GLuint i_OutputFramebuffer, const LightingQuality i_Quality) {
     Width = iWidth;
     Height = iHeight;
+    OutputFramebuffer = i_OutputFramebuffer;
+    Quality = i_Quality;
 
     // Get perspective projection matrix
     float AspectRatio = (*Width) / (*Height);
-    GetPerspectiveProjectionMatrix(DefaultFOV, DefaultNearClipPlane, DefaultFarClipPlane, AspectRatio, ProjectionMatrix);
+    GetPerspectiveProjectionMatrix(DefaultFOV, DefaultNearClipPlane, DefaultFarClipPlane, AspectRatio, ProjectionMatrix.m);
+
+    // Plane never moves so its matrices are built once
+    PlaneModelViewMatrix = ToMat4(ComposeTRS<TransformKind::RotationOnly>(PlaneTranslation, QuatIdentity(), nullptr));
+    PlaneModelViewProjectionMatrix = Multiply(ProjectionMatrix, PlaneModelViewMatrix);
 
     // Create shaders and program objects
     if (!CreateShaders()) UtilsInstance->ErrorMessage("Shader Initialization Error", "Could not create shaders.", true);
@@ -25,12 +40,27 @@ RenderClass::RenderClass(HDC* inDeviceContext, float* iWidth, float* iHeight) {
     // Create and configure render
 	BindShaderUniformAdresses();
     CreateGBuffer();
-	PrepareScene();
+    CreateSamplers();
+
+    // Scene loads on its own thread, frames draw whatever is resident so far
+    Materials.CreateDefaults();
+    if (Staging.Create(StreamFrameBytes)) {
+        Geometry.SetStaging(&Staging);
+    }
+    // Model draws go out as multi draw indirect once their packets are compiled
+    if (RenderPassesV->IndirectBasePassProgram) {
+        Indirect.Create();
+    }
+    LoadTimer = PhaseTimer();
+    SceneLoader = std::thread(&RenderClass::LoadScene, this);
+    if (!StreamSceneLoading) {
+        FinishSceneLoading();
+    }
     BindTextures();
 	CreateGBRenderTargets();
 
     // Set viewport dimensions
-    glViewport(0, 0, (int)Width, (int)Height);
+    glViewport(0, 0, (int)*Width, (int)*Height);
 
     // Creatre fullscreen quad mesh
     CreateFullscreenQuad(*Width, *Height);
@@ -42,104 +72,178 @@ RenderClass::RenderClass(HDC* inDeviceContext, float* iWidth, float* iHeight) {
     glDisableVertexAttribArray(1);
     glDisableVertexAttribArray(0);
 
+    // GPU pass timing queries
+    PassTimer.Create();
+
     // Initial first frame render
     Render();
 };
 
 RenderClass::~RenderClass() {
 
+	// Loader writes scene members until it returns
+	if (SceneLoader.joinable()) {
+		SceneLoader.join();
+	}
+
 	// Destroy shaders
 	DestroyShaders();
 
+	// Destroy timing queries
+	PassTimer.Destroy();
+
 	// Destroy textures
 	glDeleteTextures(1, &Textures->BasePassRT);
 	glDeleteTextures(1, &Textures->ColorTexture);
 	glDeleteTextures(1, &Textures->NormalTexture);
 	glDeleteTextures(1, &Textures->PositionTexture);
 	glDeleteTextures(1, &Textures->DepthTexture);
+	Materials.Destroy();
+	for (size_t i = 0; i < PendingTextures.size(); ++i) {
+		if (PendingTextures[i].Texture && !PendingTextures[i].Sampled) {
+			glDeleteTextures(1, &PendingTextures[i].Texture);
+		}
+	}
+	Staging.Destroy();
+	Indirect.Destroy();
+	if (Textures->MaterialSampler) {
+		glDeleteSamplers(1, &Textures->MaterialSampler);
+	}
 
 	// Destroy geometry
     DestroyGeometry();
 }
 
-// Creates shaders and program objects used for drawing
+// Creates program objects used for drawing, linked programs come from the binary cache when the driver allows it
 bool RenderClass::CreateShaders() {
-    GLuint vshader, fshader;
+    PROFILE_FUNCTION();
 
-    // Base pass shaders
-    //
-    // Create vertex and fragment shaders for base pass
-    vshader = CreateShader("Shaders/BasePass.vp", GL_VERTEX_SHADER);
-    fshader = CreateShader("Shaders/BasePass.fp", GL_FRAGMENT_SHADER);
-    // Create program object for base pass
-    RenderPassesV->BasePassProgram = glCreateProgram();
+    PhaseTimer timer;
+    ProgramDriverHash = ProgramBinaryCache && ProgramCache::IsSupported() ? ProgramCache::HashDriver() : 0;
 
-    // Attach shaders to base pass program
-    glAttachShader(RenderPassesV->BasePassProgram, vshader);
-    glAttachShader(RenderPassesV->BasePassProgram, fshader);
+    // Base pass reads vertex streams 0-2 and writes the three G-Buffer targets
+    RenderPassesV->BasePassProgram = CreateProgram("BasePass", { "inPosition", "inTexCoord", "inNormal" }, { "oColor", "oNormal", "oPosition" });
+    // Indirect variant also reads the per instance draw index at DrawIndexLocation, the model falls back to direct draws without it
+    if (IndirectSceneDraws && IndirectDraws::IsSupported()) {
+        RenderPassesV->IndirectBasePassProgram = CreateProgram("BasePass", { "inPosition", "inTexCoord", "inNormal", "inDrawIndex" },
+            { "oColor", "oNormal", "oPosition" }, "#define INDIRECT_DRAW 1\n");
+    }
+    timer.Mark("Base pass");
 
-    // Link base pass program
-    glLinkProgram(RenderPassesV->BasePassProgram);
+    // Lighting pass draws the fullscreen quad into a single target, only the variant of the current quality is built now
+    Lighting.Create([this](const std::string& i_Defines) {
+        return CreateProgram("LightingPass", { "inPosition", "inTexcoord", "inTexcoord2" }, {}, i_Defines);
+    });
+    const bool lighting = SetLightingQuality(Quality);
+    timer.Mark("Lighting pass");
 
-    // Check linking status
-    UtilsInstance->CheckLinkingStatus(RenderPassesV->BasePassProgram);
+    // Warm start loaded every program from cache, cold start compiled at least one
+    const std::string title = std::string("Shaders (") + (ProgramsCached == ProgramsBuilt ? "warm" : "cold") + ", " + std::to_string(ProgramsCached) +
+        " of " + std::to_string(ProgramsBuilt) + " programs cached" + (ProgramDriverHash ? "" : ", no program binaries") + ")";
+    timer.Report(title.c_str());
 
-    // Bind streams of vertex data with proper shader attributes
-    glBindAttribLocation(RenderPassesV->BasePassProgram, 0, "inPosition");
-    glBindAttribLocation(RenderPassesV->BasePassProgram, 1, "inTexCoord");
-    glBindAttribLocation(RenderPassesV->BasePassProgram, 2, "inNormal");
+    return RenderPassesV->BasePassProgram && lighting;
+}
 
-    // Bind outputs from base pass shader
-    glBindFragDataLocation(RenderPassesV->BasePassProgram, 0, "oColor");
-    glBindFragDataLocation(RenderPassesV->BasePassProgram, 1, "oNormal");
-    glBindFragDataLocation(RenderPassesV->BasePassProgram, 2, "oPosition");
+// Insert define block right after the #version line, which may only be preceded by comments
+static void InjectDefines(std::string& io_Source, const std::string& i_Defines) {
+    const size_t version = io_Source.find("#version");
+    if (version == std::string::npos) {
+        io_Source.insert(0, i_Defines);
+        return;
+    }
+    const size_t line_end = io_Source.find('\n', version);
+    if (line_end == std::string::npos) {
+        io_Source += "\n" + i_Defines;
+        return;
+    }
+    io_Source.insert(line_end + 1, i_Defines);
+}
 
-    // Perform once again BasePassProgram linking to confirm introduced changes
-    glLinkProgram(RenderPassesV->BasePassProgram);
+GLuint RenderClass::CreateProgram(const char* i_Name, const std::vector<const char*>& i_Attributes, const std::vector<const char*>& i_Outputs,
+    const std::string& i_Defines) {
+    const std::string path = std::string(ShaderDirectory) + i_Name;
+    std::string vertex_source, fragment_source;
+    UtilsInstance->GetTextfileContents(path + ".vp", vertex_source);
+    UtilsInstance->GetTextfileContents(path + ".fp", fragment_source);
+    if (!i_Defines.empty()) {
+        InjectDefines(vertex_source, i_Defines);
+        InjectDefines(fragment_source, i_Defines);
+    }
+    ProgramsBuilt++;
+
+    // Key covers everything the binary depends on: both sources, bound locations and the driver
+    uint64_t key = HashBytes((const unsigned char*)vertex_source.data(), vertex_source.size(), ProgramDriverHash);
+    key = HashBytes((const unsigned char*)fragment_source.data(), fragment_source.size(), key);
+    const std::vector<const char*>* bindings[] = { &i_Attributes, &i_Outputs };
+    for (const std::vector<const char*>* names : bindings) {
+        const uint32_t count = (uint32_t)names->size();
+        key = HashBytes((const unsigned char*)&count, sizeof(count), key);
+        for (const char* name : *names) {
+            key = HashBytes((const unsigned char*)name, strlen(name) + 1, key);
+        }
+    }
 
-    // Lighting pass shaders
-    //
-    // Create vertex and fragment shaders for lighting pass
-    vshader = CreateShader("Shaders/LightingPass.vp", GL_VERTEX_SHADER);
-    fshader = CreateShader("Shaders/LightingPass.fp", GL_FRAGMENT_SHADER);
-
-    // Create program object for lighting pass
-    RenderPassesV->LightingPassProgram = glCreateProgram();
-
-    // Attach shaders to lighting pass program
-    glAttachShader(RenderPassesV->LightingPassProgram, vshader);
-    glAttachShader(RenderPassesV->LightingPassProgram, fshader);
-    // Link lighting pass program
-    glLinkProgram(RenderPassesV->LightingPassProgram);
-
-    // Check linking status
-    UtilsInstance->CheckLinkingStatus(RenderPassesV->LightingPassProgram);
-    
-    // Bind streams of vertex data with proper shader attributes
-    glBindAttribLocation(RenderPassesV->LightingPassProgram, 0, "inPosition"); // 0-th
-    glBindAttribLocation(RenderPassesV->LightingPassProgram, 1, "inTexcoord"); // 1-st
-    glBindAttribLocation(RenderPassesV->LightingPassProgram, 2, "inTexcoord2"); // 2-nd
-
-    // Link lighting pass program again so the new configuration is confirmed
-    glLinkProgram(RenderPassesV->LightingPassProgram);
-    return true;
+    // Every permutation has its own file so switching between them does not evict the others
+    std::string cache_file = path;
+    if (!i_Defines.empty()) {
+        char permutation[20];
+        snprintf(permutation, sizeof(permutation), ".%08x", (unsigned int)HashBytes((const unsigned char*)i_Defines.data(), i_Defines.size()));
+        cache_file += permutation;
+    }
+    cache_file += ProgramCacheExtension;
+    if (ProgramDriverHash) {
+        const GLuint program = ProgramCache::Load(cache_file.c_str(), key);
+        if (program) {
+            ProgramsCached++;
+            return program;
+        }
+    }
+
+    GLuint vshader = CreateShader(vertex_source, GL_VERTEX_SHADER);
+    GLuint fshader = CreateShader(fragment_source, GL_FRAGMENT_SHADER);
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vshader);
+    glAttachShader(program, fshader);
+
+    // Locations are applied by the link, binding them first makes a single link enough
+    for (size_t i = 0; i < i_Attributes.size(); ++i) {
+        glBindAttribLocation(program, (GLuint)i, i_Attributes[i]);
+    }
+    for (size_t i = 0; i < i_Outputs.size(); ++i) {
+        glBindFragDataLocation(program, (GLuint)i, i_Outputs[i]);
+    }
+    if (ProgramDriverHash) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(program);
+    UtilsInstance->CheckLinkingStatus(program);
+
+    // Linked program keeps its own code
+    glDetachShader(program, vshader);
+    glDetachShader(program, fshader);
+    glDeleteShader(vshader);
+    glDeleteShader(fshader);
+
+    if (ProgramDriverHash && !ProgramCache::Save(cache_file.c_str(), key, program)) {
+        UtilsInstance->ErrorMessage("Program Cache Warning", "Could not write program binary");
+    }
+    return program;
 }
 
 // Destroy shaders for each created render pass
 void RenderClass::DestroyShaders() {
     glDeleteProgram(RenderPassesV->BasePassProgram);
-    glDeleteProgram(RenderPassesV->LightingPassProgram);
+    glDeleteProgram(RenderPassesV->IndirectBasePassProgram);
+    RenderPassesV->IndirectBasePassProgram = 0;
+    Lighting.Destroy();
+    RenderPassesV->LightingPassProgram = 0;
 }
 
-// Creates shader object of a given type from given file
-GLuint RenderClass::CreateShader(const std::string i_Filename, const GLenum i_Type) {
-    std::string source_code;
-
-    // Read source code from selected file
-    UtilsInstance->GetTextfileContents(i_Filename, source_code);
-
-    const char* code = source_code.c_str();
-    int length = source_code.length();
+// Creates shader object of a given type from given source code
+GLuint RenderClass::CreateShader(const std::string& i_Source, const GLenum i_Type) {
+    const char* code = i_Source.c_str();
+    int length = (int)i_Source.length();
 
     // Create shader object
     GLuint shader = glCreateShader(i_Type);
@@ -159,6 +263,7 @@ GLuint RenderClass::CreateShader(const std::string i_Filename, const GLenum i_Ty
         UtilsInstance->ErrorMessage("Shader Initialization Error", compilation_info);
         // Delete created shader object
         glDeleteShader(shader);
+        shader = 0;
     }
     return shader;
 }
@@ -175,10 +280,25 @@ void RenderClass::ResetOGLStateDefault() {
 
 // Main render runtime
 void RenderClass::Render() {
+    PROFILE_FUNCTION();
+
+    // Once the whole scene is resident a frame should not touch the heap, the first such frame may still
+    // let the driver build state for draws it has not seen yet
+    const bool resident = IsSceneResident();
+#if defined(ALLOCATION_COUNTING)
+    const bool steady_state = resident && SteadyFrames > 0;
+#endif
+    const uint64_t allocations = ALLOCATION_COUNT();
 
     // Update move variables
-    Angle = Angle > 99333 ? 0 : Angle + 0.05f;
-    LightDistance = LightDistance > 4.1415 ? 0 : LightDistance - 0.0f;
+    if (!AnimationScripted) {
+        Angle = Angle > 99333 ? 0 : Angle + 0.05f;
+        LightDistance = LightDistance > 4.1415 ? 0 : LightDistance - 0.0f;
+    }
+    FrameDraws = DrawStats();
+
+    // Resident part of the scene grows by a budget every frame
+    StreamScene(StreamFrameBytes);
 
     // Update light position
     glUseProgram(RenderPassesV->LightingPassProgram);
@@ -188,6 +308,8 @@ void RenderClass::Render() {
     //Base render pass//
     ////////////////////
     // 
+    PassTimer.Begin(GPUPassBase);
+
     // Activate render target (framebuffer object) for base pass
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, Textures->BasePassRT);
 
@@ -205,41 +327,51 @@ void RenderClass::Render() {
     // Active shader program for base pass
     glUseProgram(RenderPassesV->BasePassProgram );
 
-    // Loaded model
-    GetYRotationMatrix(Angle, ModelViewMatrix);
-    Translate(-100.0f, -200.0f, -600.0f, ModelViewMatrix);
-	Scale(0.0075f, 0.0075f, 0.0075f, ModelViewMatrix);
-    // Calculate MVP matrix for it
-    Multiply(ProjectionMatrix, ModelViewMatrix, ModelViewProjectionMatrix);
-    // Set values of shader uniform variables - MVP and MV matrices
-    glUniformMatrix4fv(Handlers->MVPMatrixHandle, 1, false, ModelViewProjectionMatrix);
-    glUniformMatrix4fv(Handlers->MVMatrixHandle, 1, false, ModelViewMatrix);
-   
-    drawModel(vaoAndEbos, model);
+    // Loaded model - per node MVP and MV matrices are set while drawing
+    if (SceneAdopted) {
+        UpdateModelTransform();
+        drawModel();
+    }
 
     // Activate VAO for drawing plane
     glBindVertexArray(GPlaneVAO);
+    // Plane has no material of its own and samples the first model material, defaults while the scene loads
+    if (SceneAdopted) {
+        Materials.Bind(Materials.MaterialIndex(0));
+    }
+    else {
+        Materials.BindDefaults();
+    }
+    FrameDraws.MaterialBinds++;
     // Plane
-    // Place plane at proper position
-    GetTranslationMatrix(0.0f, -2.0f, -5.0f, ModelViewMatrix);
-    // Calculate MVP matrix
-    Multiply(ProjectionMatrix, ModelViewMatrix, ModelViewProjectionMatrix);
     // Set values of shader uniform variables
-    glUniformMatrix4fv(Handlers->MVPMatrixHandle, 1, false, ModelViewProjectionMatrix);
-    glUniformMatrix4fv(Handlers->MVMatrixHandle, 1, false, ModelViewMatrix);
+    glUniformMatrix4fv(Handlers->MVPMatrixHandle, 1, false, PlaneModelViewProjectionMatrix.m);
+    glUniformMatrix4fv(Handlers->MVMatrixHandle, 1, false, PlaneModelViewMatrix.m);
+    // Plane vertices are floats
+    const float plane_scale[3] = { 1.0f, 1.0f, 1.0f };
+    const float plane_offset[3] = { 0.0f, 0.0f, 0.0f };
+    glUniform3fv(Handlers->PositionScaleHandle, 1, plane_scale);
+    glUniform3fv(Handlers->PositionOffsetHandle, 1, plane_offset);
+    glUniform1i(Handlers->PackedNormalHandle, 0);
     // Draw plane using VAO
     glDrawArrays(GL_TRIANGLES, 0, 6);
+    FrameDraws.DrawCalls++;
+    FrameDraws.Triangles += 2;
+
+    PassTimer.End(GPUPassBase);
 
     //////////////////////////
     // Lighting render pass //
     //////////////////////////
     //
-    // Deactivate render target (disable FBO) before postprocess lighting phase
-    // From now rendering will be performed normally, to window
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    PassTimer.Begin(GPUPassLighting);
+
+    // Switch from G-Buffer to output target before postprocess lighting phase
+    // From now rendering will be performed to window or to offscreen output framebuffer
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, OutputFramebuffer);
 
-    // Set the back buffer as a target for drawing commands
-    glDrawBuffer(GL_BACK);
+    // Set the back buffer (or output color attachment) as a target for drawing commands
+    glDrawBuffer(OutputFramebuffer ? GL_COLOR_ATTACHMENT0 : GL_BACK);
 
     // Clear color and depth of a back buffer
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -251,21 +383,103 @@ void RenderClass::Render() {
     glUseProgram(RenderPassesV->LightingPassProgram);
 
     // Set projection matrix for lighting pass
-    glUniformMatrix4fv(Handlers->PMatrixHandle, 1, false, ProjectionMatrix);
+    glUniformMatrix4fv(Handlers->PMatrixHandle, 1, false, ProjectionMatrix.m);
 
     // Activate VAO for drawing fullscreen quad
     glBindVertexArray(GQuadVAO);
 
     // Draw quad using VAO and TRIANGLES primitive
     glDrawArrays(GL_TRIANGLES, 0, 6);
+    FrameDraws.DrawCalls++;
+    FrameDraws.Triangles += 2;
 
     // Disable VAO - it is always good to disable all OpenGL objects when they are not required
     glBindVertexArray( 0 );
 
-    // Swap back and front buffers (SwapChain)
-    SwapBuffers( *DeviceContext );
+    PassTimer.End(GPUPassLighting);
+    PassTimer.EndFrame();
+
+    FrameDraws.HeapAllocations = ALLOCATION_COUNT() - allocations;
+#if defined(ALLOCATION_COUNTING)
+    // Counting builds exist to catch regressions, so an allocating steady frame ends the run
+    if (steady_state && FrameDraws.HeapAllocations > 0) {
+        const std::string message = "Steady frame made " + std::to_string(FrameDraws.HeapAllocations) + " heap allocations";
+        UtilsInstance->ErrorMessage("Allocation Check Error", message.c_str(), true);
+    }
+#endif
+    SteadyFrames = resident ? SteadyFrames + 1 : 0;
+}
+
+bool RenderClass::SetLightingQuality(const LightingQuality i_Quality) {
+    const LightingVariant* variant = Lighting.Get(LightingFeatures::Preset(i_Quality));
+    if (!variant) {
+        UtilsInstance->ErrorMessage("Shader Initialization Error", "Could not build lighting pass permutation.");
+        return false;
+    }
+    Quality = i_Quality;
+    SteadyFrames = 0;
+
+    // Frame code keeps using the lighting program and handles, they now belong to the selected variant
+    RenderPassesV->LightingPassProgram = variant->Program;
+    Handlers->ColorTextureHandle = variant->ColorTextureHandle;
+    Handlers->NormalTextureHandle = variant->NormalTextureHandle;
+    Handlers->PositionTextureHandle = variant->PositionTextureHandle;
+    Handlers->LightDistanceHandle = variant->LightDistanceHandle;
+    Handlers->PMatrixHandle = variant->PMatrixHandle;
+    return true;
+}
+
+void RenderClass::SetIndirectDraws(const bool i_Enabled) {
+    IndirectEnabled = i_Enabled;
+    SteadyFrames = 0;
+}
+
+void RenderClass::SetAnimation(const float i_Angle, const float i_LightDistance) {
+    AnimationScripted = true;
+    Angle = i_Angle;
+    LightDistance = i_LightDistance;
+}
+
+void RenderClass::SetCamera(const float* i_Position, const float i_Pitch) {
+    CameraScripted = true;
+    ViewTransform = Inverse<TransformKind::RotationOnly>(ComposeTRS<TransformKind::RotationOnly>(i_Position, QuatFromAxisAngle(1.0f, 0.0f, 0.0f, i_Pitch), nullptr));
+
+    // Plane moves with the camera, model transform is rebuilt on the next frame
+    const Affine plane = Multiply(ViewTransform, ComposeTRS<TransformKind::RotationOnly>(PlaneTranslation, QuatIdentity(), nullptr));
+    PlaneModelViewMatrix = ToMat4(plane);
+    PlaneModelViewProjectionMatrix = Multiply(ProjectionMatrix, plane);
+    TransformAngle = -1.0f;
+}
+
+bool RenderClass::SetMaterialFilter(const MaterialFilter i_Filter) {
+    if (!Textures->MaterialSampler) {
+        return false;
+    }
+    Filter = i_Filter;
+    SteadyFrames = 0;
+
+    glSamplerParameteri(Textures->MaterialSampler, GL_TEXTURE_MIN_FILTER, i_Filter == MaterialFilterBaseLevel ? GL_LINEAR : GL_LINEAR_MIPMAP_LINEAR);
+    if (MaterialAnisotropy > 1.0f) {
+        glSamplerParameterf(Textures->MaterialSampler, GL_TEXTURE_MAX_ANISOTROPY, i_Filter == MaterialFilterAnisotropic ? MaterialAnisotropy : 1.0f);
+    }
+    return true;
 }
                                                                                                  
+// Rebuild model transform with one fused TRS write when rotation angle changed since last frame
+void RenderClass::UpdateModelTransform() {
+    if (Angle == TransformAngle) {
+        return;
+    }
+    TransformAngle = Angle;
+
+    ModelTransform = ComposeTRS<TransformKind::UniformScale>(ModelTranslation, QuatFromAxisAngle(0.0f, 1.0f, 0.0f, Angle), &ModelScale);
+    if (CameraScripted) {
+        ModelTransform = Multiply(ViewTransform, ModelTransform);
+    }
+    ModelViewMatrix = ToMat4(ModelTransform);
+    ModelViewProjectionMatrix = Multiply(ProjectionMatrix, ModelTransform);
+}
+
 // Calculates aspect ratio and updates viewport size and fullscreen quad mesh                                
 void RenderClass::Resize(const int i_Width, const int i_Height) {
     int w = i_Width;
@@ -276,14 +490,15 @@ void RenderClass::Resize(const int i_Width, const int i_Height) {
 
     // Update viewport dimensions
     glViewport(0, 0, w, h);
+    SteadyFrames = 0;
     // Update fullscreen quad mesh
     CreateFullscreenQuad((float)w, (float)h);
 }
 
 // Handle key messages and update
-void RenderClass::UpdateParameters(WPARAM i_wParam, LPARAM i_lParam) {
+void RenderClass::UpdateParameters(const unsigned int i_Key) {
 	// Switch for key messages by keys defined in KeysConfiguration.h
-    switch (i_wParam) {
+    switch (i_Key) {
 		// Rotate mesh to the left
         case ButtonsDefinitions::ChangeMeshesRotationL: {
             Angle -= 1.0f;
@@ -308,6 +523,83 @@ void RenderClass::UpdateParameters(WPARAM i_wParam, LPARAM i_lParam) {
             glUniform1fv(Handlers->LightDistanceHandle, 1, &LightDistance);
             break;
         }
+        // Cycle lighting quality, a permutation is compiled the first time it is picked
+        case ButtonsDefinitions::ChangeLightingQuality: {
+            if (SetLightingQuality((LightingQuality)((Quality + 1) % LightingQualityCount))) {
+                std::cout << "Lighting quality: " << LightingQualityName(Quality) << " (" << Lighting.Count() << " permutations built)" << std::endl;
+            }
+            break;
+        }
+        // Compare multi draw indirect with packet by packet submission
+        case ButtonsDefinitions::ToggleIndirectDraws: {
+            SetIndirectDraws(!IndirectEnabled);
+            std::cout << "Model draws: " << (IndirectEnabled ? "indirect" : "direct") << (Indirect.IsCreated() ? "" : " (indirect not supported)") << std::endl;
+            break;
+        }
+        // Print frame statistics
+        case ButtonsDefinitions::DumpStatsButton: {
+            DumpStats();
+            break;
+        }
+    }
+}
+
+void RenderClass::DumpStats() const {
+    static const char* pass_names[GPUPassCount] = { "Base pass", "Lighting pass" };
+
+    std::cout << "Frame stats:" << std::endl;
+    if (SceneFailed) {
+        std::cout << "  Scene: failed to load, only the plane is drawn" << std::endl;
+    }
+    else if (!IsSceneResident()) {
+        std::cout << "  Scene: " << (SceneAdopted ? "streaming" : "loading") << std::endl;
+    }
+    std::cout << "  Culling: tested " << Culling.Tested << ", culled " << Culling.Culled << ", drawn " << Culling.Drawn
+        << ", nodes visited " << Culling.NodesVisited << std::endl;
+    std::cout << "  Draws: " << FrameDraws.DrawCalls << " calls, " << FrameDraws.Triangles << " triangles, "
+        << FrameDraws.MaterialBinds << " material binds" << std::endl;
+    if (IsDrawingIndirect()) {
+        std::cout << "  Indirect: " << FrameDraws.IndirectCommands << " commands in " << Indirect.BucketCount() << " buckets" << std::endl;
+    }
+    std::cout << "  Geometry: " << Geometry.VertexBytes() / 1024 << " KB vertices, " << Geometry.IndexBytes() / 1024 << " KB indices in "
+        << Geometry.BufferCount() << " buffers, " << FrameDraws.VertexArrayBinds << " vertex array binds" << std::endl;
+    std::cout << "  Clusters: tested " << FrameDraws.ClustersTested << ", culled " << FrameDraws.ClustersCulled;
+    if (FrameDraws.ClustersTested) {
+        std::cout << " (" << 100.0 * FrameDraws.ClustersCulled / FrameDraws.ClustersTested << "%)";
+    }
+    std::cout << std::endl;
+#if defined(ALLOCATION_COUNTING)
+    std::cout << "  Heap allocations: " << FrameDraws.HeapAllocations << std::endl;
+#endif
+    std::cout << "  LOD draws:";
+    for (int level = 0; level < MaxLodLevels; ++level) {
+        std::cout << " " << FrameDraws.LodDraws[level];
+    }
+    std::cout << std::endl;
+    if (SceneAdopted) {
+        std::cout << "  Materials: " << Materials.Size() << " (with default), " << Materials.UploadedImages() << " textures" << std::endl;
+    }
+    std::cout << "  Lighting: " << LightingQualityName(Quality) << " quality, " << Lighting.Count() << " permutations built" << std::endl;
+
+    if (!PassTimer.IsSupported()) {
+        std::cout << "  GPU timer queries not supported" << std::endl;
+        return;
+    }
+    if (!PassTimer.HasResults()) {
+        std::cout << "  GPU results not available yet" << std::endl;
+        return;
+    }
+
+    const GPUFrameStats& gpu = PassTimer.LatestResults();
+    std::cout << "  GPU frame " << gpu.Frame << ": " << gpu.FrameMilliseconds << " ms, dropped frames " << PassTimer.DroppedFrames() << std::endl;
+    for (int pass = 0; pass < GPUPassCount; ++pass) {
+        std::cout << "  " << pass_names[pass] << ": " << gpu.PassMilliseconds[pass] << " ms";
+        if (PassTimer.HasStatistics()) {
+            std::cout << ", vertices " << gpu.Statistics[pass][GPUStatisticVertices]
+                << ", primitives " << gpu.Statistics[pass][GPUStatisticPrimitives]
+                << ", fragments " << gpu.Statistics[pass][GPUStatisticFragments];
+        }
+        std::cout << std::endl;
     }
 }
 
@@ -318,40 +610,47 @@ void RenderClass::BindShaderUniformAdresses() {
     Handlers->DiffuseTextureHandle = glGetUniformLocation(RenderPassesV->BasePassProgram, "uTexture");
     Handlers->DiffuseNormalTextureHandle = glGetUniformLocation(RenderPassesV->BasePassProgram, "uNormalTexture");
     Handlers->DiffusePBRTextureHandle = glGetUniformLocation(RenderPassesV->BasePassProgram, "uPBRTexture");
-    Handlers->ColorTextureHandle = glGetUniformLocation(RenderPassesV->LightingPassProgram, "uColor");
-    Handlers->NormalTextureHandle = glGetUniformLocation(RenderPassesV->LightingPassProgram, "uNormal");
-    Handlers->PositionTextureHandle = glGetUniformLocation(RenderPassesV->LightingPassProgram, "uPosition");
-    Handlers->LightDistanceHandle = glGetUniformLocation(RenderPassesV->LightingPassProgram, "uLightDistance");
-    Handlers->PMatrixHandle = glGetUniformLocation(RenderPassesV->LightingPassProgram, "uPMatrix");
+    Handlers->PositionScaleHandle = glGetUniformLocation(RenderPassesV->BasePassProgram, "uPositionScale");
+    Handlers->PositionOffsetHandle = glGetUniformLocation(RenderPassesV->BasePassProgram, "uPositionOffset");
+    Handlers->PackedNormalHandle = glGetUniformLocation(RenderPassesV->BasePassProgram, "uPackedNormal");
 }
 
 // Activate and bind textures, configure handles for render passes and deactivate any texture units
 void RenderClass::BindTextures() {
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, Textures->DiffuseTexture);
     glActiveTexture(GL_TEXTURE1);
     glBindTexture(GL_TEXTURE_RECTANGLE, Textures->ColorTexture);
     glActiveTexture(GL_TEXTURE2);
     glBindTexture(GL_TEXTURE_RECTANGLE, Textures->NormalTexture);
     glActiveTexture(GL_TEXTURE3);
     glBindTexture(GL_TEXTURE_RECTANGLE, Textures->PositionTexture);
-    glActiveTexture(GL_TEXTURE4);
-    glBindTexture(GL_TEXTURE_2D, Textures->DiffuseNormalTexture);
-    glActiveTexture(GL_TEXTURE5);
-    glBindTexture(GL_TEXTURE_2D, Textures->DiffusePBRTexture);
+
+    // Material textures are bound per draw, their units share one sampler
+    // G-Buffer units keep their texture parameters
+    if (Textures->MaterialSampler) {
+        for (int slot = 0; slot < MaterialSlotCount; ++slot) {
+            glBindSampler(MaterialLibrary::TextureUnit((MaterialSlot)slot), Textures->MaterialSampler);
+        }
+    }
 
     // Set values for shader uniform parameters for base pass
     glUseProgram(RenderPassesV->BasePassProgram);
-    glUniform1i(Handlers->DiffuseTextureHandle, 0);
-    glUniform1i(Handlers->DiffuseNormalTextureHandle, 4);
-    glUniform1i(Handlers->DiffusePBRTextureHandle, 5);
+    glUniform1i(Handlers->DiffuseTextureHandle, MaterialLibrary::TextureUnit(MaterialSlotBaseColor));
+    glUniform1i(Handlers->DiffuseNormalTextureHandle, MaterialLibrary::TextureUnit(MaterialSlotNormal));
+    glUniform1i(Handlers->DiffusePBRTextureHandle, MaterialLibrary::TextureUnit(MaterialSlotPBR));
+
+    // Indirect base pass samples the same units, its draw records have a unit of their own
+    if (RenderPassesV->IndirectBasePassProgram) {
+        const GLuint program = RenderPassesV->IndirectBasePassProgram;
+        glUseProgram(program);
+        glUniform1i(glGetUniformLocation(program, "uTexture"), MaterialLibrary::TextureUnit(MaterialSlotBaseColor));
+        glUniform1i(glGetUniformLocation(program, "uNormalTexture"), MaterialLibrary::TextureUnit(MaterialSlotNormal));
+        glUniform1i(glGetUniformLocation(program, "uPBRTexture"), MaterialLibrary::TextureUnit(MaterialSlotPBR));
+        glUniform1i(glGetUniformLocation(program, "uDrawData"), DrawDataTextureUnit);
+        glUniform1i(glGetUniformLocation(program, "uPackedNormal"), QuantizedVertexFormat);
+    }
 
-    // Set values for shader uniform parameters for lighting pass
-    glUseProgram(RenderPassesV->LightingPassProgram);
-    glUniform1i(Handlers->ColorTextureHandle, 1);
-    glUniform1i(Handlers->NormalTextureHandle, 2);
-    glUniform1i(Handlers->PositionTextureHandle, 3);
+    // Lighting pass variants get their texture units when they are built
 
     // Deactivate any texture units
     glActiveTexture(GL_TEXTURE8);
@@ -359,6 +658,31 @@ void RenderClass::BindTextures() {
     glBindTexture(GL_TEXTURE_RECTANGLE, 0);
 }
 
+// Sampler object used by every material texture: trilinear, repeat, anisotropic where supported
+void RenderClass::CreateSamplers() {
+    if (!glGenSamplers || !glBindSampler || !glSamplerParameteri || !glSamplerParameterf || !glDeleteSamplers) {
+        return;
+    }
+
+    glGenSamplers(1, &Textures->MaterialSampler);
+    glSamplerParameteri(Textures->MaterialSampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glSamplerParameteri(Textures->MaterialSampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glSamplerParameteri(Textures->MaterialSampler, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glSamplerParameteri(Textures->MaterialSampler, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    // Anisotropic filtering is core only since 4.6, both extensions use the same enums
+    GLint major_version = 0, minor_version = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major_version);
+    glGetIntegerv(GL_MINOR_VERSION, &minor_version);
+    const bool core_anisotropy = major_version > 4 || (major_version == 4 && minor_version >= 6);
+    if (core_anisotropy || GLExtensions.Has("GL_ARB_texture_filter_anisotropic") || GLExtensions.Has("GL_EXT_texture_filter_anisotropic")) {
+        float max_anisotropy = 1.0f;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &max_anisotropy);
+        MaterialAnisotropy = max_anisotropy < MaxMaterialAnisotropy ? max_anisotropy : MaxMaterialAnisotropy;
+        glSamplerParameterf(Textures->MaterialSampler, GL_TEXTURE_MAX_ANISOTROPY, MaterialAnisotropy);
+    }
+}
+
 // Create G-Buffer for all data stored in base pass
 void RenderClass::CreateGBuffer() {
     Textures->ColorTexture = CreateRectTexture((size_t)*Width, (size_t)*Height, GL_RGBA, GL_RGBA16F, GL_HALF_FLOAT);
@@ -368,13 +692,210 @@ void RenderClass::CreateGBuffer() {
 }
 
 // Scene setup
-void RenderClass::PrepareScene() {
+// Scene loader thread: parse or map the scene, decode images, build mip chains and prepare geometry, no GL calls
+// Results are handed over through SceneLoaded, render thread does not touch scene members before that
+void RenderClass::LoadScene() {
+    PROFILE_FUNCTION();
+
+    PhaseTimer& timer = LoadTimer;
+
+    MappedFile binary_scene;
+    const bool binary = binary_scene.Open(SceneBinaryFile);
+    binary_scene.Close();
+    const char* source = binary ? SceneBinaryFile : SceneTextFile;
+    SceneSource = source;
+
+    // Cooked package is used only when it was made from exactly the same source files
+    // Mesh optimizer settings are part of the key, cooked geometry is their output
+    const uint32_t optimizer_settings[2] = { OptimizeMeshesOnLoad, MeshOptimizerVersion };
+    uint64_t source_hash = 0;
+    const bool source_readable = SceneCache::HashSource(source, source_hash);
+    source_hash = HashBytes((const unsigned char*)optimizer_settings, sizeof(optimizer_settings), source_hash);
+    timer.Mark("Source hash");
+    SceneCooked = source_readable && CookedScene.Load(SceneCacheFile, source_hash, model);
+    if (SceneCooked) {
+        timer.Mark("Cooked load");
+        Materials.Build(model);
+        for (size_t i = 0; i < model.images.size(); ++i) {
+            if (Materials.IsImageUsed((int)i)) {
+                PendingTextures.emplace_back();
+                if (!prepareTexture(model, (int)i, Materials.ImageContent((int)i), PendingTextures.back())) {
+                    PendingTextures.pop_back();
+                }
+            }
+        }
+        timer.Mark("Texture preparation");
+    }
+    else {
+        DeferredImages images;
+        // Render thread reports the failure when it takes the results, the loader must not end the process under it
+        if (!loadModel(model, source, &images, SceneLoadError)) {
+            model = tinygltf::Model();
+            SceneLoaded.store(true, std::memory_order_release);
+            return;
+        }
+        timer.Mark("glTF parse");
+
+        // Images no material refers to are never decoded
+        Materials.Build(model);
+        images.Images.erase(std::remove_if(images.Images.begin(), images.Images.end(),
+            [this](const DeferredImage& i_Image) { return !Materials.IsImageUsed(i_Image.Index); }), images.Images.end());
+
+        // Images decode on worker threads, mip chains of each one are built as soon as it is ready
+        DecodeImages(model, images, [this](const int i_Image) {
+            PendingTextures.emplace_back();
+            if (!prepareTexture(model, i_Image, Materials.ImageContent(i_Image), PendingTextures.back())) {
+                PendingTextures.pop_back();
+            }
+        });
+        timer.Mark("Image decode and mips");
+
+        if (OptimizeMeshesOnLoad) {
+            MeshOptimizationStats stats;
+            if (OptimizeModelMeshes(model, stats)) {
+                std::cout << "Mesh optimization: " << stats.Primitives << " primitives, vertices " << stats.VerticesBefore << " -> " << stats.VerticesAfter
+                    << ", ACMR " << stats.Before.ACMR() << " -> " << stats.After.ACMR() << ", ATVR " << stats.Before.ATVR() << " -> " << stats.After.ATVR()
+                    << ", " << stats.NarrowedPrimitives << " narrowed to 16 bit indices" << std::endl;
+            }
+            timer.Mark("Mesh optimization");
+        }
+
+        // Cook now while buffers and decoded images are still in memory, a source that was not fully read could never match it
+        if (source_readable && !SceneCache::Save(SceneCacheFile, source_hash, model)) {
+            UtilsInstance->ErrorMessage("Scene Cache Warning", "Could not write cooked scene");
+        }
+        timer.Mark("Cook");
+    }
+
+    // Decoded base level pixels move to the pending textures, the model keeps no copy, cooked ones stay in the mapping
+    if (!SceneCooked) {
+        for (size_t i = 0; i < PendingTextures.size(); ++i) {
+            PendingTextures[i].Pixels.swap(model.images[PendingTextures[i].Image].image);
+            PendingTextures[i].BasePixels = PendingTextures[i].Pixels.data();
+        }
+    }
 
-    if (!loadModel(model, "../Resources/scene.gltf")) {
-		UtilsInstance->ErrorMessage("Model Loading Error", "Could not load model", true);
+    // Flatten node hierarchy and compute world matrices
+    Nodes.Build(model, model.defaultScene);
+    // Collect primitives with their bounds for culling
+    BuildPrimitiveList();
+    UpdatePrimitiveBounds(0, Primitives.size());
+    if (Primitives.size() >= BVHCullingThreshold) {
+        PrimitiveHierarchy.Build(PrimitiveWorldBounds.data(), PrimitiveWorldBounds.size());
     }
 
-    vaoAndEbos = bindModel(model);
+    prepareGeometry(model);
+    timer.Mark("Geometry preparation");
+
+    SceneLoaded.store(true, std::memory_order_release);
+}
+
+// Take over loader results once it is done, then upload pending geometry and texture rows up to i_Budget bytes
+// Geometry goes first so meshes show up early, textures follow from their smallest levels
+void RenderClass::StreamScene(const size_t i_Budget) {
+    if (!SceneAdopted) {
+        if (!SceneLoaded.load(std::memory_order_acquire) || SceneFailed) {
+            return;
+        }
+        if (SceneLoader.joinable()) {
+            SceneLoader.join();
+        }
+        // Nothing to adopt, frames keep drawing the plane alone
+        if (!SceneLoadError.empty()) {
+            UtilsInstance->ErrorMessage("Model Loading Error", SceneLoadError.c_str());
+            SceneFailed = true;
+            return;
+        }
+        LoadTimer.Report(SceneCooked ? "Scene (cooked)" : "Scene (glTF)");
+
+        // Arenas are sized to the whole scene before anything is placed
+        size_t index_bytes = PendingIndexBytes;
+        for (auto it = PendingFormatBytes.begin(); it != PendingFormatBytes.end(); ++it) {
+            Geometry.Reserve(it->first, it->second, index_bytes);
+            index_bytes = 0;
+        }
+        for (size_t i = 0; i < PendingTextures.size(); ++i) {
+            createTexture(PendingTextures[i]);
+        }
+        SceneAdopted = true;
+        StreamTimer = PhaseTimer();
+        StreamFrames = 0;
+    }
+    if (IsSceneResident()) {
+        return;
+    }
+    PROFILE_FUNCTION();
+
+    // Staging segment still read by the GPU holds streaming back, unlimited uploads go directly instead
+    if (!Staging.BeginFrame() && Staging.IsCreated() && i_Budget != (size_t)-1) {
+        return;
+    }
+
+    // Every step uploads something, so a budget below one item still makes progress
+    size_t uploaded = 0;
+    const size_t first_geometry = NextGeometry;
+    while (NextGeometry < PendingGeometries.size() && (uploaded == 0 || PendingGeometries[NextGeometry].Bytes <= i_Budget - uploaded)) {
+        uploaded += PendingGeometries[NextGeometry].Bytes;
+        uploadGeometry(PendingGeometries[NextGeometry++]);
+    }
+    if (NextGeometry != first_geometry) {
+        BuildDrawPackets();
+    }
+    while (uploaded < i_Budget) {
+        PendingTexture* next = nullptr;
+        size_t next_pixels = 0;
+        for (size_t i = 0; i < PendingTextures.size(); ++i) {
+            const PendingTexture& texture = PendingTextures[i];
+            if (texture.Level < 0) {
+                continue;
+            }
+            const size_t pixels = (size_t)MipChain::Dimension(texture.Width, texture.Level) * MipChain::Dimension(texture.Height, texture.Level);
+            if (!next || pixels < next_pixels) {
+                next = &PendingTextures[i];
+                next_pixels = pixels;
+            }
+        }
+        if (!next) {
+            break;
+        }
+        uploaded += streamTexture(*next, i_Budget - uploaded);
+    }
+
+    Staging.EndFrame();
+    StreamFrames++;
+
+    if (IsSceneResident()) {
+        PendingGeometries.clear();
+        PendingTextures.clear();
+        CookedScene.Release();
+        NextGeometry = 0;
+        StreamTimer.Mark("Upload");
+        StreamTimer.Report("Scene streaming");
+        std::cout << "  Frames: " << StreamFrames << std::endl;
+    }
+}
+
+void RenderClass::FinishSceneLoading() {
+    if (SceneLoader.joinable()) {
+        SceneLoader.join();
+    }
+    StreamScene((size_t)-1);
+}
+
+bool RenderClass::IsSceneResident() const {
+    // Failed load has nothing left to upload
+    if (SceneFailed) {
+        return true;
+    }
+    if (!SceneAdopted || NextGeometry < PendingGeometries.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < PendingTextures.size(); ++i) {
+        if (PendingTextures[i].Level >= 0) {
+            return false;
+        }
+    }
+    return true;
 }
 
 // Create render targets for each part of G-Buffer
@@ -451,202 +972,816 @@ GLuint RenderClass::CreateRenderTarget(const std::vector<std::pair<GLenum, GLuin
 
 #define BUFFER_OFFSET(i) ((char *)NULL + (i))
 
-bool RenderClass::loadModel(tinygltf::Model& model, const char* filename) {
+// tinyGLTF file reading callback, tinyGLTF owns the contents so this is a plain whole file read (one copy out of the mapping)
+static bool ReadMappedFile(std::vector<unsigned char>* o_Contents, std::string* o_Error, const std::string& i_Filename, void*) {
+    MappedFile file;
+    if (!file.Open(i_Filename.c_str())) {
+        if (o_Error) {
+            *o_Error += "File open error: " + i_Filename + "\n";
+        }
+        return false;
+    }
+    o_Contents->assign(file.GetData(), file.GetData() + file.GetSize());
+    return true;
+}
+
+bool RenderClass::loadModel(tinygltf::Model& model, const char* filename, DeferredImages* o_Images, std::string& o_Error) {
+    PROFILE_FUNCTION();
+
     tinygltf::TinyGLTF loader;
     std::string err;
     std::string warn;
 
-    bool res = loader.LoadASCIIFromFile(&model, &err, &warn, filename);
+    // Images are only collected during parsing, decoding them is left to the caller
+    if (o_Images) {
+        loader.SetImageLoader(&DeferImageDecode, o_Images);
+    }
+
+    // External buffers and images are read whole, each one copied once into the vector tinyGLTF keeps
+    tinygltf::FsCallbacks callbacks = {};
+    callbacks.FileExists = &tinygltf::FileExists;
+    callbacks.ExpandFilePath = &tinygltf::ExpandFilePath;
+    callbacks.ReadWholeFile = &ReadMappedFile;
+    callbacks.WriteWholeFile = &tinygltf::WriteWholeFile;
+    loader.SetFsCallbacks(callbacks);
+
+    bool res = false;
+    const size_t length = strlen(filename);
+    if (length > 4 && strcmp(filename + length - 4, ".glb") == 0) {
+        // Whole binary container is mapped and parsed in place, only the BIN chunk is copied into the model buffer
+        MappedFile file;
+        if (!file.Open(filename)) {
+            o_Error = std::string("Could not open ") + filename;
+            return false;
+        }
+        const std::string filepath(filename);
+        const std::string base_dir = filepath.find_last_of("/\\") != std::string::npos ? filepath.substr(0, filepath.find_last_of("/\\")) : "";
+        res = loader.LoadBinaryFromMemory(&model, &err, &warn, file.GetData(), (unsigned int)file.GetSize(), base_dir);
+    }
+    else {
+        res = loader.LoadASCIIFromFile(&model, &err, &warn, filename);
+    }
     if (!warn.empty()) {
 		UtilsInstance->ErrorMessage("Model Loading Warning", warn.c_str());
     }
 
-    if (!err.empty()) {
-        UtilsInstance->ErrorMessage("Model Loading Error", err.c_str(), true);
+    if (!res || !err.empty()) {
+        o_Error = err.empty() ? std::string("Could not load ") + filename : err;
+        return false;
     }
+    std::cout << "Loaded glTF: " << filename << std::endl;
 
-    if (!res)
-        UtilsInstance->ErrorMessage("Model Loading Failed", filename, true);
-    else
-        std::cout << "Loaded glTF: " << filename << std::endl;
+    // Quantized attributes (KHR_mesh_quantization) are read through normalized and integer accessors, other required extensions are not handled
+    for (size_t i = 0; i < model.extensionsRequired.size(); ++i) {
+        if (model.extensionsRequired[i] != "KHR_mesh_quantization") {
+            UtilsInstance->ErrorMessage("Model Loading Warning", ("Unsupported required extension " + model.extensionsRequired[i]).c_str());
+        }
+    }
 
     return res;
 }
 
-void RenderClass::bindMesh(std::map<int, GLuint>& vbos, tinygltf::Model& model, tinygltf::Mesh& mesh) {
-    for (size_t i = 0; i < model.bufferViews.size(); ++i) {
-        const tinygltf::BufferView& bufferView = model.bufferViews[i];
-        if (bufferView.target == 0) { 
-            UtilsInstance->ErrorMessage("WARN: bufferView.target is zero", "");
-            continue;  // Unsupported bufferView.
+// Describe a model image for streaming and load or generate its mip chain, false if the image could not be loaded
+bool RenderClass::prepareTexture(tinygltf::Model& model, const int i_Image, const MipContent i_Content, PendingTexture& o_Texture) {
+    PROFILE_FUNCTION();
+
+    // Cooked images are read from the mapped package, decoded ones from the model
+    const tinygltf::Image& image = model.images[i_Image];
+    const bool cooked = image.image.empty() && CookedScene.IsLoaded();
+    const unsigned char* pixels = cooked ? CookedScene.ImageData(i_Image) : image.image.data();
+    const size_t size = cooked ? CookedScene.ImageSize(i_Image) : image.image.size();
+
+    const GLenum numToFormat[] = { GL_RGBA, GL_RED, GL_RG, GL_RGB, GL_RGBA };
+    const int components = image.component >= 1 && image.component <= 4 ? image.component : 4;
+    const size_t pixel_bytes = components * (image.bits == 16 ? 2 : 1);
+    if (image.bits == -1 || !pixels || size == 0 || size < (size_t)image.width * image.height * pixel_bytes) {
+        UtilsInstance->ErrorMessage("Texture Loading Error", "Could not load texture");
+        return false;
+    }
+
+    o_Texture.Image = i_Image;
+    o_Texture.Width = image.width;
+    o_Texture.Height = image.height;
+    o_Texture.Format = numToFormat[components];
+    o_Texture.Type = image.bits == 16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE;
+    o_Texture.PixelBytes = pixel_bytes;
+    o_Texture.BasePixels = pixels;
+
+    // Lower levels come from the mip cache next to the scene, generated and stored on a miss
+    if (image.component == 4 && image.bits == 8) {
+        o_Texture.Mips.reset(new MipChain());
+        MipChain& mips = *o_Texture.Mips;
+        const size_t extension = SceneSource.find_last_of('.');
+        const std::string cache_file = SceneSource.substr(0, extension) + ".image" + std::to_string(i_Image) + ".mips";
+        const uint64_t key = MipChain::Key(pixels, image.width, image.height, TextureMipFilter, i_Content);
+        if (!mips.Load(cache_file.c_str(), key, image.width, image.height)) {
+            mips.Generate(pixels, image.width, image.height, TextureMipFilter, i_Content);
+            if (mips.Levels() > 1 && !mips.Save(cache_file.c_str(), key)) {
+                UtilsInstance->ErrorMessage("Texture Cache Warning", "Could not write mip cache");
+            }
         }
+        o_Texture.Levels = mips.Levels() > 1 ? mips.Levels() : 1;
+    }
+    return true;
+}
+
+// Allocate every level of a pending texture, nothing is sampled until its smallest level is uploaded
+void RenderClass::createTexture(PendingTexture& io_Texture) {
+    glGenTextures(1, &io_Texture.Texture);
+    glBindTexture(GL_TEXTURE_2D, io_Texture.Texture);
 
-        const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
-        std::cout << "bufferview.target " << bufferView.target << std::endl;
+    for (int level = 0; level < io_Texture.Levels; ++level) {
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, MipChain::Dimension(io_Texture.Width, level), MipChain::Dimension(io_Texture.Height, level), 0,
+            level ? GL_RGBA : io_Texture.Format, level ? GL_UNSIGNED_BYTE : io_Texture.Type, nullptr);
+    }
 
-        GLuint vbo;
-        glGenBuffers(1, &vbo);
-        vbos[i] = vbo;
-        glBindBuffer(bufferView.target, vbo);
+    // Sampling is limited to resident levels, base level goes down as finer ones arrive
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, io_Texture.Levels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, io_Texture.Levels - 1);
+    if (!Textures->MaterialSampler) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);                                                          // Set linear filtering for magnification
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, io_Texture.Levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);  // Trilinear filtering for minification
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);                                                              // Repeat X texture coordinates around object
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);                                                              // Repeat Y texture coordinates around object
+    }
 
-        std::cout << "buffer.data.size = " << buffer.data.size() << ", bufferview.byteOffset = " << bufferView.byteOffset << std::endl;
+    glBindTexture(GL_TEXTURE_2D, 0);
+    io_Texture.Level = io_Texture.Levels - 1;
+    io_Texture.Row = 0;
+}
 
-        glBufferData(bufferView.target, bufferView.byteLength, &buffer.data.at(0) + bufferView.byteOffset, GL_STATIC_DRAW);
+// Upload next rows of the level being streamed, at least one row, returns bytes uploaded
+size_t RenderClass::streamTexture(PendingTexture& io_Texture, const size_t i_Budget) {
+    const int level = io_Texture.Level;
+    const int width = MipChain::Dimension(io_Texture.Width, level);
+    const int height = MipChain::Dimension(io_Texture.Height, level);
+    const size_t row_bytes = width * (level ? 4 : io_Texture.PixelBytes);
+    const size_t budget_rows = i_Budget / row_bytes;
+    const int rows = budget_rows < 1 ? 1 : (budget_rows < (size_t)(height - io_Texture.Row) ? (int)budget_rows : height - io_Texture.Row);
+    const size_t bytes = rows * row_bytes;
+    const unsigned char* source = (level ? io_Texture.Mips->LevelData(level) : io_Texture.BasePixels) + io_Texture.Row * row_bytes;
+    const GLenum format = level ? GL_RGBA : io_Texture.Format;
+    const GLenum type = level ? GL_UNSIGNED_BYTE : io_Texture.Type;
+
+    glBindTexture(GL_TEXTURE_2D, io_Texture.Texture);
+    // Decoded rows are tightly packed
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    size_t staging_offset;
+    unsigned char* staging = Staging.Allocate(bytes, sizeof(uint32_t), staging_offset);
+    if (staging) {
+        memcpy(staging, source, bytes);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, Staging.Buffer());
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, io_Texture.Row, width, rows, format, type, BUFFER_OFFSET(staging_offset));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    else {
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, io_Texture.Row, width, rows, format, type, source);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    io_Texture.Row += rows;
+    if (io_Texture.Row == height) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+        if (!io_Texture.Sampled) {
+            Materials.SetImageTexture(io_Texture.Image, io_Texture.Texture);
+            io_Texture.Sampled = true;
+        }
+        io_Texture.Level--;
+        io_Texture.Row = 0;
+        if (io_Texture.Level < 0) {
+            std::vector<unsigned char>().swap(io_Texture.Pixels);
+            io_Texture.BasePixels = nullptr;
+            io_Texture.Mips.reset();
+        }
     }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return bytes;
+}
 
-    for (size_t i = 0; i < mesh.primitives.size(); ++i) {
-        tinygltf::Primitive primitive = mesh.primitives[i];
-        tinygltf::Accessor indexAccessor = model.accessors[primitive.indices];
+// Read geometry of every scene primitive into pending uploads with levels of detail and meshlets, then release CPU copies of the buffers
+// Primitives referring to the same accessors share one geometry
+void RenderClass::prepareGeometry(tinygltf::Model& model) {
+    PROFILE_FUNCTION();
+
+    // Cooked scenes keep buffer data in the mapped package
+    BufferSpans buffers(model.buffers.size());
+    for (size_t i = 0; i < model.buffers.size(); ++i) {
+        buffers[i] = std::make_pair(model.buffers[i].data.data(), model.buffers[i].data.size());
+        if (model.buffers[i].data.empty() && CookedScene.IsLoaded()) {
+            buffers[i] = std::make_pair(CookedScene.BufferData((int)i), CookedScene.BufferSize((int)i));
+        }
+    }
 
-        for (auto& attrib : primitive.attributes) {
-            tinygltf::Accessor accessor = model.accessors[attrib.second];
-            int byteStride = accessor.ByteStride(model.bufferViews[accessor.bufferView]);
-            glBindBuffer(GL_ARRAY_BUFFER, vbos[accessor.bufferView]);
+    // Accessors of every attribute in interleaved order, then indices and mode
+    typedef std::array<int, VertexAttributeCount + 2> GeometryKey;
+    const char* attribute_names[VertexAttributeCount] = { "POSITION", "TEXCOORD_0", "NORMAL" };
+    std::vector<GeometryKey> keys(Primitives.size());
+    std::map<GeometryKey, int> unique;
+    for (size_t i = 0; i < Primitives.size(); ++i) {
+        const tinygltf::Primitive& primitive = model.meshes[Primitives[i].Mesh].primitives[Primitives[i].Primitive];
+        for (int attribute = 0; attribute < VertexAttributeCount; ++attribute) {
+            auto found = primitive.attributes.find(attribute_names[attribute]);
+            keys[i][attribute] = found != primitive.attributes.end() ? found->second : -1;
+        }
+        keys[i][VertexAttributeCount] = primitive.indices;
+        keys[i][VertexAttributeCount + 1] = primitive.mode;
+        unique.emplace(keys[i], -1);
+    }
 
-            int size = 1;
-            if (accessor.type != TINYGLTF_TYPE_SCALAR) {
-                size = accessor.type;
-            }
+    // Vertices are read and processed as floats, quantized formats encode them on upload
+    const uint32_t vertex_format = QuantizedVertexFormat ? (uint32_t)VertexAttributeQuantized : 0u;
+
+    // Arenas are sized to the whole scene when the render thread takes over
+    PendingFormatBytes.clear();
+    PendingIndexBytes = 0;
+    std::map<GeometryKey, bool> readable;
+    for (auto it = unique.begin(); it != unique.end(); ++it) {
+        const GeometryKey& key = it->first;
+        // Accessor indices and ranges come from the file, geometry referencing anything outside the model is not uploaded
+        bool& key_readable = readable[key];
+        key_readable = key[0] >= 0;
+        for (int entry = 0; entry <= VertexAttributeCount; ++entry) {
+            key_readable = key_readable && (key[entry] < 0 || IsAccessorReadable(model, buffers, key[entry]));
+        }
+        if (!key_readable) {
+            continue;
+        }
+        uint32_t attributes = 0;
+        for (int attribute = 0; attribute < VertexAttributeCount; ++attribute) {
+            attributes |= key[attribute] >= 0 ? 1u << attribute : 0u;
+        }
+        const size_t vertex_count = model.accessors[key[0]].count;
+        PendingFormatBytes[attributes | vertex_format] += vertex_count * GeometryBuffers::Stride(attributes | vertex_format);
+        const bool wide = key[VertexAttributeCount] >= 0 ? model.accessors[key[VertexAttributeCount]].componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT : vertex_count > 65536;
+        const size_t index_count = key[VertexAttributeCount] >= 0 ? model.accessors[key[VertexAttributeCount]].count : vertex_count;
+        // 32 bit indices after 16 bit ones may need 2 bytes of alignment, levels of detail together take at most as much as full detail
+        const size_t levels = MaxLodLevels > 1 ? 2 : 1;
+        PendingIndexBytes += levels * (index_count * (wide ? sizeof(uint32_t) : sizeof(uint16_t)) + sizeof(uint16_t));
+    }
 
-            int vaa = -1;
-            if (attrib.first.compare("POSITION") == 0) vaa = 0;
-            if (attrib.first.compare("NORMAL") == 0) vaa = 2;
-            if (attrib.first.compare("TEXCOORD_0") == 0) vaa = 1;
-            if (vaa > -1) {
-                glEnableVertexAttribArray(vaa);
-                glVertexAttribPointer(vaa, size, accessor.componentType, accessor.normalized ? GL_TRUE : GL_FALSE, byteStride, BUFFER_OFFSET(accessor.byteOffset));
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices, lod_indices;
+    for (auto it = unique.begin(); it != unique.end(); ++it) {
+        const GeometryKey& key = it->first;
+        if (key[0] < 0) {
+            continue;
+        }
+        if (!readable[key]) {
+            UtilsInstance->ErrorMessage("Model Loading Error", "Primitive accessor is out of buffer range or has unsupported type");
+            continue;
+        }
+        if (model.accessors[key[0]].count == 0) {
+            continue;
+        }
+        const size_t vertex_count = model.accessors[key[0]].count;
+
+        // Attributes with a different element count than positions are dropped
+        uint32_t attributes = 0;
+        for (int attribute = 0; attribute < VertexAttributeCount; ++attribute) {
+            if (key[attribute] >= 0 && model.accessors[key[attribute]].count == vertex_count) {
+                attributes |= 1u << attribute;
             }
-            //else
-            //    UtilsInstance->ErrorMessage("vaa missing: ", attrib.first.c_str());
         }
 
-        if (model.textures.size() > 0) {
-            // fixme: Use material's baseColor
-            tinygltf::Texture& tex = model.textures[0];
+        const size_t stride = GeometryBuffers::Stride(attributes) / sizeof(float);
+        const int components[VertexAttributeCount] = { 3, 2, 3 };
+        vertices.assign(vertex_count * stride, 0.0f);
+        size_t offset = 0;
+        bool valid = true;
+        for (int attribute = 0; attribute < VertexAttributeCount; ++attribute) {
+            if (attributes & (1u << attribute)) {
+                valid = valid && ReadAccessorFloats(model, buffers, key[attribute], components[attribute], vertices.data() + offset, stride);
+                offset += components[attribute];
+            }
+        }
 
-            GLuint* TexturesTemp[] = {&Textures->DiffuseTexture, &Textures->DiffusePBRTexture, &Textures->DiffuseNormalTexture};
-            
-			int iterations = min(sizeof(TexturesTemp) / sizeof(TexturesTemp[0]), model.textures.size());
+        // Index width of the source is kept, 8 bit indices are widened, non-indexed primitives draw their vertices in order
+        GLenum index_type = vertex_count <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        if (key[VertexAttributeCount] >= 0) {
+            index_type = model.accessors[key[VertexAttributeCount]].componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+            indices.resize(model.accessors[key[VertexAttributeCount]].count);
+            valid = valid && ReadAccessorIndices(model, buffers, key[VertexAttributeCount], indices.data());
+        }
+        else {
+            indices.resize(vertex_count);
+            for (size_t i = 0; i < vertex_count; ++i) {
+                indices[i] = (uint32_t)i;
+            }
+        }
 
-			for (int i = 0; i < iterations; i++) {
-        
-                glGenTextures(1, TexturesTemp[i]);
-                
-                tinygltf::Image& image = model.images[i];
+        if (!valid) {
+            UtilsInstance->ErrorMessage("Model Loading Error", "Primitive accessor is out of buffer range or has unsupported type");
+            continue;
+        }
+        PendingGeometry geometry;
+        geometry.Attributes = attributes | vertex_format;
+        geometry.VertexCount = vertex_count;
+        geometry.Mode = key[VertexAttributeCount + 1] >= 0 ? (GLenum)key[VertexAttributeCount + 1] : GL_TRIANGLES;
+        geometry.IndexType = index_type;
+
+        // Dense triangle geometry is culled per cluster, clusters follow the optimized triangle order
+        if (MeshletCulling && geometry.Mode == GL_TRIANGLES && indices.size() / 3 >= MeshletMinPrimitiveTriangles) {
+            BuildMeshlets(geometry.Meshlets, indices.data(), indices.size(), vertices.data(), stride, vertex_count);
+        }
 
-                if (image.bits == -1) {
-					UtilsInstance->ErrorMessage("Texture Loading Error", "Could not load texture");
-                }
-        
-                CreateRectTexture(image.width, image.height, GL_RGBA, GL_RGBA16F, GL_HALF_FLOAT);
-        
-                glBindTexture(GL_TEXTURE_2D, *TexturesTemp[i]);
-                // Set texture parameters
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);     // Set linear filtering for magnification
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);     // Set linear filtering for minification
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);         // Repeat X texture coordinates around object
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);         // Repeat Y texture coordinates around object
-        
-				const GLenum numToFormat[] = { GL_RGBA, GL_RED, GL_RG, GL_RGB, GL_RGBA };
-                GLenum format = numToFormat[image.component];
-                
-                GLenum type = GL_UNSIGNED_BYTE;
-                if (image.bits == 16) type = GL_UNSIGNED_SHORT;    
-        
-                // Fill texture with data loaded from file
-                glTexImage2D(GL_TEXTURE_2D,        // 2D texture
-                    0,                    // 0 MIP level
-                    GL_RGBA,             // 8 bits per channel
-                    image.width,       // Texture width
-                    image.height,      // Texture height
-                    0,                    // No border
-                    format,                  // 4-component texture
-                    type,                   // Data type for each component
-                    &image.image.at(0));      // Pointer to texture data that should be loaded onto graphics card memory
-               
-                glBindTexture(GL_TEXTURE_2D, 0);
+        // Simplified levels index the same vertices, each one is simplified from the previous one and adds up its error
+        geometry.Indices[0].swap(indices);
+        geometry.LevelCount = 1;
+        for (int level = 1; geometry.Mode == GL_TRIANGLES && level < MaxLodLevels; ++level) {
+            const std::vector<uint32_t>& previous = geometry.Indices[level - 1];
+            lod_indices.resize(previous.size());
+            float error;
+            const size_t lod_count = SimplifyMesh(lod_indices.data(), previous.data(), previous.size(), vertices.data(), stride,
+                vertex_count, (size_t)(previous.size() * LodReductionRatio) / 3 * 3, LodMaxError - geometry.Error[level - 1], &error);
+            if (lod_count == 0 || lod_count > previous.size() * LodMinReduction) {
+                break;
             }
+            geometry.Indices[level].resize(lod_count);
+            OptimizeVertexCache(geometry.Indices[level].data(), lod_indices.data(), lod_count, vertex_count);
+            geometry.Error[level] = geometry.Error[level - 1] + error;
+            geometry.LevelCount++;
+        }
+
+        const size_t index_size = index_type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        geometry.Bytes = vertex_count * GeometryBuffers::Stride(geometry.Attributes);
+        for (int level = 0; level < geometry.LevelCount; ++level) {
+            geometry.Bytes += geometry.Indices[level].size() * index_size;
         }
+        geometry.Vertices.swap(vertices);
+
+        it->second = (int)PendingGeometries.size();
+        PendingGeometries.push_back(std::move(geometry));
+    }
+
+    for (size_t i = 0; i < Primitives.size(); ++i) {
+        if (unique[keys[i]] >= 0) {
+            PendingGeometries[unique[keys[i]]].Primitives.push_back((int)i);
+        }
+    }
+
+    // Geometry is kept in pending uploads now, accessor bounds used for culling are kept in the model
+    for (size_t i = 0; i < model.buffers.size(); ++i) {
+        std::vector<unsigned char>().swap(model.buffers[i].data);
     }
 }
 
-// bind models
-void RenderClass::bindModelNodes(std::map<int, GLuint>&vbos, tinygltf::Model & model, tinygltf::Node & node) {
-    if ((node.mesh >= 0) && (node.mesh < model.meshes.size())) {
-        bindMesh(vbos, model, model.meshes[node.mesh]);
+// Place pending geometry with its levels and clusters in the arenas and let its primitives draw it
+void RenderClass::uploadGeometry(PendingGeometry& io_Geometry) {
+    LodChain lods;
+    lods.Geometry[0] = Geometry.Add(io_Geometry.Attributes, io_Geometry.Vertices.data(), io_Geometry.VertexCount, io_Geometry.Indices[0].data(), io_Geometry.Indices[0].size(),
+        io_Geometry.Mode, io_Geometry.IndexType);
+    lods.Error[0] = 0.0f;
+    lods.Count = lods.Geometry[0] >= 0 ? 1 : 0;
+    for (int level = 1; lods.Count == level && level < io_Geometry.LevelCount; ++level) {
+        lods.Geometry[level] = Geometry.AddIndices(lods.Geometry[0], io_Geometry.Indices[level].data(), io_Geometry.Indices[level].size());
+        lods.Error[level] = io_Geometry.Error[level];
+        lods.Count += lods.Geometry[level] >= 0;
     }
 
-    for (size_t i = 0; i < node.children.size(); i++) {
-        assert((node.children[i] >= 0) && (node.children[i] < model.nodes.size()));
-        bindModelNodes(vbos, model, model.nodes[node.children[i]]);
+    if (lods.Count) {
+        lods.FirstMeshlet = (int)Meshlets.size();
+        lods.MeshletCount = (int)io_Geometry.Meshlets.size();
+        Meshlets.insert(Meshlets.end(), io_Geometry.Meshlets.begin(), io_Geometry.Meshlets.end());
+
+        const int chain = (int)GeometryLods.size();
+        GeometryLods.push_back(lods);
+        for (size_t i = 0; i < io_Geometry.Primitives.size(); ++i) {
+            ScenePrimitive& primitive = Primitives[io_Geometry.Primitives[i]];
+            primitive.Lods = chain;
+            primitive.Geometry = lods.Geometry[0];
+            primitive.Lod = 0;
+        }
     }
+
+    // Vertices and indices live on GPU now
+    io_Geometry = PendingGeometry();
 }
 
-std::pair<GLuint, std::map<int, GLuint>> RenderClass::bindModel(tinygltf::Model& model) {
-    std::map<int, GLuint> vbos;
-    GLuint vao;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
+// Draw one level of a packet, its vertex array is already bound
+void RenderClass::drawPacket(const DrawPacket& i_Packet, const DrawLevel& i_Level) {
+    if (glDrawElementsBaseVertex) {
+        glDrawElementsBaseVertex(i_Packet.Mode, i_Level.IndexCount, i_Packet.IndexType, BUFFER_OFFSET(i_Level.IndexOffset), i_Packet.BaseVertex);
+    }
+    else {
+        glDrawElements(i_Packet.Mode, i_Level.IndexCount, i_Packet.IndexType, BUFFER_OFFSET(i_Level.IndexOffset));
+    }
 
-    const tinygltf::Scene& scene = model.scenes[model.defaultScene];
-    for (size_t i = 0; i < scene.nodes.size(); ++i) {
-        assert((scene.nodes[i] >= 0) && (scene.nodes[i] < model.nodes.size()));
-        bindModelNodes(vbos, model, model.nodes[scene.nodes[i]]);
+    FrameDraws.DrawCalls++;
+    if (i_Packet.Mode == GL_TRIANGLES) {
+        FrameDraws.Triangles += i_Level.IndexCount / 3;
+    }
+    else if ((i_Packet.Mode == GL_TRIANGLE_STRIP || i_Packet.Mode == GL_TRIANGLE_FAN) && i_Level.IndexCount > 2) {
+        FrameDraws.Triangles += i_Level.IndexCount - 2;
     }
+}
 
-    glBindVertexArray(0);
-    // cleanup vbos but do not delete index buffers yet
-    for (auto it = vbos.cbegin(); it != vbos.cend();) {
-        tinygltf::BufferView bufferView = model.bufferViews[it->first];
-        if (bufferView.target != GL_ELEMENT_ARRAY_BUFFER) {
-            glDeleteBuffers(1, &vbos[it->first]);
-            vbos.erase(it++);
+// Index runs of visible clusters of the full detail level into ClusterFirstIndices and ClusterCounts,
+// neighbouring visible clusters form one run
+void RenderClass::collectClusterRuns(const DrawPacket& i_Packet, const Frustum& i_Frustum, const float* i_Camera, const bool i_TestCone) {
+    const size_t index_size = i_Packet.IndexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    const GLuint first_index = (GLuint)(i_Packet.Levels[0].IndexOffset / index_size);
+
+    ClusterFirstIndices.clear();
+    ClusterCounts.clear();
+    bool previous_visible = false;
+    for (int i = 0; i < i_Packet.MeshletCount; ++i) {
+        const Meshlet& meshlet = Meshlets[i_Packet.FirstMeshlet + i];
+        const bool visible = MeshletVisible(meshlet, i_Frustum, i_Camera, i_TestCone);
+        if (visible && previous_visible) {
+            ClusterCounts.back() += (GLsizei)meshlet.IndexCount;
         }
-        else {
-            ++it;
+        else if (visible) {
+            ClusterFirstIndices.push_back(first_index + meshlet.FirstIndex);
+            ClusterCounts.push_back((GLsizei)meshlet.IndexCount);
+        }
+        FrameDraws.ClustersCulled += !visible;
+        previous_visible = visible;
+    }
+    FrameDraws.ClustersTested += i_Packet.MeshletCount;
+}
+
+// Draw visible clusters of the full detail level
+// All runs go out as one multi draw when base vertex draws are available
+void RenderClass::drawClusters(const DrawPacket& i_Packet, const Frustum& i_Frustum, const float* i_Camera, const bool i_TestCone) {
+    const DrawLevel& level = i_Packet.Levels[0];
+    const size_t index_size = i_Packet.IndexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+    collectClusterRuns(i_Packet, i_Frustum, i_Camera, i_TestCone);
+
+    if (ClusterCounts.size() > 1 && glMultiDrawElementsBaseVertex) {
+        ClusterOffsets.resize(ClusterCounts.size());
+        ClusterBaseVertices.assign(ClusterCounts.size(), i_Packet.BaseVertex);
+        GLsizei index_count = 0;
+        for (size_t i = 0; i < ClusterCounts.size(); ++i) {
+            ClusterOffsets[i] = BUFFER_OFFSET(ClusterFirstIndices[i] * index_size);
+            index_count += ClusterCounts[i];
         }
+        glMultiDrawElementsBaseVertex(i_Packet.Mode, ClusterCounts.data(), i_Packet.IndexType, ClusterOffsets.data(), (GLsizei)ClusterCounts.size(), ClusterBaseVertices.data());
+        FrameDraws.DrawCalls++;
+        FrameDraws.Triangles += index_count / 3;
+        return;
     }
 
-    return { vao, vbos };
+    DrawLevel run = level;
+    for (size_t i = 0; i < ClusterCounts.size(); ++i) {
+        run.IndexOffset = ClusterFirstIndices[i] * index_size;
+        run.IndexCount = ClusterCounts[i];
+        drawPacket(i_Packet, run);
+    }
 }
 
-// Draw mesh (per each primitive)
-void RenderClass::drawMesh(const std::map<int, GLuint>& vbos, tinygltf::Model& model, tinygltf::Mesh& mesh) {
-    for (size_t i = 0; i < mesh.primitives.size(); ++i) {
-        tinygltf::Primitive primitive = mesh.primitives[i];
-        tinygltf::Accessor indexAccessor = model.accessors[primitive.indices];
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbos.at(indexAccessor.bufferView));
-        glDrawElements(primitive.mode, indexAccessor.count, indexAccessor.componentType, BUFFER_OFFSET(indexAccessor.byteOffset));
+// Frustum and camera in node local space for cluster culling
+void RenderClass::clusterCullingSpace(const int i_Node, Frustum& o_Frustum, float* o_Camera, bool& o_Mirrored) const {
+    const Affine node_model_view = Multiply(ModelTransform, Nodes.World[i_Node]);
+    ExtractFrustumPlanes(Multiply(ProjectionMatrix, node_model_view), o_Frustum);
+    // Camera sits at view space origin, its local position is the translation of the inverse
+    const Affine view_to_local = Inverse<TransformKind::General>(node_model_view);
+    o_Camera[0] = view_to_local.m[3];
+    o_Camera[1] = view_to_local.m[7];
+    o_Camera[2] = view_to_local.m[11];
+    // Mirroring flips winding, rasterizer culls the other side then, so cones are not used
+    const float* m = node_model_view.m;
+    o_Mirrored = m[0] * (m[5] * m[10] - m[6] * m[9]) - m[1] * (m[4] * m[10] - m[6] * m[8]) + m[2] * (m[4] * m[9] - m[5] * m[8]) < 0.0f;
+}
+
+// Collect primitives of all mesh nodes, local bounds come from POSITION accessor min/max
+void RenderClass::BuildPrimitiveList() {
+    Primitives.clear();
+
+    for (size_t node = 0; node < Nodes.Size(); ++node) {
+        if (Nodes.Mesh[node] < 0) {
+            continue;
+        }
+
+        const tinygltf::Mesh& mesh = model.meshes[Nodes.Mesh[node]];
+        for (size_t i = 0; i < mesh.primitives.size(); ++i) {
+            ScenePrimitive primitive;
+            primitive.Node = (int)node;
+            primitive.Mesh = Nodes.Mesh[node];
+            primitive.Primitive = (int)i;
+            primitive.Material = Materials.MaterialIndex(mesh.primitives[i].material);
+
+            // Primitives without bounds are never culled
+            for (int axis = 0; axis < 3; ++axis) {
+                primitive.LocalBounds.Min[axis] = -1e30f;
+                primitive.LocalBounds.Max[axis] = 1e30f;
+            }
+
+            auto position = mesh.primitives[i].attributes.find("POSITION");
+            if (position != mesh.primitives[i].attributes.end() && position->second >= 0 && position->second < (int)model.accessors.size()) {
+                const tinygltf::Accessor& accessor = model.accessors[position->second];
+                if (accessor.minValues.size() >= 3 && accessor.maxValues.size() >= 3) {
+                    for (int axis = 0; axis < 3; ++axis) {
+                        primitive.LocalBounds.Min[axis] = (float)accessor.minValues[axis];
+                        primitive.LocalBounds.Max[axis] = (float)accessor.maxValues[axis];
+                    }
+                }
+            }
+
+            Primitives.push_back(primitive);
+        }
     }
+
+    // Primitives are in node order, so every node subtree maps to a contiguous primitive range
+    NodeFirstPrimitive.assign(Nodes.Size() + 1, 0);
+    size_t primitive = 0;
+    for (size_t node = 0; node <= Nodes.Size(); ++node) {
+        while (primitive < Primitives.size() && Primitives[primitive].Node < (int)node) {
+            ++primitive;
+        }
+        NodeFirstPrimitive[node] = (int)primitive;
+    }
+
+    PrimitiveWorldBounds.resize(Primitives.size());
+    PrimitiveBounds.Resize(Primitives.size());
+    PrimitiveVisible.assign(Primitives.size(), 1);
 }
-// Recursively draw node and children nodes of model
-void RenderClass::drawModelNodes(const std::pair<GLuint, std::map<int, GLuint>>& vaoAndEbos, tinygltf::Model& model, tinygltf::Node& node) {
-    if ((node.mesh >= 0) && (node.mesh < model.meshes.size())) {
-        drawMesh(vaoAndEbos.second, model, model.meshes[node.mesh]);
+
+// Transform local bounds to scene space with node world matrices
+void RenderClass::UpdatePrimitiveBounds(const size_t i_First, const size_t i_End) {
+    for (size_t i = i_First; i < i_End; ++i) {
+        PrimitiveWorldBounds[i] = TransformAABB(Primitives[i].LocalBounds, Nodes.World[Primitives[i].Node]);
+        PrimitiveBounds.Set(i, PrimitiveWorldBounds[i]);
+    }
+}
+
+// Update bounds of primitives below nodes refreshed by the last UpdateWorld and refit the hierarchy
+void RenderClass::RefitPrimitiveBounds() {
+    ChangedPrimitives.clear();
+    const std::vector<int>& subtrees = Nodes.LastUpdatedSubtrees();
+    for (size_t i = 0; i < subtrees.size(); ++i) {
+        const int first = NodeFirstPrimitive[subtrees[i]];
+        const int end = NodeFirstPrimitive[Nodes.SubtreeEnd[subtrees[i]]];
+        UpdatePrimitiveBounds(first, end);
+        for (int primitive = first; primitive < end; ++primitive) {
+            ChangedPrimitives.push_back(primitive);
+        }
+    }
+
+    if (Primitives.size() < BVHCullingThreshold) {
+        return;
+    }
+
+    // Refitting a large part of the tree is cheaper as one full sweep
+    if (ChangedPrimitives.size() * 4 > Primitives.size()) {
+        PrimitiveHierarchy.Refit(PrimitiveWorldBounds.data());
+    }
+    else {
+        PrimitiveHierarchy.Refit(PrimitiveWorldBounds.data(), ChangedPrimitives.data(), ChangedPrimitives.size());
+    }
+}
+
+// Frustum test of primitive bounds, hierarchical for larger scenes
+void RenderClass::CullPrimitives() {
+    PROFILE_FUNCTION();
+
+    Culling = CullingStats();
+
+    // Planes of projection * model root transform are in scene space, same as the bounds
+    Frustum frustum;
+    ExtractFrustumPlanes(Multiply(ProjectionMatrix, ModelTransform), frustum);
+
+    if (Primitives.size() < BVHCullingThreshold) {
+        CullBoxes(frustum, PrimitiveBounds, PrimitiveVisible.data(), Culling);
+    }
+    else {
+        PrimitiveHierarchy.QueryFrustum(frustum, PrimitiveVisible.data(), Culling);
+    }
+}
+
+// Pick level of detail of visible primitives from projected size of their bounding spheres
+// Level error is relative to mesh extent, which the sphere diameter bounds, so error in pixels is error * diameter in pixels
+void RenderClass::SelectLods() {
+    PROFILE_FUNCTION();
+
+    // Scene space lengths scale by the largest axis scale of the model view transform
+    float scale = 0.0f;
+    for (int column = 0; column < 3; ++column) {
+        const float length = sqrtf(ModelTransform.m[column] * ModelTransform.m[column] + ModelTransform.m[4 + column] * ModelTransform.m[4 + column]
+            + ModelTransform.m[8 + column] * ModelTransform.m[8 + column]);
+        scale = length > scale ? length : scale;
+    }
+    // Pixels per view space unit at distance 1
+    const float pixels_per_unit = ProjectionMatrix.m[5] * 0.5f * *Height;
+
+    for (size_t i = 0; i < Primitives.size(); ++i) {
+        ScenePrimitive& primitive = Primitives[i];
+        if (!PrimitiveVisible[i] || primitive.Lods < 0 || GeometryLods[primitive.Lods].Count < 2) {
+            continue;
+        }
+        const LodChain& lods = GeometryLods[primitive.Lods];
+
+        const AABB& bounds = PrimitiveWorldBounds[i];
+        float center[3], radius = 0.0f;
+        for (int axis = 0; axis < 3; ++axis) {
+            center[axis] = (bounds.Min[axis] + bounds.Max[axis]) * 0.5f;
+            radius += (bounds.Max[axis] - center[axis]) * (bounds.Max[axis] - center[axis]);
+        }
+        radius = sqrtf(radius) * scale;
+        float view[3];
+        for (int row = 0; row < 3; ++row) {
+            view[row] = ModelTransform.m[row * 4] * center[0] + ModelTransform.m[row * 4 + 1] * center[1] + ModelTransform.m[row * 4 + 2] * center[2] + ModelTransform.m[row * 4 + 3];
+        }
+        const float distance = sqrtf(view[0] * view[0] + view[1] * view[1] + view[2] * view[2]);
+
+        // Camera inside the sphere (or unbounded primitive) always gets full detail
+        if (distance <= radius || radius >= 1e20f) {
+            primitive.Lod = 0;
+            continue;
+        }
+        const float diameter = 2.0f * radius * pixels_per_unit / (distance - radius);
+
+        // Refine as soon as the limit is crossed, coarsen only with margin so levels do not flicker at the boundary
+        int lod = primitive.Lod < lods.Count ? primitive.Lod : lods.Count - 1;
+        while (lod > 0 && lods.Error[lod] * diameter > LodPixelError) {
+            lod--;
+        }
+        while (lod + 1 < lods.Count && lods.Error[lod + 1] * diameter < LodPixelError * (1.0f - LodHysteresis)) {
+            lod++;
+        }
+        primitive.Lod = lod;
     }
-    for (size_t i = 0; i < node.children.size(); i++) {
-        drawModelNodes(vaoAndEbos, model, model.nodes[node.children[i]]);
+}
+
+// Compile primitives with resident geometry into draw packets, primitive order keeps draws of a node together
+void RenderClass::BuildDrawPackets() {
+    DrawPackets.clear();
+    Indirect.ClearBuckets();
+    int most_meshlets = 0;
+    size_t indirect_commands = 0;
+    for (size_t i = 0; i < Primitives.size(); ++i) {
+        const ScenePrimitive& primitive = Primitives[i];
+        if (primitive.Geometry < 0 || primitive.Lods < 0) {
+            continue;
+        }
+
+        const LodChain& lods = GeometryLods[primitive.Lods];
+        const GeometryRange& vertices = Geometry.Range(lods.Geometry[0]);
+        const size_t index_size = vertices.IndexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        DrawPacket packet = {};
+        for (int level = 0; level < lods.Count; ++level) {
+            const GeometryRange& range = Geometry.Range(lods.Geometry[level]);
+            packet.Levels[level].VertexArray = Geometry.VertexArray(range.VertexArray);
+            packet.Levels[level].IndexCount = range.IndexCount;
+            packet.Levels[level].IndexOffset = range.FirstIndex * index_size;
+            packet.Levels[level].Bucket = Indirect.IsCreated() ? Indirect.Bucket(packet.Levels[level].VertexArray, vertices.Mode, vertices.IndexType, primitive.Material) : -1;
+        }
+        packet.Mode = vertices.Mode;
+        packet.IndexType = vertices.IndexType;
+        packet.BaseVertex = vertices.BaseVertex;
+        packet.Material = primitive.Material;
+        packet.Transform = primitive.Node;
+        packet.Primitive = (int)i;
+        packet.Vertices = lods.Geometry[0];
+        memcpy(packet.PositionScale, vertices.PositionScale, sizeof(packet.PositionScale));
+        memcpy(packet.PositionOffset, vertices.PositionOffset, sizeof(packet.PositionOffset));
+        packet.FirstMeshlet = lods.FirstMeshlet;
+        packet.MeshletCount = lods.MeshletCount;
+        most_meshlets = lods.MeshletCount > most_meshlets ? lods.MeshletCount : most_meshlets;
+        indirect_commands += lods.MeshletCount > 1 ? lods.MeshletCount : 1;
+        DrawPackets.push_back(packet);
     }
+
+    // A draw never has more cluster runs than clusters, frames then never grow the scratch arrays
+    ClusterFirstIndices.reserve(most_meshlets);
+    ClusterCounts.reserve(most_meshlets);
+    ClusterOffsets.reserve(most_meshlets);
+    ClusterBaseVertices.reserve(most_meshlets);
+    ChangedPrimitives.reserve(Primitives.size());
+    // Every packet may need its own draw record, records over the buffer texture limit leave the model on direct draws
+    IndirectReady = Indirect.Reserve(DrawPackets.size(), indirect_commands, Geometry);
 }
 
 // Draw model per each node
-void RenderClass::drawModel(const std::pair<GLuint, std::map<int, GLuint>>& vaoAndEbos, tinygltf::Model& model) {
-    glBindVertexArray(vaoAndEbos.first);
+void RenderClass::drawModel() {
+    // Refresh world matrices of nodes changed since last frame
+    Nodes.UpdateWorld();
+    if (Nodes.LastUpdatedCount() > 0) {
+        RefitPrimitiveBounds();
+    }
+
+    CullPrimitives();
+    SelectLods();
+    if (IsDrawingIndirect()) {
+        drawModelIndirect();
+        return;
+    }
+
+    // Packets are grouped by node - matrices change only when node changes
+    // Material textures and vertex arrays are rebound only when they change
+    int current_node = -1;
+    int current_material = -1;
+    GLuint current_vertex_array = 0;
+    int current_vertices = -1;
+    // Frustum and camera in node local space for cluster culling, computed for nodes that have clusters
+    Frustum node_frustum;
+    float node_camera[3] = { 0.0f, 0.0f, 0.0f };
+    bool node_mirrored = false;
+    int cluster_node = -1;
+    for (size_t i = 0; i < DrawPackets.size(); ++i) {
+        const DrawPacket& packet = DrawPackets[i];
+        if (!PrimitiveVisible[packet.Primitive]) {
+            continue;
+        }
 
-    // Calculate MVP matrix for it
-    Multiply(ProjectionMatrix, ModelViewMatrix, ModelViewProjectionMatrix);
-    // Set values of shader uniform variables - MVP and MV matrices
-    glUniformMatrix4fv(Handlers->MVPMatrixHandle, 1, false, ModelViewProjectionMatrix);
-    glUniformMatrix4fv(Handlers->MVMatrixHandle, 1, false, ModelViewMatrix);
+        if (packet.Transform != current_node) {
+            current_node = packet.Transform;
+
+            // Node model view = model root transform * node world transform
+            Affine node_model_view = Multiply(ModelTransform, Nodes.World[current_node]);
+            ModelViewMatrix = ToMat4(node_model_view);
+            ModelViewProjectionMatrix = Multiply(ProjectionMatrix, node_model_view);
+            glUniformMatrix4fv(Handlers->MVPMatrixHandle, 1, false, ModelViewProjectionMatrix.m);
+            glUniformMatrix4fv(Handlers->MVMatrixHandle, 1, false, ModelViewMatrix.m);
+        }
+
+        if (packet.Material != current_material) {
+            current_material = packet.Material;
+            Materials.Bind(current_material);
+            FrameDraws.MaterialBinds++;
+        }
 
-    const tinygltf::Scene& scene = model.scenes[model.defaultScene];
-    for (size_t i = 0; i < scene.nodes.size(); ++i) {
-        drawModelNodes(vaoAndEbos, model, model.nodes[scene.nodes[i]]);
+        const int lod = Primitives[packet.Primitive].Lod;
+        const DrawLevel& level = packet.Levels[lod];
+        FrameDraws.LodDraws[lod]++;
+        if (level.VertexArray != current_vertex_array) {
+            current_vertex_array = level.VertexArray;
+            glBindVertexArray(current_vertex_array);
+            FrameDraws.VertexArrayBinds++;
+        }
+        // Levels of detail share vertices and so their dequantization
+        if (packet.Vertices != current_vertices) {
+            current_vertices = packet.Vertices;
+            glUniform3fv(Handlers->PositionScaleHandle, 1, packet.PositionScale);
+            glUniform3fv(Handlers->PositionOffsetHandle, 1, packet.PositionOffset);
+            glUniform1i(Handlers->PackedNormalHandle, QuantizedVertexFormat);
+        }
+
+        if (lod > 0 || packet.MeshletCount == 0) {
+            drawPacket(packet, level);
+            continue;
+        }
+        if (cluster_node != current_node) {
+            cluster_node = current_node;
+            clusterCullingSpace(current_node, node_frustum, node_camera, node_mirrored);
+        }
+        drawClusters(packet, node_frustum, node_camera, !node_mirrored);
     }
 
     glBindVertexArray(0);
 }
 
+// Same draws as drawModel collected into draw records and indirect commands, then submitted per bucket
+// A record is written whenever node or vertices change, commands of the packets in between point to it
+void RenderClass::drawModelIndirect() {
+    glUseProgram(RenderPassesV->IndirectBasePassProgram);
+    Indirect.BeginFrame();
+
+    int current_node = -1;
+    int current_vertices = -1;
+    int current_draw = -1;
+    Frustum node_frustum;
+    float node_camera[3] = { 0.0f, 0.0f, 0.0f };
+    bool node_mirrored = false;
+    int cluster_node = -1;
+    for (size_t i = 0; i < DrawPackets.size(); ++i) {
+        const DrawPacket& packet = DrawPackets[i];
+        if (!PrimitiveVisible[packet.Primitive]) {
+            continue;
+        }
+
+        if (packet.Transform != current_node || packet.Vertices != current_vertices) {
+            if (packet.Transform != current_node) {
+                current_node = packet.Transform;
+                Affine node_model_view = Multiply(ModelTransform, Nodes.World[current_node]);
+                ModelViewMatrix = ToMat4(node_model_view);
+                ModelViewProjectionMatrix = Multiply(ProjectionMatrix, node_model_view);
+            }
+            current_vertices = packet.Vertices;
+            current_draw = Indirect.AddDraw(ModelViewProjectionMatrix.m, ModelViewMatrix.m, packet.PositionScale, packet.PositionOffset);
+        }
+
+        const int lod = Primitives[packet.Primitive].Lod;
+        const DrawLevel& level = packet.Levels[lod];
+        FrameDraws.LodDraws[lod]++;
+        if (lod > 0 || packet.MeshletCount == 0) {
+            const size_t index_size = packet.IndexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+            Indirect.AddCommand(level.Bucket, level.IndexCount, (GLuint)(level.IndexOffset / index_size), packet.BaseVertex, current_draw);
+            continue;
+        }
+        if (cluster_node != current_node) {
+            cluster_node = current_node;
+            clusterCullingSpace(current_node, node_frustum, node_camera, node_mirrored);
+        }
+        collectClusterRuns(packet, node_frustum, node_camera, !node_mirrored);
+        for (size_t run = 0; run < ClusterCounts.size(); ++run) {
+            Indirect.AddCommand(level.Bucket, ClusterCounts[run], ClusterFirstIndices[run], packet.BaseVertex, current_draw);
+        }
+    }
+
+    Indirect.Submit(Materials, FrameDraws);
+    glUseProgram(RenderPassesV->BasePassProgram);
+}
+
 // Generic plane and quad data
 float plane_vertices[][3] = {
     { -10.0f, 0.0f, -10.0f },
@@ -770,6 +1905,9 @@ void RenderClass::CreateFullscreenQuad(const float i_Width, const float i_Height
 }
 
 void RenderClass::DestroyGeometry() {
+    Geometry.Destroy();
+    GeometryLods.clear();
+    Meshlets.clear();
     glDeleteBuffers(1, &quad_VBO);
     glDeleteVertexArrays(1, &GQuadVAO);
     glDeleteBuffers(1, &plane_VBO);
@@ -1,15 +1,41 @@
 #ifndef RENDER_H
 #define RENDER_H
 
+#include <array>
+#include <atomic>
 #include <vector>
+#include <map>
+#include <memory>
+#include <thread>
+#ifdef _WIN32
 #include <Windows.h>
-#include <GL\glcorearb.h>
+#endif
+#include <GL/glcorearb.h>
 #include "OpenGLFunctions.h"
 #include "RenderStructs.h"
-#include "..\\MatrixAlgebra.h"
-#include "..\\Utils\\Utils.h"
-#include "..\\tinyGLTF\\tiny_gltf.h"
-#include "..\\Configs\\KeysConfiguration.h"
+#include "SceneNodes.h"
+#include "BVH.h"
+#include "GPUTimer.h"
+#include "SceneCache.h"
+#include "ProgramCache.h"
+#include "LightingPermutations.h"
+#include "ImageDecode.h"
+#include "MipChain.h"
+#include "Materials.h"
+#include "GeometryBuffers.h"
+#include "IndirectDraws.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Meshlets.h"
+#include "../MatrixAlgebra.h"
+#include "../Utils/Utils.h"
+#include "../Utils/Profiler.h"
+#include "../Utils/MappedFile.h"
+#include "../Utils/PhaseTimer.h"
+#include "../Utils/Hash.h"
+#include "../Utils/AllocationCounter.h"
+#include "../tinyGLTF/tiny_gltf.h"
+#include "../Configs/KeysConfiguration.h"
 
 static unsigned int GQuadVAO = 0;
 static unsigned int GPlaneVAO = 0;
@@ -18,6 +44,23 @@ static unsigned int GPlaneVAO = 0;
 #define DefaultFOV 45.0f
 #define DefaultNearClipPlane 1.0f
 #define DefaultFarClipPlane 20.0f
+#define BVHCullingThreshold 16384                   // Below this primitive count a flat SIMD test is faster than traversal (see --microbench bvh)
+#define SceneBinaryFile "../Resources/scene.glb"     // Used instead of the text scene when present
+#define SceneTextFile "../Resources/scene.gltf"
+#define SceneCacheFile "../Resources/scene.cooked"   // Cooked package written on first run, rebuilt when source changes
+#define TextureMipFilter MipFilterKaiser             // Filter of generated material texture mip chains
+#define MaxMaterialAnisotropy 8.0f                   // Clamped to what the driver supports
+#define OptimizeMeshesOnLoad 1                       // Weld and reorder triangle meshes before cooking, 0 uploads them as authored
+#define LodPixelError 1.0f                           // Largest simplification error allowed on screen, in pixels
+#define LodHysteresis 0.25f                          // Coarser level is taken only once its error is this fraction below the limit
+#define MeshletCulling 1                             // Full detail draws skip meshlets outside the frustum or facing away
+#define QuantizedVertexFormat 1                      // Upload 16 bit positions and normals and half float texcoords, 0 keeps floats
+#define StreamSceneLoading 1                         // Load scene on a thread and upload it over frames, 0 loads it before the first frame
+#define StreamFrameBytes (4u << 20)                  // Geometry and texture bytes uploaded per frame while streaming
+#define ShaderDirectory "Shaders/"                   // Sources of <name>.vp/.fp and their program binaries
+#define ProgramBinaryCache 1                         // Reuse linked programs stored by the driver, 0 compiles every start
+#define DefaultLightingQuality LightingQualityHigh   // Lighting pass permutation used until another quality is chosen
+#define IndirectSceneDraws 1                         // Submit model draws with multi draw indirect where supported, 0 draws packet by packet
 
 class RenderClass {
 
@@ -27,12 +70,47 @@ private:
 	
 	float           Angle = 0;                                  // Rotation angle for scene objects
 	float           LightDistance = 0;                          // Light position distance from camera
-	float           ProjectionMatrix[16] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };                   // Projection matrix
-	float           ModelViewMatrix[16] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };;                    // Model view matrix
-	float           ModelViewProjectionMatrix[16] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };;          // Model view projection matrix
-
-
-	HDC*			DeviceContext;
+	Mat4            ProjectionMatrix = {};                      // Projection matrix
+	Mat4            ModelViewMatrix = {};                       // Model view matrix
+	Mat4            ModelViewProjectionMatrix = {};             // Model view projection matrix
+	Mat4            PlaneModelViewMatrix = {};                  // Plane model view matrix, static
+	Mat4            PlaneModelViewProjectionMatrix = {};        // Plane model view projection matrix, static
+	Affine          ModelTransform = {};                        // Model view transform of the loaded model root
+	float           TransformAngle = -1.0f;                     // Angle the cached model transform was built for
+	GLuint          OutputFramebuffer = 0;                      // Framebuffer lighting pass draws into, 0 for window back buffer
+	bool            AnimationScripted = false;                  // Angle and LightDistance are set from outside, not advanced per frame
+	DrawStats       FrameDraws;                                 // Draw counters of the last frame
+	GPUPassTimer    PassTimer;                                  // GPU time of base and lighting pass
+	SceneCache      CookedScene;                                // Mapped cooked package, released after upload
+	std::string     SceneSource;                                // glTF file of the scene, mip caches of its images are stored next to it
+	std::thread     SceneLoader;                                // Parses, decodes and prepares the scene off the render thread
+	std::atomic<bool> SceneLoaded{ false };                     // Loader is done, render thread may take its results
+	bool            SceneAdopted = false;                       // Scene data belongs to the render thread, until then only the plane is drawn
+	std::string     SceneLoadError;                             // Written by the loader before SceneLoaded, empty on success
+	bool            SceneFailed = false;                        // Load error was reported, the scene is never adopted
+	bool            SceneCooked = false;                        // Scene came from the cooked package
+	PhaseTimer      LoadTimer;                                  // Loader phases
+	PhaseTimer      StreamTimer;                                // From adoption until everything is resident
+	int             StreamFrames = 0;
+	StagingRing     Staging;                                    // Upload memory of streamed geometry and textures
+	std::vector<PendingGeometry> PendingGeometries;             // Uploaded in order
+	size_t          NextGeometry = 0;
+	std::map<uint32_t, size_t> PendingFormatBytes;              // Vertex bytes per format, arenas are sized to them on adoption
+	size_t          PendingIndexBytes = 0;
+	std::vector<PendingTexture> PendingTextures;
+	uint64_t        ProgramDriverHash = 0;                      // Part of program cache keys, 0 when binaries are not cached
+	int             ProgramsBuilt = 0;                          // Programs created so far, either way
+	int             ProgramsCached = 0;                         // Of them loaded from program binaries
+	LightingPermutations Lighting;                              // Lighting pass variants built so far
+	LightingQuality Quality = DefaultLightingQuality;
+	int             SteadyFrames = 0;                           // Frames drawn in a row with the scene resident and nothing reconfigured
+	IndirectDraws   Indirect;                                   // Draw records and commands of indirect model draws
+	bool            IndirectReady = false;                      // Current packets have buckets and buffers are large enough
+	bool            IndirectEnabled = IndirectSceneDraws;       // Indirect draws are used when ready, toggled for comparison
+	float           MaterialAnisotropy = 1.0f;                  // Anisotropy of MaterialFilterAnisotropic, 1 when unsupported
+	MaterialFilter  Filter = MaterialFilterAnisotropic;
+	Affine          ViewTransform = {};                         // Scene to camera space, applied only when CameraScripted
+	bool            CameraScripted = false;                     // Camera was moved from its fixed place at the origin
 
 public:
 
@@ -41,36 +119,99 @@ public:
 	std::unique_ptr<RenderPasses> RenderPassesV = std::make_unique<RenderPasses>();
 
 	tinygltf::Model model;
-	std::pair<GLuint, std::map<int, GLuint>> vaoAndEbos;
-
-	RenderClass(HDC* inDeviceContext, float* iWidth, float* iHeight);
+	SceneNodes Nodes;                                            // Flattened node hierarchy of the loaded model
+	MaterialLibrary Materials;                                   // Material table and textures of model images
+	std::vector<ScenePrimitive> Primitives;                      // Every primitive of every mesh node, grouped by node
+	std::vector<int> NodeFirstPrimitive;                         // First primitive of each node, one extra entry at the end
+	std::vector<AABB> PrimitiveWorldBounds;                      // Scene space bounds of Primitives
+	BoxSoA PrimitiveBounds;                                      // Same bounds in SIMD friendly layout
+	BVH PrimitiveHierarchy;                                      // Hierarchy over PrimitiveWorldBounds
+	std::vector<unsigned char> PrimitiveVisible;                 // Frustum test result of Primitives
+	CullingStats Culling;                                        // Culling counters of the last frame
+	GeometryBuffers Geometry;                                     // Vertex and index arenas of all primitives
+	std::vector<LodChain> GeometryLods;                          // Levels of detail of every uploaded geometry
+	std::vector<Meshlet> Meshlets;                               // Clusters of full detail geometry, see LodChain
+	std::vector<GLuint> ClusterFirstIndices;                     // Index runs of visible clusters of one draw, reused by every draw
+	std::vector<GLsizei> ClusterCounts;
+	std::vector<const void*> ClusterOffsets;                     // Same runs as multi draw arguments
+	std::vector<GLint> ClusterBaseVertices;
+	std::vector<DrawPacket> DrawPackets;                         // Model draws in primitive order, rebuilt only when geometry is added
+	std::vector<int> ChangedPrimitives;                          // Primitives of moved subtrees, reused by every refit
+
+	// i_Quality picks the lighting permutation built at startup, others are built when first selected
+	RenderClass(float* iWidth, float* iHeight, const GLuint i_OutputFramebuffer = 0, const LightingQuality i_Quality = DefaultLightingQuality);
 	~RenderClass();
 
 	void Render();
 
 	void Resize(const int i_Width, const int i_Height);
 
-	HDC GetDeviceContext() { return *DeviceContext; }
+	void UpdateParameters(const unsigned int i_Key);
+
+	void UpdateModelTransform();
+
+	const CullingStats& GetCullingStats() const { return Culling; }
+	const DrawStats& GetDrawStats() const { return FrameDraws; }
+	const GPUPassTimer& GetPassTimer() const { return PassTimer; }
+
+	// Print latest culling, draw and GPU query results to console
+	void DumpStats() const;
+
+	// Use given animation state instead of advancing it every frame (reproducible runs)
+	void SetAnimation(const float i_Angle, const float i_LightDistance);
+
+	// Camera at given scene position, pitched by i_Pitch degrees around X, instead of the fixed camera at the origin
+	void SetCamera(const float* i_Position, const float i_Pitch);
+
+	// Minification filter of every material texture, false without sampler objects
+	bool SetMaterialFilter(const MaterialFilter i_Filter);
+	MaterialFilter GetMaterialFilter() const { return Filter; }
+
+	// Switch lighting pass to the permutation of given quality, it is compiled now if it was never used
+	bool SetLightingQuality(const LightingQuality i_Quality);
+	LightingQuality GetLightingQuality() const { return Quality; }
+
+	// Submit model draws with multi draw indirect (when supported) or packet by packet
+	void SetIndirectDraws(const bool i_Enabled);
+	bool IsDrawingIndirect() const { return IndirectEnabled && IndirectReady; }
 
-	void UpdateParameters(WPARAM i_wParam, LPARAM i_lParam);
+	// Wait for the scene loader and upload the rest of the scene without a budget (benchmarks, offscreen output)
+	void FinishSceneLoading();
+	bool IsSceneResident() const;
 
-	void drawModel(const std::pair<GLuint, std::map<int, GLuint>>& vaoAndEbos, tinygltf::Model& model);
+	void drawModel();
 
 	// Load and draw function based on tinyGLTF library
 	// TODO: separate to different class
-	void bindMesh(std::map<int, GLuint>& vbos, tinygltf::Model& model, tinygltf::Mesh& mesh);
-	void bindModelNodes(std::map<int, GLuint>& vbos, tinygltf::Model& model, tinygltf::Node& node);
-	std::pair<GLuint, std::map<int, GLuint>> bindModel(tinygltf::Model& model);
-	bool loadModel(tinygltf::Model& model, const char* filename);
-	void drawMesh(const std::map<int, GLuint>& vbos, tinygltf::Model& model, tinygltf::Mesh& mesh);
-	void drawModelNodes(const std::pair<GLuint, std::map<int, GLuint>>& vaoAndEbos, tinygltf::Model& model, tinygltf::Node& node);
+	// prepare* run on the scene loader thread and never touch GL, upload*/stream* run on the render thread
+	// False with the reason in o_Error, never ends the process
+	bool loadModel(tinygltf::Model& model, const char* filename, DeferredImages* o_Images, std::string& o_Error);
+	void prepareGeometry(tinygltf::Model& model);
+	bool prepareTexture(tinygltf::Model& model, const int i_Image, const MipContent i_Content, PendingTexture& o_Texture);
+	void uploadGeometry(PendingGeometry& io_Geometry);
+	void createTexture(PendingTexture& io_Texture);
+	size_t streamTexture(PendingTexture& io_Texture, const size_t i_Budget);
+	void drawPacket(const DrawPacket& i_Packet, const DrawLevel& i_Level);
+	void drawClusters(const DrawPacket& i_Packet, const Frustum& i_Frustum, const float* i_Camera, const bool i_TestCone);
+	void collectClusterRuns(const DrawPacket& i_Packet, const Frustum& i_Frustum, const float* i_Camera, const bool i_TestCone);
+	void clusterCullingSpace(const int i_Node, Frustum& o_Frustum, float* o_Camera, bool& o_Mirrored) const;
+	void drawModelIndirect();
+
+	void BuildPrimitiveList();
+	void BuildDrawPackets();
+	void UpdatePrimitiveBounds(const size_t i_First, const size_t i_End);
+	void RefitPrimitiveBounds();
+	void CullPrimitives();
+	void SelectLods();
 
 	void ResetOGLStateDefault();
 	void BindShaderUniformAdresses();
 	void CreateGBuffer();
-	void PrepareScene();
+	void LoadScene();
+	void StreamScene(const size_t i_Budget);
 	void CreateGBRenderTargets();
 	void BindTextures();
+	void CreateSamplers();
 
 	static GLuint CreateRectTexture(const size_t, const size_t, const GLenum, const GLenum, const GLenum);
 	static GLuint CreateRenderTarget(const std::vector<std::pair<GLenum, GLuint>>);
@@ -79,9 +220,13 @@ public:
 	void CreateFullscreenQuad(const float i_Width, const float i_Height);
 	void DestroyGeometry();
 
-	static GLuint RenderClass::CreateShader(const std::string i_Filename, const GLenum i_Type);
-	void RenderClass::DestroyShaders();
-	bool RenderClass::CreateShaders();
+	static GLuint CreateShader(const std::string& i_Source, const GLenum i_Type);
+	// Program from ShaderDirectory/<i_Name>.vp/.fp with i_Defines injected after #version,
+	// list index is the location of each attribute and fragment output
+	GLuint CreateProgram(const char* i_Name, const std::vector<const char*>& i_Attributes, const std::vector<const char*>& i_Outputs,
+		const std::string& i_Defines = std::string());
+	void DestroyShaders();
+	bool CreateShaders();
 
 };
 
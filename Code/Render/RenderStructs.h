@@ -1,5 +1,12 @@
 #pragma once
+#include <memory>
+#include <type_traits>
+#include <vector>
 #include <GL/glcorearb.h>
+#include "Culling.h"
+#include "MeshSimplifier.h"
+#include "Meshlets.h"
+#include "MipChain.h"
 
 // Uniform handler adresses
 struct GLHandlers {
@@ -8,6 +15,9 @@ struct GLHandlers {
 	GLint           DiffuseTextureHandle = -1;                   // Base pass diffuse texture parameter handle
 	GLint           DiffuseNormalTextureHandle = -1;             // Base pass diffuse normal texture parameter handle
 	GLint           DiffusePBRTextureHandle = -1;				 // Base pass diffuse PBR parameter handle
+	GLint           PositionScaleHandle = -1;                    // Base pass position dequantization scale handle
+	GLint           PositionOffsetHandle = -1;                   // Base pass position dequantization offset handle
+	GLint           PackedNormalHandle = -1;                     // Base pass octahedral normal switch handle
 	GLint           ColorTextureHandle = -1;                     // Lighting pass color texture parameter handle
 	GLint           NormalTextureHandle = -1;                    // Lighting pass normal texture parameter handle
 	GLint           PositionTextureHandle = -1;                  // Lighting pass position texture parameter handle
@@ -17,18 +27,111 @@ struct GLHandlers {
 
 // Uniform texture adresses
 struct GLTextures {
-	GLuint          DiffuseTexture = -1;                         // Diffuse texture ID for geometry
-	GLuint          DiffuseNormalTexture = -1;                   // Diffuse normal texture ID for geometry
-	GLuint          DiffusePBRTexture = -1;						 // Diffuse PBR texture ID for geometry
 	GLuint          ColorTexture = -1;                           // Texture containing colors of scene objects
 	GLuint          NormalTexture = -1;                          // Texture containing normal vectors of scene objects
 	GLuint          PositionTexture = -1;                        // Texture containing positions of scene objects
 	GLuint          DepthTexture = -1;                           // Texture used as a depth buffer
 	GLuint          BasePassRT = -1;                             // Render target texture for base pass
+	GLuint          MaterialSampler = 0;                         // Trilinear/anisotropic sampler shared by material textures, 0 without sampler objects
 };
 
 // Render passes
 struct RenderPasses {
 	unsigned int    BasePassProgram = 0;                        // Shader program used for drawing base pass
 	unsigned int    LightingPassProgram = 0;                    // Shader program used for drawing lighting pass
-};
\ No newline at end of file
+	unsigned int    IndirectBasePassProgram = 0;                // Base pass reading matrices from draw records, 0 without indirect draws
+};
+
+// Single primitive of a mesh placed by a scene node
+struct ScenePrimitive {
+	int             Node = -1;                                  // Flattened scene node index
+	int             Mesh = -1;                                  // glTF mesh index
+	int             Primitive = -1;                             // Primitive index inside the mesh
+	int             Material = -1;                              // Index in material table
+	int             Geometry = -1;                              // Full detail geometry range in shared buffers, -1 is not drawn
+	int             Lods = -1;                                  // Level of detail chain of the geometry
+	int             Lod = 0;                                    // Level drawn last frame, selection starts from it
+	AABB            LocalBounds;                                // Bounds from POSITION accessor min/max
+};
+
+// Levels of detail of one geometry, error grows with the level
+struct LodChain {
+	int             Geometry[MaxLodLevels];                     // Geometry ranges, level 0 is full detail
+	float           Error[MaxLodLevels];                        // Simplification error relative to mesh extent
+	int             Count = 0;
+	int             FirstMeshlet = 0;                           // Clusters of level 0, none for small or non-triangle geometry
+	int             MeshletCount = 0;
+};
+
+// Index run of one level of a draw packet
+struct DrawLevel {
+	GLuint          VertexArray;                                // GL name, the index buffer is part of it
+	GLsizei         IndexCount;
+	size_t          IndexOffset;                                // Byte offset in the index buffer
+	int             Bucket;                                     // Indirect draw bucket, -1 without indirect draws
+};
+
+// Everything a model draw needs, compiled from scene primitives and geometry ranges when geometry arrives
+// The frame loop walks these in order and never touches glTF data or looks anything up
+struct DrawPacket {
+	DrawLevel       Levels[MaxLodLevels];                       // Same levels as the LOD chain, full detail first
+	GLenum          Mode;
+	GLenum          IndexType;                                  // Shared by all levels
+	GLint           BaseVertex;                                 // Shared by all levels
+	int             Material;                                   // Index in material table
+	int             Transform;                                  // Node whose world matrix places the draw
+	int             Primitive;                                  // Scene primitive, source of visibility and selected level
+	int             Vertices;                                   // Geometry range owning the vertices, dequantization changes with it
+	float           PositionScale[3];
+	float           PositionOffset[3];
+	int             FirstMeshlet;                               // Clusters of full detail level, see LodChain
+	int             MeshletCount;
+};
+static_assert(std::is_trivially_copyable<DrawPacket>::value, "Draw packets are copied as plain memory");
+
+// Geometry prepared by the scene loader thread, uploaded whole by the render thread
+struct PendingGeometry {
+	uint32_t        Attributes = 0;                             // Format of the upload, see VertexAttribute
+	std::vector<float> Vertices;                                // Interleaved float vertices
+	size_t          VertexCount = 0;
+	std::vector<uint32_t> Indices[MaxLodLevels];                // Full detail and simplified index lists
+	float           Error[MaxLodLevels] = {};
+	int             LevelCount = 0;
+	GLenum          Mode = GL_TRIANGLES;
+	GLenum          IndexType = GL_UNSIGNED_INT;
+	std::vector<Meshlet> Meshlets;                              // Clusters of full detail, FirstIndex relative to the geometry
+	std::vector<int> Primitives;                                // Scene primitives drawing the geometry
+	size_t          Bytes = 0;                                  // Buffer bytes of the upload, counted against the frame budget
+};
+
+// Material texture prepared by the scene loader thread, the render thread uploads it a few rows at a time
+// Levels go from the smallest one up and sampling is limited to complete levels
+struct PendingTexture {
+	int             Image = -1;                                 // glTF image index
+	int             Width = 0;
+	int             Height = 0;
+	GLenum          Format = GL_RGBA;                           // Pixel layout of level 0, lower levels are 8 bit RGBA
+	GLenum          Type = GL_UNSIGNED_BYTE;
+	size_t          PixelBytes = 4;
+	std::vector<unsigned char> Pixels;                          // Level 0 of decoded images, empty for cooked ones
+	const unsigned char* BasePixels = nullptr;                  // Level 0, in Pixels or in the mapped cooked package
+	std::unique_ptr<MipChain> Mips;                             // Levels 1 and down, generated or mapped from the mip cache
+	int             Levels = 1;
+	GLuint          Texture = 0;
+	int             Level = -1;                                 // Level being uploaded, -1 once all are resident
+	int             Row = 0;                                    // First row of it not uploaded yet
+	bool            Sampled = false;                            // Registered with materials, the smallest level is resident
+};
+
+// Draw counters of the last frame
+struct DrawStats {
+	uint32_t        DrawCalls = 0;                              // Draw commands submitted
+	uint32_t        IndirectCommands = 0;                       // Draws inside multi draw indirect calls, each of those is one call above
+	uint64_t        Triangles = 0;                              // Triangles submitted by them
+	uint32_t        MaterialBinds = 0;                          // Material texture set switches
+	uint32_t        VertexArrayBinds = 0;                       // Vertex array switches of model draws
+	uint32_t        LodDraws[MaxLodLevels] = {};                // Model draws per level of detail
+	uint32_t        ClustersTested = 0;                         // Meshlets of full detail draws
+	uint32_t        ClustersCulled = 0;                         // Meshlets rejected by frustum or normal cone
+	uint64_t        HeapAllocations = 0;                        // Render thread allocations during the frame, 0 unless counting is enabled
+};
@@ -0,0 +1,486 @@
+#include "SceneCache.h"
+#include <cstring>
+#include <fstream>
+#include <string>
+#include "../Utils/Hash.h"
+
+#define SceneCacheMagic 0x4B435253u                         // "SRCK"
+
+// Value of i_Digits hex digits at i_Position, -1 if any of them is not a hex digit
+static int32_t ReadHex(const std::string& i_Text, const size_t i_Position, const int i_Digits) {
+    if (i_Position + i_Digits > i_Text.size()) {
+        return -1;
+    }
+    int32_t value = 0;
+    for (int i = 0; i < i_Digits; ++i) {
+        const char c = i_Text[i_Position + i];
+        const int digit = c >= '0' && c <= '9' ? c - '0' : (c >= 'a' && c <= 'f' ? c - 'a' + 10 : (c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1));
+        if (digit < 0) {
+            return -1;
+        }
+        value = value * 16 + digit;
+    }
+    return value;
+}
+
+// JSON string starting at the opening quote at i_Begin, escapes resolved, returns position after the closing quote or npos
+static size_t ReadJSONString(const std::string& i_Text, const size_t i_Begin, std::string& o_Value) {
+    o_Value.clear();
+    for (size_t i = i_Begin + 1; i < i_Text.size(); ++i) {
+        const char c = i_Text[i];
+        if (c == '"') {
+            return i + 1;
+        }
+        if (c != '\\') {
+            o_Value += c;
+            continue;
+        }
+        if (++i == i_Text.size()) {
+            break;
+        }
+        switch (i_Text[i]) {
+            case 'b': o_Value += '\b'; break;
+            case 'f': o_Value += '\f'; break;
+            case 'n': o_Value += '\n'; break;
+            case 'r': o_Value += '\r'; break;
+            case 't': o_Value += '\t'; break;
+            case 'u': {
+                // Code point written back as UTF-8, surrogate pairs are joined
+                const int32_t high = ReadHex(i_Text, i + 1, 4);
+                if (high < 0) {
+                    return std::string::npos;
+                }
+                uint32_t code = (uint32_t)high;
+                i += 4;
+                if (code >= 0xD800 && code < 0xDC00 && i + 2 < i_Text.size() && i_Text[i + 1] == '\\' && i_Text[i + 2] == 'u') {
+                    const int32_t low = ReadHex(i_Text, i + 3, 4);
+                    if (low >= 0xDC00 && low < 0xE000) {
+                        code = 0x10000 + ((code - 0xD800) << 10) + ((uint32_t)low - 0xDC00);
+                        i += 6;
+                    }
+                }
+                if (code < 0x80) {
+                    o_Value += (char)code;
+                }
+                else if (code < 0x800) {
+                    o_Value += (char)(0xC0 | (code >> 6));
+                    o_Value += (char)(0x80 | (code & 0x3F));
+                }
+                else if (code < 0x10000) {
+                    o_Value += (char)(0xE0 | (code >> 12));
+                    o_Value += (char)(0x80 | ((code >> 6) & 0x3F));
+                    o_Value += (char)(0x80 | (code & 0x3F));
+                }
+                else {
+                    o_Value += (char)(0xF0 | (code >> 18));
+                    o_Value += (char)(0x80 | ((code >> 12) & 0x3F));
+                    o_Value += (char)(0x80 | ((code >> 6) & 0x3F));
+                    o_Value += (char)(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default: o_Value += i_Text[i]; break;              // Quote, backslash and slash stand for themselves
+        }
+    }
+    return std::string::npos;
+}
+
+// Percent-encoded URI to a file path, the way tinygltf decodes it ('+' is a space too)
+static std::string DecodeURI(const std::string& i_URI) {
+    std::string path;
+    for (size_t i = 0; i < i_URI.size(); ++i) {
+        const int32_t code = i_URI[i] == '%' ? ReadHex(i_URI, i + 1, 2) : -1;
+        if (code >= 0) {
+            path += (char)code;
+            i += 2;
+        }
+        else {
+            path += i_URI[i] == '+' ? ' ' : i_URI[i];
+        }
+    }
+    return path;
+}
+
+bool SceneCache::HashSource(const char* i_Filename, uint64_t& o_Hash) {
+    o_Hash = HashBytes((const unsigned char*)i_Filename, strlen(i_Filename));
+
+    MappedFile source;
+    if (!source.Open(i_Filename)) {
+        return false;
+    }
+    const size_t size = source.GetSize();
+    o_Hash = HashBytes(source.GetData(), size, o_Hash);
+
+    // Binary container holds everything it needs, text glTF refers to external files by "uri"
+    const size_t length = strlen(i_Filename);
+    if (length > 4 && strcmp(i_Filename + length - 4, ".glb") == 0) {
+        return true;
+    }
+
+    const std::string filepath(i_Filename);
+    const size_t separator = filepath.find_last_of("/\\");
+    const std::string base_dir = separator != std::string::npos ? filepath.substr(0, separator + 1) : "";
+
+    // Whole strings are skipped at once, so "uri" is only matched as a key and never inside other text
+    const std::string text((const char*)source.GetData(), size);
+    std::string token, uri;
+    for (size_t i = text.find('"'); i != std::string::npos; i = text.find('"', i)) {
+        i = ReadJSONString(text, i, token);
+        if (i == std::string::npos) {
+            break;
+        }
+        if (token != "uri") {
+            continue;
+        }
+        const size_t colon = text.find_first_not_of(" \t\r\n", i);
+        const size_t value = colon != std::string::npos && text[colon] == ':' ? text.find_first_not_of(" \t\r\n", colon + 1) : std::string::npos;
+        if (value == std::string::npos || text[value] != '"') {
+            continue;
+        }
+        i = ReadJSONString(text, value, uri);
+        if (i == std::string::npos) {
+            break;
+        }
+
+        // Embedded data is already part of the hashed text
+        if (uri.compare(0, 5, "data:") == 0) {
+            continue;
+        }
+
+        const std::string path = base_dir + DecodeURI(uri);
+        MappedFile external;
+        if (external.Open(path.c_str())) {
+            o_Hash = HashBytes(external.GetData(), external.GetSize(), o_Hash);
+        }
+        else if (!MappedFile::Exists(path.c_str())) {
+            // tinygltf loads the scene without a missing file, so its absence is hashed and the package is rebuilt once it appears
+            const std::string missing = "missing:" + path;
+            o_Hash = HashBytes((const unsigned char*)missing.data(), missing.size(), o_Hash);
+        }
+        else if (!std::ifstream(path.c_str(), std::ios::binary)) {
+            // Present but unreadable, its content is unknown so no package may be used
+            return false;
+        }
+    }
+    return true;
+}
+
+// Package writing helpers, everything is stored in native byte order
+template <typename T>
+static void Put(std::vector<unsigned char>& io_Out, const T i_Value) {
+    const unsigned char* bytes = (const unsigned char*)&i_Value;
+    io_Out.insert(io_Out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+static void PutArray(std::vector<unsigned char>& io_Out, const std::vector<T>& i_Values) {
+    Put<uint32_t>(io_Out, (uint32_t)i_Values.size());
+    const unsigned char* bytes = (const unsigned char*)i_Values.data();
+    io_Out.insert(io_Out.end(), bytes, bytes + i_Values.size() * sizeof(T));
+}
+
+static void PutString(std::vector<unsigned char>& io_Out, const std::string& i_Value) {
+    Put<uint32_t>(io_Out, (uint32_t)i_Value.size());
+    io_Out.insert(io_Out.end(), i_Value.begin(), i_Value.end());
+}
+
+static void PutBlob(std::vector<unsigned char>& io_Out, const unsigned char* i_Data, const size_t i_Size) {
+    Put<uint64_t>(io_Out, (uint64_t)i_Size);
+    io_Out.resize((io_Out.size() + SceneCacheAlignment - 1) / SceneCacheAlignment * SceneCacheAlignment, 0);
+    io_Out.insert(io_Out.end(), i_Data, i_Data + i_Size);
+}
+
+// Bounds checked reader over mapped package, any read past the end marks it as failed
+struct CacheReader {
+    const unsigned char* Data;
+    size_t          Size;
+    size_t          Position = 0;
+    bool            Failed = false;
+
+    bool Reserve(const size_t i_Bytes) {
+        Failed = Failed || i_Bytes > Size - Position;
+        return !Failed;
+    }
+
+    // Element count, every element takes at least one byte so larger counts mean damaged data
+    uint32_t GetCount() {
+        const uint32_t count = Get<uint32_t>();
+        Failed = Failed || count > Size - Position;
+        return Failed ? 0 : count;
+    }
+
+    template <typename T>
+    T Get() {
+        T value = T();
+        if (Reserve(sizeof(T))) {
+            memcpy(&value, Data + Position, sizeof(T));
+            Position += sizeof(T);
+        }
+        return value;
+    }
+
+    template <typename T>
+    void GetArray(std::vector<T>& o_Values) {
+        const uint32_t count = GetCount();
+        if (Reserve((size_t)count * sizeof(T))) {
+            o_Values.resize(count);
+            memcpy(o_Values.data(), Data + Position, (size_t)count * sizeof(T));
+            Position += (size_t)count * sizeof(T);
+        }
+    }
+
+    std::string GetString() {
+        const uint32_t length = Get<uint32_t>();
+        if (!Reserve(length)) {
+            return std::string();
+        }
+        std::string value((const char*)Data + Position, length);
+        Position += length;
+        return value;
+    }
+
+    const unsigned char* GetBlob(size_t& o_Size) {
+        o_Size = (size_t)Get<uint64_t>();
+        const size_t aligned = (Position + SceneCacheAlignment - 1) / SceneCacheAlignment * SceneCacheAlignment;
+        if (!Reserve(aligned - Position)) {
+            return nullptr;
+        }
+        Position = aligned;
+        if (!Reserve(o_Size)) {
+            return nullptr;
+        }
+        const unsigned char* blob = Data + Position;
+        Position += o_Size;
+        return blob;
+    }
+};
+
+bool SceneCache::Save(const char* i_Filename, const uint64_t i_SourceHash, const tinygltf::Model& i_Model) {
+    std::vector<unsigned char> out;
+
+    Put<uint32_t>(out, SceneCacheMagic);
+    Put<uint32_t>(out, SceneCacheVersion);
+    Put<uint64_t>(out, i_SourceHash);
+
+    Put<int32_t>(out, i_Model.defaultScene);
+    Put<uint32_t>(out, (uint32_t)i_Model.scenes.size());
+    for (const tinygltf::Scene& scene : i_Model.scenes) {
+        PutArray(out, scene.nodes);
+    }
+
+    // Node table
+    Put<uint32_t>(out, (uint32_t)i_Model.nodes.size());
+    for (const tinygltf::Node& node : i_Model.nodes) {
+        Put<int32_t>(out, node.mesh);
+        PutArray(out, node.children);
+        PutArray(out, node.matrix);
+        PutArray(out, node.translation);
+        PutArray(out, node.rotation);
+        PutArray(out, node.scale);
+    }
+
+    Put<uint32_t>(out, (uint32_t)i_Model.meshes.size());
+    for (const tinygltf::Mesh& mesh : i_Model.meshes) {
+        Put<uint32_t>(out, (uint32_t)mesh.primitives.size());
+        for (const tinygltf::Primitive& primitive : mesh.primitives) {
+            Put<uint32_t>(out, (uint32_t)primitive.attributes.size());
+            for (const auto& attribute : primitive.attributes) {
+                PutString(out, attribute.first);
+                Put<int32_t>(out, attribute.second);
+            }
+            Put<int32_t>(out, primitive.indices);
+            Put<int32_t>(out, primitive.mode);
+            Put<int32_t>(out, primitive.material);
+        }
+    }
+
+    // Accessors carry precomputed bounds used for culling
+    Put<uint32_t>(out, (uint32_t)i_Model.accessors.size());
+    for (const tinygltf::Accessor& accessor : i_Model.accessors) {
+        Put<int32_t>(out, accessor.bufferView);
+        Put<uint64_t>(out, (uint64_t)accessor.byteOffset);
+        Put<int32_t>(out, accessor.normalized ? 1 : 0);
+        Put<int32_t>(out, accessor.componentType);
+        Put<uint64_t>(out, (uint64_t)accessor.count);
+        Put<int32_t>(out, accessor.type);
+        PutArray(out, accessor.minValues);
+        PutArray(out, accessor.maxValues);
+    }
+
+    Put<uint32_t>(out, (uint32_t)i_Model.bufferViews.size());
+    for (const tinygltf::BufferView& view : i_Model.bufferViews) {
+        Put<int32_t>(out, view.buffer);
+        Put<uint64_t>(out, (uint64_t)view.byteOffset);
+        Put<uint64_t>(out, (uint64_t)view.byteLength);
+        Put<uint64_t>(out, (uint64_t)view.byteStride);
+        Put<int32_t>(out, view.target);
+    }
+
+    Put<uint32_t>(out, (uint32_t)i_Model.buffers.size());
+    for (const tinygltf::Buffer& buffer : i_Model.buffers) {
+        PutBlob(out, buffer.data.data(), buffer.data.size());
+    }
+
+    Put<uint32_t>(out, (uint32_t)i_Model.textures.size());
+    for (const tinygltf::Texture& texture : i_Model.textures) {
+        Put<int32_t>(out, texture.source);
+        Put<int32_t>(out, texture.sampler);
+    }
+
+    Put<uint32_t>(out, (uint32_t)i_Model.samplers.size());
+    for (const tinygltf::Sampler& sampler : i_Model.samplers) {
+        Put<int32_t>(out, sampler.minFilter);
+        Put<int32_t>(out, sampler.magFilter);
+        Put<int32_t>(out, sampler.wrapS);
+        Put<int32_t>(out, sampler.wrapT);
+    }
+
+    // Images are stored decoded, cooked load skips PNG/JPEG decoding
+    Put<uint32_t>(out, (uint32_t)i_Model.images.size());
+    for (const tinygltf::Image& image : i_Model.images) {
+        Put<int32_t>(out, image.width);
+        Put<int32_t>(out, image.height);
+        Put<int32_t>(out, image.component);
+        Put<int32_t>(out, image.bits);
+        Put<int32_t>(out, image.pixel_type);
+        PutBlob(out, image.image.data(), image.image.size());
+    }
+
+    // Only texture references of materials are used by the render
+    Put<uint32_t>(out, (uint32_t)i_Model.materials.size());
+    for (const tinygltf::Material& material : i_Model.materials) {
+        Put<int32_t>(out, material.pbrMetallicRoughness.baseColorTexture.index);
+        Put<int32_t>(out, material.pbrMetallicRoughness.metallicRoughnessTexture.index);
+        Put<int32_t>(out, material.normalTexture.index);
+        Put<int32_t>(out, material.occlusionTexture.index);
+    }
+
+    std::ofstream file(i_Filename, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    file.write((const char*)out.data(), (std::streamsize)out.size());
+    return file.good();
+}
+
+bool SceneCache::Load(const char* i_Filename, const uint64_t i_SourceHash, tinygltf::Model& o_Model) {
+    if (!File.Open(i_Filename)) {
+        return false;
+    }
+
+    CacheReader reader = { File.GetData(), File.GetSize() };
+    if (reader.Get<uint32_t>() != SceneCacheMagic || reader.Get<uint32_t>() != SceneCacheVersion || reader.Get<uint64_t>() != i_SourceHash) {
+        Release();
+        return false;
+    }
+
+    tinygltf::Model model;
+    model.defaultScene = reader.Get<int32_t>();
+    model.scenes.resize(reader.GetCount());
+    for (tinygltf::Scene& scene : model.scenes) {
+        reader.GetArray(scene.nodes);
+    }
+
+    model.nodes.resize(reader.GetCount());
+    for (tinygltf::Node& node : model.nodes) {
+        node.mesh = reader.Get<int32_t>();
+        reader.GetArray(node.children);
+        reader.GetArray(node.matrix);
+        reader.GetArray(node.translation);
+        reader.GetArray(node.rotation);
+        reader.GetArray(node.scale);
+    }
+
+    model.meshes.resize(reader.GetCount());
+    for (tinygltf::Mesh& mesh : model.meshes) {
+        mesh.primitives.resize(reader.GetCount());
+        for (tinygltf::Primitive& primitive : mesh.primitives) {
+            const uint32_t attributes = reader.GetCount();
+            for (uint32_t i = 0; i < attributes && !reader.Failed; ++i) {
+                const std::string name = reader.GetString();
+                primitive.attributes[name] = reader.Get<int32_t>();
+            }
+            primitive.indices = reader.Get<int32_t>();
+            primitive.mode = reader.Get<int32_t>();
+            primitive.material = reader.Get<int32_t>();
+        }
+    }
+
+    model.accessors.resize(reader.GetCount());
+    for (tinygltf::Accessor& accessor : model.accessors) {
+        accessor.bufferView = reader.Get<int32_t>();
+        accessor.byteOffset = (size_t)reader.Get<uint64_t>();
+        accessor.normalized = reader.Get<int32_t>() != 0;
+        accessor.componentType = reader.Get<int32_t>();
+        accessor.count = (size_t)reader.Get<uint64_t>();
+        accessor.type = reader.Get<int32_t>();
+        reader.GetArray(accessor.minValues);
+        reader.GetArray(accessor.maxValues);
+    }
+
+    model.bufferViews.resize(reader.GetCount());
+    for (tinygltf::BufferView& view : model.bufferViews) {
+        view.buffer = reader.Get<int32_t>();
+        view.byteOffset = (size_t)reader.Get<uint64_t>();
+        view.byteLength = (size_t)reader.Get<uint64_t>();
+        view.byteStride = (size_t)reader.Get<uint64_t>();
+        view.target = reader.Get<int32_t>();
+    }
+
+    // Buffers stay in the mapping, they are uploaded from there
+    model.buffers.resize(reader.GetCount());
+    Buffers.resize(model.buffers.size());
+    for (size_t i = 0; i < Buffers.size(); ++i) {
+        Buffers[i].first = reader.GetBlob(Buffers[i].second);
+    }
+
+    model.textures.resize(reader.GetCount());
+    for (tinygltf::Texture& texture : model.textures) {
+        texture.source = reader.Get<int32_t>();
+        texture.sampler = reader.Get<int32_t>();
+    }
+
+    model.samplers.resize(reader.GetCount());
+    for (tinygltf::Sampler& sampler : model.samplers) {
+        sampler.minFilter = reader.Get<int32_t>();
+        sampler.magFilter = reader.Get<int32_t>();
+        sampler.wrapS = reader.Get<int32_t>();
+        sampler.wrapT = reader.Get<int32_t>();
+    }
+
+    // Pixels stay in the mapping too, base levels are uploaded from there
+    model.images.resize(reader.GetCount());
+    Images.resize(model.images.size());
+    for (size_t i = 0; i < Images.size(); ++i) {
+        tinygltf::Image& image = model.images[i];
+        image.width = reader.Get<int32_t>();
+        image.height = reader.Get<int32_t>();
+        image.component = reader.Get<int32_t>();
+        image.bits = reader.Get<int32_t>();
+        image.pixel_type = reader.Get<int32_t>();
+        Images[i].first = reader.GetBlob(Images[i].second);
+    }
+
+    model.materials.resize(reader.GetCount());
+    for (tinygltf::Material& material : model.materials) {
+        material.pbrMetallicRoughness.baseColorTexture.index = reader.Get<int32_t>();
+        material.pbrMetallicRoughness.metallicRoughnessTexture.index = reader.Get<int32_t>();
+        material.normalTexture.index = reader.Get<int32_t>();
+        material.occlusionTexture.index = reader.Get<int32_t>();
+    }
+
+    // Truncated or damaged package is treated as a miss
+    if (reader.Failed) {
+        Release();
+        return false;
+    }
+
+    o_Model = std::move(model);
+    return true;
+}
+
+void SceneCache::Release() {
+    Buffers.clear();
+    Images.clear();
+    File.Close();
+}
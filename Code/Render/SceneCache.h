@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "../Utils/MappedFile.h"
+#include "../tinyGLTF/tiny_gltf.h"
+
+// Scene cache predifinitions
+#define SceneCacheVersion 2                                 // Bump whenever stored data or layout changes
+#define SceneCacheAlignment 64                              // Alignment of blobs inside the package
+
+// Cooked scene package: parts of the glTF model the render uses, with decoded images and raw buffers
+// stored as aligned blobs, keyed by a hash of the source files
+// A loaded package stays mapped until buffers and images are uploaded, their data is read straight from the mapping
+class SceneCache {
+
+public:
+	// FNV-1a of the glTF file and every external file it references, URIs are decoded like tinygltf does
+	// False when the file or one of its existing dependencies cannot be read, no package may be used then
+	static bool HashSource(const char* i_Filename, uint64_t& o_Hash);
+
+	// Write package for given model, model buffers and images must still hold their data
+	static bool Save(const char* i_Filename, const uint64_t i_SourceHash, const tinygltf::Model& i_Model);
+
+	// Fill model from package if it exists, has current version and matches source hash
+	// Buffers and image pixels are left empty in the model, their data is available through BufferData and ImageData until Release
+	bool Load(const char* i_Filename, const uint64_t i_SourceHash, tinygltf::Model& o_Model);
+
+	bool IsLoaded() const { return File.GetData() != nullptr; }
+	const unsigned char* BufferData(const int i_Buffer) const { return Buffers[i_Buffer].first; }
+	size_t BufferSize(const int i_Buffer) const { return Buffers[i_Buffer].second; }
+	const unsigned char* ImageData(const int i_Image) const { return Images[i_Image].first; }
+	size_t ImageSize(const int i_Image) const { return Images[i_Image].second; }
+
+	// Unmap package once buffers and images are on GPU
+	void Release();
+
+private:
+	MappedFile      File;
+	std::vector<std::pair<const unsigned char*, size_t>> Buffers;  // Blob of every model buffer inside the mapping
+	std::vector<std::pair<const unsigned char*, size_t>> Images;   // Decoded pixels of every model image inside the mapping
+};
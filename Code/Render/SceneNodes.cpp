@@ -0,0 +1,168 @@
+#include "SceneNodes.h"
+
+// Pick the cheapest TRS kernel able to represent given values
+static TransformKind ClassifyTRS(const float* i_Translation, const Quat& i_Rotation, const float* i_Scale) {
+    const bool unit_scale = i_Scale[0] == 1.0f && i_Scale[1] == 1.0f && i_Scale[2] == 1.0f;
+    const bool uniform_scale = i_Scale[0] == i_Scale[1] && i_Scale[1] == i_Scale[2];
+    const bool no_rotation = i_Rotation.x == 0.0f && i_Rotation.y == 0.0f && i_Rotation.z == 0.0f;
+    const bool no_translation = i_Translation[0] == 0.0f && i_Translation[1] == 0.0f && i_Translation[2] == 0.0f;
+
+    if (unit_scale && no_rotation && no_translation) {
+        return TransformKind::Identity;
+    }
+    if (unit_scale) {
+        return TransformKind::RotationOnly;
+    }
+    if (uniform_scale) {
+        return TransformKind::UniformScale;
+    }
+    return TransformKind::General;
+}
+
+void SceneNodes::Build(const tinygltf::Model& i_Model, const int i_Scene) {
+    Parent.clear();
+    SubtreeEnd.clear();
+    Mesh.clear();
+    SourceNode.clear();
+    Translation.clear();
+    Rotation.clear();
+    Scale.clear();
+    Kind.clear();
+    HasMatrix.clear();
+    Local.clear();
+    World.clear();
+    Dirty.clear();
+
+    if (i_Model.scenes.empty()) {
+        FirstDirty = 0;
+        return;
+    }
+
+    const tinygltf::Scene& scene = i_Model.scenes[i_Scene >= 0 ? i_Scene : 0];
+    for (size_t i = 0; i < scene.nodes.size(); ++i) {
+        assert((scene.nodes[i] >= 0) && ((size_t)scene.nodes[i] < i_Model.nodes.size()));
+        AddNode(i_Model, scene.nodes[i], -1);
+    }
+
+    World.resize(Size());
+
+    // Everything is dirty after build
+    FirstDirty = 0;
+    UpdateWorld();
+}
+
+// Append node and its subtree in depth-first order
+void SceneNodes::AddNode(const tinygltf::Model& i_Model, const int i_SourceNode, const int i_Parent) {
+    const tinygltf::Node& node = i_Model.nodes[i_SourceNode];
+    const int index = (int)Parent.size();
+
+    Parent.push_back(i_Parent);
+    SubtreeEnd.push_back(index + 1);
+    Mesh.push_back((node.mesh >= 0 && node.mesh < (int)i_Model.meshes.size()) ? node.mesh : -1);
+    SourceNode.push_back(i_SourceNode);
+
+    float translation[3] = { 0.0f, 0.0f, 0.0f };
+    Quat rotation = QuatIdentity();
+    float scale[3] = { 1.0f, 1.0f, 1.0f };
+
+    if (node.translation.size() == 3) {
+        for (int i = 0; i < 3; ++i) translation[i] = (float)node.translation[i];
+    }
+    if (node.rotation.size() == 4) {
+        rotation = Quat{ (float)node.rotation[0], (float)node.rotation[1], (float)node.rotation[2], (float)node.rotation[3] };
+    }
+    if (node.scale.size() == 3) {
+        for (int i = 0; i < 3; ++i) scale[i] = (float)node.scale[i];
+    }
+
+    Translation.insert(Translation.end(), translation, translation + 3);
+    Rotation.push_back(rotation);
+    Scale.insert(Scale.end(), scale, scale + 3);
+    Kind.push_back(ClassifyTRS(translation, rotation, scale));
+    HasMatrix.push_back(node.matrix.size() == 16);
+    Local.push_back(AffineIdentity());
+    Dirty.push_back(1);
+
+    if (HasMatrix[index]) {
+        // glTF matrix is column-major 4x4, affine rows are its first three rows
+        Affine& local = Local[index];
+        for (int row = 0; row < 3; ++row) {
+            for (int column = 0; column < 4; ++column) {
+                local.m[row * 4 + column] = (float)node.matrix[column * 4 + row];
+            }
+        }
+    }
+    else {
+        ComposeLocal(index);
+    }
+
+    for (size_t i = 0; i < node.children.size(); i++) {
+        assert((node.children[i] >= 0) && ((size_t)node.children[i] < i_Model.nodes.size()));
+        AddNode(i_Model, node.children[i], index);
+    }
+
+    SubtreeEnd[index] = (int)Parent.size();
+}
+
+void SceneNodes::ComposeLocal(const int i_Node) {
+    const float* translation = &Translation[i_Node * 3];
+    const float* scale = &Scale[i_Node * 3];
+    const Quat& rotation = Rotation[i_Node];
+
+    switch (Kind[i_Node]) {
+        case TransformKind::Identity:
+            Local[i_Node] = ComposeTRS<TransformKind::Identity>(translation, rotation, scale);
+            break;
+        case TransformKind::RotationOnly:
+            Local[i_Node] = ComposeTRS<TransformKind::RotationOnly>(translation, rotation, scale);
+            break;
+        case TransformKind::UniformScale:
+            Local[i_Node] = ComposeTRS<TransformKind::UniformScale>(translation, rotation, scale);
+            break;
+        case TransformKind::General:
+            Local[i_Node] = ComposeTRS<TransformKind::General>(translation, rotation, scale);
+            break;
+    }
+}
+
+void SceneNodes::SetLocalTRS(const int i_Node, const float* i_Translation, const Quat& i_Rotation, const float* i_Scale) {
+    for (int i = 0; i < 3; ++i) {
+        Translation[i_Node * 3 + i] = i_Translation[i];
+        Scale[i_Node * 3 + i] = i_Scale[i];
+    }
+    Rotation[i_Node] = i_Rotation;
+    Kind[i_Node] = ClassifyTRS(i_Translation, i_Rotation, i_Scale);
+    HasMatrix[i_Node] = 0;
+    ComposeLocal(i_Node);
+
+    Dirty[i_Node] = 1;
+    if (i_Node < FirstDirty) {
+        FirstDirty = i_Node;
+    }
+}
+
+void SceneNodes::UpdateWorld() {
+    UpdatedCount = 0;
+    UpdatedSubtrees.clear();
+
+    const int count = (int)Size();
+    int i = FirstDirty;
+    while (i < count) {
+        if (!Dirty[i]) {
+            ++i;
+            continue;
+        }
+
+        // Whole subtree is contiguous and parents precede children - one forward pass refreshes it
+        const int end = SubtreeEnd[i];
+        for (int node = i; node < end; ++node) {
+            World[node] = Parent[node] < 0 ? Local[node] : Multiply(World[Parent[node]], Local[node]);
+            Dirty[node] = 0;
+        }
+        UpdatedCount += end - i;
+        UpdatedSubtrees.push_back(i);
+        i = end;
+    }
+
+    FirstDirty = count;
+}
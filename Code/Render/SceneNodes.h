@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include "../MatrixAlgebra.h"
+#include "../tinyGLTF/tiny_gltf.h"
+
+// Flattened glTF node hierarchy
+// Nodes are stored depth-first (parent before child, every subtree is a contiguous range)
+// in structure of arrays form so world matrix updates are a linear sweep over packed data
+class SceneNodes {
+
+public:
+	std::vector<int>            Parent;             // Parent node index, -1 for scene roots
+	std::vector<int>            SubtreeEnd;         // One past the last node of the subtree starting at this node
+	std::vector<int>            Mesh;               // glTF mesh index, -1 if node has no mesh
+	std::vector<int>            SourceNode;         // Index of the node in tinygltf::Model::nodes
+
+	std::vector<float>          Translation;        // Local translation, 3 floats per node
+	std::vector<Quat>           Rotation;           // Local rotation
+	std::vector<float>          Scale;              // Local scale, 3 floats per node
+	std::vector<TransformKind>  Kind;               // Which TRS kernel the local transform needs
+	std::vector<unsigned char>  HasMatrix;          // Local transform given as glTF matrix, TRS values unused
+
+	std::vector<Affine>         Local;              // Local transform
+	std::vector<Affine>         World;              // Transform relative to scene root
+	std::vector<unsigned char>  Dirty;              // Local transform changed since last update
+
+	// Flatten given scene of the model, all world matrices are computed
+	void Build(const tinygltf::Model& i_Model, const int i_Scene);
+
+	// Change local TRS of a node, world matrices of its subtree are refreshed by next UpdateWorld
+	void SetLocalTRS(const int i_Node, const float* i_Translation, const Quat& i_Rotation, const float* i_Scale);
+
+	// Recompute world matrices of dirty subtrees only
+	void UpdateWorld();
+
+	size_t Size() const { return Parent.size(); }
+
+	// Returns the number of nodes processed by the last UpdateWorld call
+	size_t LastUpdatedCount() const { return UpdatedCount; }
+
+	// Roots of subtrees refreshed by the last UpdateWorld call, node range of each is [root, SubtreeEnd[root])
+	const std::vector<int>& LastUpdatedSubtrees() const { return UpdatedSubtrees; }
+
+private:
+	int                         FirstDirty = 0;     // Lowest dirty node index, Size() if nothing is dirty
+	size_t                      UpdatedCount = 0;
+	std::vector<int>            UpdatedSubtrees;
+
+	void AddNode(const tinygltf::Model& i_Model, const int i_SourceNode, const int i_Parent);
+	void ComposeLocal(const int i_Node);
+};
@@ -0,0 +1,86 @@
+#include "StagingRing.h"
+
+bool StagingRing::Create(const size_t i_FrameBytes) {
+    if (!glBufferStorage || !glFenceSync || !glClientWaitSync || !glDeleteSync || !glCopyBufferSubData || i_FrameBytes == 0) {
+        return false;
+    }
+
+    const size_t size = i_FrameBytes * StagingRingFrames;
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &RingBuffer);
+    glBindBuffer(GL_COPY_READ_BUFFER, RingBuffer);
+    glBufferStorage(GL_COPY_READ_BUFFER, size, nullptr, flags);
+    Mapped = (unsigned char*)glMapBufferRange(GL_COPY_READ_BUFFER, 0, size, flags);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    if (!Mapped) {
+        glDeleteBuffers(1, &RingBuffer);
+        RingBuffer = 0;
+        return false;
+    }
+
+    FrameBytes = i_FrameBytes;
+    Segment = StagingRingFrames - 1;
+    Used = 0;
+    Writable = false;
+    return true;
+}
+
+void StagingRing::Destroy() {
+    for (int i = 0; i < StagingRingFrames; ++i) {
+        if (Fences[i]) {
+            glDeleteSync(Fences[i]);
+            Fences[i] = nullptr;
+        }
+    }
+    if (RingBuffer) {
+        glBindBuffer(GL_COPY_READ_BUFFER, RingBuffer);
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glDeleteBuffers(1, &RingBuffer);
+    }
+    RingBuffer = 0;
+    Mapped = nullptr;
+    Writable = false;
+}
+
+bool StagingRing::BeginFrame() {
+    Writable = false;
+    if (!Mapped) {
+        return false;
+    }
+
+    // Segment stays where it is until its copies have finished, so a slow GPU only delays uploads
+    const int next = (Segment + 1) % StagingRingFrames;
+    if (Fences[next]) {
+        const GLenum status = glClientWaitSync(Fences[next], 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            return false;
+        }
+        glDeleteSync(Fences[next]);
+        Fences[next] = nullptr;
+    }
+    Segment = next;
+    Used = 0;
+    Writable = true;
+    return true;
+}
+
+void StagingRing::EndFrame() {
+    if (Writable && Used > 0) {
+        Fences[Segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    Writable = false;
+}
+
+unsigned char* StagingRing::Allocate(const size_t i_Bytes, const size_t i_Alignment, size_t& o_Offset) {
+    if (!Writable) {
+        return nullptr;
+    }
+    const size_t offset = (Used + i_Alignment - 1) / i_Alignment * i_Alignment;
+    if (offset + i_Bytes > FrameBytes) {
+        return nullptr;
+    }
+    Used = offset + i_Bytes;
+    o_Offset = Segment * FrameBytes + offset;
+    return Mapped + o_Offset;
+}
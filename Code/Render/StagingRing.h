@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include "OpenGLFunctions.h"
+
+// Staging ring predifinitions
+#define StagingRingFrames 3                                 // Segments in flight, a segment is rewritten once the GPU is done with it
+
+// Persistently mapped upload buffer split into one segment per frame in flight
+// Data written into the current segment is copied to buffers and textures by GL commands of the same frame,
+// a fence after them tells when the segment may be written again
+class StagingRing {
+
+public:
+	// False when persistent mapping, sync objects or buffer copies are unavailable, uploads then read client memory
+	bool Create(const size_t i_FrameBytes);
+	void Destroy();
+
+	// Move to the next segment, false (and no staging this frame) while the GPU still reads it, never waits
+	bool BeginFrame();
+	// Fence copies issued from the current segment
+	void EndFrame();
+
+	// Room in the current segment, nullptr when there is none, o_Offset is the position inside Buffer()
+	unsigned char* Allocate(const size_t i_Bytes, const size_t i_Alignment, size_t& o_Offset);
+
+	GLuint Buffer() const { return RingBuffer; }
+	bool IsCreated() const { return Mapped != nullptr; }
+
+private:
+	GLuint          RingBuffer = 0;
+	unsigned char*  Mapped = nullptr;                           // Whole buffer, mapped for its lifetime
+	size_t          FrameBytes = 0;                             // Size of one segment
+	GLsync          Fences[StagingRingFrames] = {};
+	int             Segment = 0;
+	size_t          Used = 0;                                   // Bytes of the current segment handed out
+	bool            Writable = false;                           // Current segment is free for this frame
+};
@@ -0,0 +1,118 @@
+#include "VertexQuantization.h"
+#include <cmath>
+#include <cstring>
+
+uint16_t FloatToHalf(const float i_Value) {
+    uint32_t bits;
+    memcpy(&bits, &i_Value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const uint32_t magnitude = bits & 0x7fffffffu;
+
+    // NaN stays NaN, infinity and everything rounding past 65504 becomes infinity
+    if (magnitude > 0x7f800000u) {
+        return (uint16_t)(sign | 0x7e00u);
+    }
+    if (magnitude >= 0x477ff000u) {
+        return (uint16_t)(sign | 0x7c00u);
+    }
+
+    // Below the smallest normal half, 2^-14, the value is a multiple of 2^-24
+    if (magnitude < 0x38800000u) {
+        if (magnitude < 0x33000000u) {
+            return (uint16_t)sign;
+        }
+        const uint32_t mantissa = (magnitude & 0x7fffffu) | 0x800000u;
+        const uint32_t shift = 126u - (magnitude >> 23);
+        uint32_t half = mantissa >> shift;
+        const uint32_t rest = mantissa & ((1u << shift) - 1u);
+        const uint32_t tie = 1u << (shift - 1u);
+        half += rest > tie || (rest == tie && (half & 1u));
+        return (uint16_t)(sign | half);
+    }
+
+    // Rebias exponent from 127 to 15 and drop 13 mantissa bits, a carry into the exponent is still correct
+    uint32_t half = (magnitude - 0x38000000u) >> 13;
+    const uint32_t rest = magnitude & 0x1fffu;
+    half += rest > 0x1000u || (rest == 0x1000u && (half & 1u));
+    return (uint16_t)(sign | half);
+}
+
+void EncodeOctahedral(const float* i_Normal, float* o_Encoded) {
+    const float length = fabsf(i_Normal[0]) + fabsf(i_Normal[1]) + fabsf(i_Normal[2]);
+    if (length <= 0.0f) {
+        o_Encoded[0] = o_Encoded[1] = 0.0f;
+        return;
+    }
+    const float x = i_Normal[0] / length;
+    const float y = i_Normal[1] / length;
+    // Lower hemisphere is folded over the diagonals of the square
+    if (i_Normal[2] < 0.0f) {
+        o_Encoded[0] = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        o_Encoded[1] = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+    }
+    else {
+        o_Encoded[0] = x;
+        o_Encoded[1] = y;
+    }
+}
+
+uint16_t FloatToUnorm16(const float i_Value) {
+    const float value = i_Value < 0.0f ? 0.0f : (i_Value > 1.0f ? 1.0f : i_Value);
+    return (uint16_t)(value * 65535.0f + 0.5f);
+}
+
+int16_t FloatToSnorm16(const float i_Value) {
+    const float value = i_Value < -1.0f ? -1.0f : (i_Value > 1.0f ? 1.0f : i_Value);
+    return (int16_t)(value * 32767.0f + (value >= 0.0f ? 0.5f : -0.5f));
+}
+
+void QuantizeVertices(unsigned char* o_Vertices, const float* i_Vertices, const size_t i_VertexCount, const bool i_TexCoord, const bool i_Normal,
+    float* o_Scale, float* o_Offset) {
+    const size_t input_stride = 3 + (i_TexCoord ? 2 : 0) + (i_Normal ? 3 : 0);
+    const size_t output_stride = QuantizedPositionBytes + (i_TexCoord ? QuantizedTexCoordBytes : 0) + (i_Normal ? QuantizedNormalBytes : 0);
+
+    float minimum[3] = { 1e30f, 1e30f, 1e30f };
+    float maximum[3] = { -1e30f, -1e30f, -1e30f };
+    for (size_t i = 0; i < i_VertexCount; ++i) {
+        const float* position = i_Vertices + i * input_stride;
+        for (int axis = 0; axis < 3; ++axis) {
+            minimum[axis] = position[axis] < minimum[axis] ? position[axis] : minimum[axis];
+            maximum[axis] = position[axis] > maximum[axis] ? position[axis] : maximum[axis];
+        }
+    }
+    float inverse_scale[3];
+    for (int axis = 0; axis < 3; ++axis) {
+        o_Offset[axis] = i_VertexCount ? minimum[axis] : 0.0f;
+        o_Scale[axis] = i_VertexCount ? maximum[axis] - minimum[axis] : 0.0f;
+        // Flat axes keep every vertex at the offset
+        inverse_scale[axis] = o_Scale[axis] > 0.0f ? 1.0f / o_Scale[axis] : 0.0f;
+    }
+
+    for (size_t i = 0; i < i_VertexCount; ++i) {
+        const float* input = i_Vertices + i * input_stride;
+        unsigned char* output = o_Vertices + i * output_stride;
+
+        const uint16_t position[4] = {
+            FloatToUnorm16((input[0] - o_Offset[0]) * inverse_scale[0]),
+            FloatToUnorm16((input[1] - o_Offset[1]) * inverse_scale[1]),
+            FloatToUnorm16((input[2] - o_Offset[2]) * inverse_scale[2]),
+            0 };
+        memcpy(output, position, sizeof(position));
+        input += 3;
+        output += QuantizedPositionBytes;
+
+        if (i_TexCoord) {
+            const uint16_t texcoord[2] = { FloatToHalf(input[0]), FloatToHalf(input[1]) };
+            memcpy(output, texcoord, sizeof(texcoord));
+            input += 2;
+            output += QuantizedTexCoordBytes;
+        }
+
+        if (i_Normal) {
+            float encoded[2];
+            EncodeOctahedral(input, encoded);
+            const int16_t normal[2] = { FloatToSnorm16(encoded[0]), FloatToSnorm16(encoded[1]) };
+            memcpy(output, normal, sizeof(normal));
+        }
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Vertex quantization predifinitions
+#define QuantizedPositionBytes 8                            // 4 x unorm16 over the mesh bounds, last one is padding
+#define QuantizedTexCoordBytes 4                            // 2 x half float
+#define QuantizedNormalBytes 4                              // 2 x snorm16 octahedral
+
+// IEEE half float of a float, rounded to nearest even, out of range values become infinity
+uint16_t FloatToHalf(const float i_Value);
+
+// Octahedral mapping of a direction to [-1, 1]^2, zero vectors map to +Z
+void EncodeOctahedral(const float* i_Normal, float* o_Encoded);
+
+// Float to normalized integers, rounded to nearest and clamped
+uint16_t FloatToUnorm16(const float i_Value);
+int16_t FloatToSnorm16(const float i_Value);
+
+// Interleaved float vertices (position 3, texcoord 2, normal 3, present ones in this order) to the quantized layout
+// Positions are stored relative to their bounds, position = o_Offset + o_Scale * stored value in [0, 1]
+void QuantizeVertices(unsigned char* o_Vertices, const float* i_Vertices, const size_t i_VertexCount, const bool i_TexCoord, const bool i_Normal,
+	float* o_Scale, float* o_Offset);
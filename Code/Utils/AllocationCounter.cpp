@@ -0,0 +1,66 @@
+#include "AllocationCounter.h"
+
+#if defined(ALLOCATION_COUNTING)
+
+#include <cstdlib>
+#include <new>
+
+// Plain integer so it needs no construction, operator new may run before anything else on a thread
+static thread_local uint64_t ThreadAllocations = 0;
+
+uint64_t AllocationCounter::ThreadCount() {
+    return ThreadAllocations;
+}
+
+// Every other form of new (arrays, nothrow) ends up in these two
+void* operator new(std::size_t i_Size) {
+    ThreadAllocations++;
+    void* memory = malloc(i_Size ? i_Size : 1);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new(std::size_t i_Size, std::align_val_t i_Alignment) {
+    ThreadAllocations++;
+    const std::size_t alignment = (std::size_t)i_Alignment;
+    void* memory = nullptr;
+#ifdef _WIN32
+    memory = _aligned_malloc(i_Size ? i_Size : 1, alignment);
+#else
+    if (posix_memalign(&memory, alignment < sizeof(void*) ? sizeof(void*) : alignment, i_Size ? i_Size : 1) != 0) {
+        memory = nullptr;
+    }
+#endif
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete(void* i_Memory) noexcept {
+    free(i_Memory);
+}
+
+void operator delete(void* i_Memory, std::size_t) noexcept {
+    free(i_Memory);
+}
+
+void operator delete(void* i_Memory, std::align_val_t) noexcept {
+#ifdef _WIN32
+    _aligned_free(i_Memory);
+#else
+    free(i_Memory);
+#endif
+}
+
+void operator delete(void* i_Memory, std::size_t, std::align_val_t) noexcept {
+#ifdef _WIN32
+    _aligned_free(i_Memory);
+#else
+    free(i_Memory);
+#endif
+}
+
+#endif
@@ -0,0 +1,21 @@
+#pragma once
+
+// Heap allocation counter, enabled only by building with COUNT_ALLOCATIONS
+// Global operator new is replaced by a counting one, every thread counts its own allocations
+// ALLOCATION_COUNT() is the number of allocations the calling thread made so far, 0 when counting is disabled
+#if defined(COUNT_ALLOCATIONS)
+
+#include <cstdint>
+
+#define ALLOCATION_COUNTING 1
+#define ALLOCATION_COUNT() AllocationCounter::ThreadCount()
+
+namespace AllocationCounter {
+    uint64_t ThreadCount();
+}
+
+#else
+
+#define ALLOCATION_COUNT() 0ull
+
+#endif
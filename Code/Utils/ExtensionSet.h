@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <unordered_set>
+
+// Extension names hashed once from space separated list, lookups do not scan the list again
+class ExtensionSet {
+
+public:
+    void Parse(const char* i_Extensions) {
+        if (i_Extensions == nullptr) {
+            return;
+        }
+        const char* start = i_Extensions;
+        while (*start != '\0') {
+            const char* end = start;
+            while (*end != ' ' && *end != '\0') {
+                ++end;
+            }
+            if (end != start) {
+                Names.insert(std::string(start, end));
+            }
+            start = (*end == ' ') ? end + 1 : end;
+        }
+    }
+
+    void Add(const char* i_Extension) { Names.insert(i_Extension); }
+    void Clear() { Names.clear(); }
+
+    bool Has(const char* i_Extension) const { return Names.count(i_Extension) != 0; }
+    size_t Size() const { return Names.size(); }
+
+private:
+    std::unordered_set<std::string> Names;
+};
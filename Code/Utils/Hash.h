@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Hashing predifinitions
+#define FNVOffsetBasis 14695981039346656037ull
+#define FNVPrime 1099511628211ull
+
+// 64 bit FNV-1a, pass previous result as i_Hash to hash several blocks as one stream
+inline uint64_t HashBytes(const unsigned char* i_Data, const size_t i_Size, uint64_t i_Hash = FNVOffsetBasis) {
+    for (size_t i = 0; i < i_Size; ++i) {
+        i_Hash = (i_Hash ^ i_Data[i]) * FNVPrime;
+    }
+    return i_Hash;
+}
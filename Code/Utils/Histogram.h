@@ -0,0 +1,65 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Histogram predifinitions
+#define HistogramMinValue 1e-4                      // Smallest value with its own bucket, smaller ones share bucket 0
+#define HistogramBucketsPerOctave 32                // Bucket width grows by 2^(1/32), about 2.2%
+#define HistogramOctaves 48                         // Values up to HistogramMinValue * 2^48
+
+// Log-bucketed histogram, memory does not grow with number of samples
+// Percentiles are accurate to half of a bucket width, mean and max are exact
+class LogHistogram {
+
+public:
+    LogHistogram() : Buckets(HistogramBucketsPerOctave * HistogramOctaves + 1, 0) {}
+
+    void Add(const double i_Value) {
+        int bucket = 0;
+        if (i_Value >= HistogramMinValue) {
+            bucket = 1 + (int)(log2(i_Value / HistogramMinValue) * HistogramBucketsPerOctave);
+            bucket = bucket < (int)Buckets.size() ? bucket : (int)Buckets.size() - 1;
+        }
+        Buckets[bucket]++;
+
+        SampleCount++;
+        Sum += i_Value;
+        MaxValue = (SampleCount == 1 || i_Value > MaxValue) ? i_Value : MaxValue;
+        MinValue = (SampleCount == 1 || i_Value < MinValue) ? i_Value : MinValue;
+    }
+
+    uint64_t Count() const { return SampleCount; }
+    double Mean() const { return SampleCount ? Sum / SampleCount : 0.0; }
+    double Max() const { return MaxValue; }
+    double Min() const { return MinValue; }
+
+    // Value below which given percent of samples fall, geometric center of the bucket
+    double Percentile(const double i_Percent) const {
+        if (SampleCount == 0) {
+            return 0.0;
+        }
+
+        uint64_t rank = (uint64_t)ceil(i_Percent / 100.0 * SampleCount);
+        rank = rank < 1 ? 1 : rank;
+
+        uint64_t seen = 0;
+        for (size_t bucket = 0; bucket < Buckets.size(); ++bucket) {
+            seen += Buckets[bucket];
+            if (seen >= rank) {
+                double value = bucket == 0 ? MinValue : HistogramMinValue * exp2((bucket - 0.5) / HistogramBucketsPerOctave);
+                // Exact extremes are known, keep estimate inside them
+                value = value < MinValue ? MinValue : value;
+                return value > MaxValue ? MaxValue : value;
+            }
+        }
+        return MaxValue;
+    }
+
+private:
+    std::vector<uint64_t> Buckets;
+    uint64_t        SampleCount = 0;
+    double          Sum = 0.0;
+    double          MaxValue = 0.0;
+    double          MinValue = 0.0;
+};
@@ -0,0 +1,112 @@
+#pragma once
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <cstddef>
+
+// Read-only memory mapping of a whole file
+// Pages are loaded by the operating system on first access and shared with the file cache
+class MappedFile {
+
+public:
+    MappedFile() {}
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const char* i_Filename) {
+        Close();
+#ifdef _WIN32
+        FileHandle = CreateFileA(i_Filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (FileHandle == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(FileHandle, &size) || size.QuadPart == 0) {
+            Close();
+            return false;
+        }
+        MappingHandle = CreateFileMappingA(FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!MappingHandle) {
+            Close();
+            return false;
+        }
+        Data = (const unsigned char*)MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0);
+        Size = (size_t)size.QuadPart;
+#else
+        const int file = open(i_Filename, O_RDONLY);
+        if (file < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(file, &info) != 0 || info.st_size == 0) {
+            close(file);
+            return false;
+        }
+        void* address = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        // Mapping stays valid after the descriptor is closed
+        close(file);
+        if (address == MAP_FAILED) {
+            return false;
+        }
+        // Buffers are read front to back once
+        madvise(address, (size_t)info.st_size, MADV_SEQUENTIAL);
+        Data = (const unsigned char*)address;
+        Size = (size_t)info.st_size;
+#endif
+        if (!Data) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close() {
+#ifdef _WIN32
+        if (Data) {
+            UnmapViewOfFile(Data);
+        }
+        if (MappingHandle) {
+            CloseHandle(MappingHandle);
+            MappingHandle = nullptr;
+        }
+        if (FileHandle != INVALID_HANDLE_VALUE) {
+            CloseHandle(FileHandle);
+            FileHandle = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (Data) {
+            munmap((void*)Data, Size);
+        }
+#endif
+        Data = nullptr;
+        Size = 0;
+    }
+
+    const unsigned char* GetData() const { return Data; }
+    size_t GetSize() const { return Size; }
+
+    // Something of given name is there, readable or not
+    static bool Exists(const char* i_Filename) {
+#ifdef _WIN32
+        return GetFileAttributesA(i_Filename) != INVALID_FILE_ATTRIBUTES;
+#else
+        struct stat info;
+        return stat(i_Filename, &info) == 0;
+#endif
+    }
+
+private:
+    const unsigned char* Data = nullptr;
+    size_t          Size = 0;
+#ifdef _WIN32
+    HANDLE          FileHandle = INVALID_HANDLE_VALUE;
+    HANDLE          MappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include <chrono>
+#include <vector>
+#include <utility>
+#include <iostream>
+
+// Measures consecutive phases (e.g. application startup) and reports their durations
+class PhaseTimer {
+
+public:
+    PhaseTimer() : Start(Clock::now()), Last(Start) {}
+
+    // Close current phase under given name, next phase starts now
+    void Mark(const char* i_Phase) {
+        const Clock::time_point now = Clock::now();
+        Phases.push_back(std::make_pair(i_Phase, std::chrono::duration<double, std::milli>(now - Last).count()));
+        Last = now;
+    }
+
+    double TotalMilliseconds() const { return std::chrono::duration<double, std::milli>(Last - Start).count(); }
+
+    void Report(const char* i_Title) const {
+        std::cout << i_Title << ":" << std::endl;
+        for (size_t i = 0; i < Phases.size(); ++i) {
+            std::cout << "  " << Phases[i].first << ": " << Phases[i].second << " ms" << std::endl;
+        }
+        std::cout << "  Total: " << TotalMilliseconds() << " ms" << std::endl;
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point Start;
+    Clock::time_point Last;
+    std::vector<std::pair<const char*, double>> Phases;
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+// Scoped CPU profiler, enabled by building with ENABLE_PROFILER
+// PROFILE_SCOPE("name") records time spent until the end of enclosing scope,
+// PROFILE_WRITE_TRACE("file.json") stores all events in Chrome trace event format (chrome://tracing, Perfetto), false on failure
+// Without ENABLE_PROFILER the macros compile to nothing and no trace is written, instrumentation can stay in release builds
+#if defined(ENABLE_PROFILER)
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+
+// Profiler predifinitions
+#define ProfilerEventsPerThread 65536                       // Events stored per thread, later ones are dropped
+
+#define PROFILE_CONCAT_INNER(x, y) x##y
+#define PROFILE_CONCAT(x, y) PROFILE_CONCAT_INNER(x, y)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#define PROFILE_WRITE_TRACE(filename) Profiler::WriteChromeTrace(filename)
+
+namespace Profiler {
+
+    typedef std::chrono::steady_clock Clock;
+
+    struct Event {
+        const char*     Name;                               // Must outlive the profiler, string literals only
+        int64_t         Begin;                              // Microseconds since profiler start
+        int64_t         Duration;
+    };
+
+    // Written only by its own thread, published count lets other threads read events without locks
+    struct ThreadBuffer {
+        Event           Events[ProfilerEventsPerThread];
+        std::atomic<uint32_t> Count{ 0 };
+        std::atomic<uint32_t> Dropped{ 0 };                 // Events that did not fit, reported in trace metadata
+        uint32_t        ThreadId = 0;                       // Sequential in order of first event, unique for the whole run
+        ThreadBuffer*   Next = nullptr;                     // Intrusive list of all buffers
+    };
+
+    inline const Clock::time_point StartTime = Clock::now();
+    inline std::atomic<ThreadBuffer*> Buffers{ nullptr };
+    inline std::atomic<uint32_t> NextThreadId{ 1 };
+
+    inline int64_t Now() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - StartTime).count();
+    }
+
+    // Buffer of calling thread, created and pushed to the list on first use
+    // Buffers are never freed so a trace can still be written after their threads exit
+    inline ThreadBuffer* GetThreadBuffer() {
+        thread_local ThreadBuffer* buffer = nullptr;
+        if (!buffer) {
+            buffer = new ThreadBuffer();
+            buffer->ThreadId = NextThreadId.fetch_add(1, std::memory_order_relaxed);
+            buffer->Next = Buffers.load(std::memory_order_relaxed);
+            while (!Buffers.compare_exchange_weak(buffer->Next, buffer, std::memory_order_release, std::memory_order_relaxed)) {}
+        }
+        return buffer;
+    }
+
+    inline void Record(const char* i_Name, const int64_t i_Begin, const int64_t i_End) {
+        ThreadBuffer* buffer = GetThreadBuffer();
+        const uint32_t count = buffer->Count.load(std::memory_order_relaxed);
+        if (count >= ProfilerEventsPerThread) {
+            buffer->Dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        buffer->Events[count] = Event{ i_Name, i_Begin, i_End - i_Begin };
+        buffer->Count.store(count + 1, std::memory_order_release);
+    }
+
+    // Complete ("X") events of all threads, timestamps in microseconds
+    inline bool WriteChromeTrace(const char* i_Filename) {
+        std::ofstream trace(i_Filename);
+        if (!trace) {
+            return false;
+        }
+
+        trace << "{\"traceEvents\":[" << std::endl;
+        bool first = true;
+        uint64_t dropped = 0;
+        for (ThreadBuffer* buffer = Buffers.load(std::memory_order_acquire); buffer; buffer = buffer->Next) {
+            const uint32_t count = buffer->Count.load(std::memory_order_acquire);
+            dropped += buffer->Dropped.load(std::memory_order_relaxed);
+            for (uint32_t i = 0; i < count; ++i) {
+                const Event& event = buffer->Events[i];
+                trace << (first ? "" : ",\n") << "{\"name\":\"" << event.Name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->ThreadId
+                    << ",\"ts\":" << event.Begin << ",\"dur\":" << event.Duration << "}";
+                first = false;
+            }
+        }
+        trace << std::endl << "],\"displayTimeUnit\":\"ms\"," << std::endl;
+
+        // Shown as trace metadata, a non-zero count means threads ran out of room and their timelines end early
+        trace << "\"otherData\":{\"events_per_thread\":\"" << ProfilerEventsPerThread << "\",\"dropped_events\":\"" << dropped << "\"";
+        for (ThreadBuffer* buffer = Buffers.load(std::memory_order_acquire); buffer; buffer = buffer->Next) {
+            const uint32_t thread_dropped = buffer->Dropped.load(std::memory_order_relaxed);
+            if (thread_dropped > 0) {
+                trace << ",\"dropped_events_tid_" << buffer->ThreadId << "\":\"" << thread_dropped << "\"";
+            }
+        }
+        trace << "}}" << std::endl;
+        return trace.good();
+    }
+}
+
+// Records one event covering its lifetime
+class ProfileScope {
+
+public:
+    explicit ProfileScope(const char* i_Name) : Name(i_Name), Begin(Profiler::Now()) {}
+    ~ProfileScope() { Profiler::Record(Name, Begin, Profiler::Now()); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char*     Name;
+    int64_t         Begin;
+};
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_WRITE_TRACE(filename) ((void)(filename), false)
+
+#endif
@@ -0,0 +1,84 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads executing submitted jobs in submission order
+class ThreadPool {
+
+public:
+    // Zero threads means one per hardware thread
+    explicit ThreadPool(unsigned int i_Threads = 0) {
+        unsigned int count = i_Threads ? i_Threads : std::thread::hardware_concurrency();
+        count = count ? count : 1;
+        for (unsigned int i = 0; i < count; ++i) {
+            Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            Stopping = true;
+        }
+        JobAvailable.notify_all();
+        for (size_t i = 0; i < Workers.size(); ++i) {
+            Workers[i].join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void Submit(std::function<void()> i_Job) {
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            Jobs.push_back(std::move(i_Job));
+        }
+        JobAvailable.notify_one();
+    }
+
+    // Block until every submitted job has finished
+    void Wait() {
+        std::unique_lock<std::mutex> lock(Mutex);
+        JobsDone.wait(lock, [this] { return Jobs.empty() && Active == 0; });
+    }
+
+    size_t Size() const { return Workers.size(); }
+
+private:
+    void WorkerLoop() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(Mutex);
+                JobAvailable.wait(lock, [this] { return Stopping || !Jobs.empty(); });
+                if (Jobs.empty()) {
+                    return;
+                }
+                job = std::move(Jobs.front());
+                Jobs.pop_front();
+                Active++;
+            }
+
+            job();
+
+            {
+                std::lock_guard<std::mutex> lock(Mutex);
+                Active--;
+            }
+            JobsDone.notify_all();
+        }
+    }
+
+    std::vector<std::thread> Workers;
+    std::deque<std::function<void()>> Jobs;
+    std::mutex      Mutex;
+    std::condition_variable JobAvailable;
+    std::condition_variable JobsDone;
+    size_t          Active = 0;
+    bool            Stopping = false;
+};
@@ -1,5 +1,8 @@
 #pragma once
+#ifdef _WIN32
 #include <Windows.h>
+#endif
+#include <cstring>
 #include <string>
 #include <sstream>
 #include <fstream>
@@ -19,8 +22,13 @@ public:
     }
 
     void ErrorMessage(const char* i_Title, const char* i_Message, bool critical = false) {
+#ifdef _WIN32
         // Display message box
         MessageBox(nullptr, i_Message, i_Title, MB_OK | MB_ICONINFORMATION);
+#else
+        // No windows without WinApi - report to error stream
+        std::cerr << i_Title << ": " << i_Message << std::endl;
+#endif
 		if (critical) {
 			exit(1);
 		}
@@ -53,30 +61,7 @@ public:
         }
     }
 
-	// Check if given extension is present in the list of all extensions
-    bool CheckExtension(const char* i_Extension, const char* i_AllExtensions) {
-        // Check if given extension string is present
-        const char* start = strstr(i_AllExtensions, i_Extension);
-        if (start == nullptr) {
-            return false;
-        }
-
-        size_t i = 0;
-        size_t length = strlen(i_Extension);
-
-        // Make sure that string matches exactly the one provided
-        for (; i < length; ++i) {
-            if (i_Extension[i] != start[i]) {
-                return false;
-            }
-        }
-        // And check if it is not another extension which name contains the one we are searching for
-        if ((start[i] != ' ') && (start[i] != '\0')) {
-            return false;
-        }
-        return true;
-    }
-
+#ifdef _WIN32
     void* GetFunctionAddress(const HMODULE i_Handle, const char* i_ProcedureName) {
         // Get the address of a given function (for OpenGL versions 1.2+)
         PROC address = wglGetProcAddress(i_ProcedureName);
@@ -89,6 +74,7 @@ public:
         }
         return address;
     }
+#endif
 
 	void CheckLinkingStatus(GLuint i_Program) {
 		GLint status;
@@ -4,6 +4,20 @@ precision highp float; // high precision float operations for PC
 
 #define PI 3.14159265359
 
+// Feature switches, the render injects them per permutation, defaults are the full quality variant
+#ifndef AO
+#define AO 1                // SSDO with colored AO
+#endif
+#ifndef SSDO_SAMPLES
+#define SSDO_SAMPLES 8      // Occlusion samples, up to 10
+#endif
+#ifndef BRDF_MODEL
+#define BRDF_MODEL 1        // 0 normalized Phong, 1 Phong with metalness and roughness driven exponent
+#endif
+#ifndef FOG
+#define FOG 1               // Exponential depth fog
+#endif
+
 in vec2 Texcoord2;
 
 out vec4 oColor;
@@ -45,6 +59,7 @@ float noise( vec2 U ) {
     return mix( C.x, C.y, U.y );
 }
 
+#if AO
 // Activision colored AO
 vec3 ComputeColoredAO(float ao, vec3 albedo) {
     vec3 a = 2.0404 * albedo - 0.3324;
@@ -59,7 +74,6 @@ float CalcSSDO(vec3 P, vec3 N) {
 	const float SSAO_DEPTH_THRESHOLD = 2.5;
 	const float SSDO_RADIUS = 2.01 ;
 	const float SSDO_BLEND_FACTOR = 1;
-	const float SSDO_SAMPLE = 8;
 	
 	vec3 hemisphere[10];
 	hemisphere[0] = vec3(-0.134, 0.044, -0.825);
@@ -76,7 +90,7 @@ float CalcSSDO(vec3 P, vec3 N) {
 	float noise = noise(Texcoord2 + vec2(0.5,0.5));
 	float occ = 0.0;	
 
-	for (int i = 0; i < SSDO_SAMPLE; i++) {
+	for (int i = 0; i < SSDO_SAMPLES; i++) {
 		vec3 reflection_sample = reflect(hemisphere[i], hemisphere[i]) + N.xyz;
 		
 		vec3 occ_pos_view = P.xyz + reflection_sample * SSDO_RADIUS;
@@ -90,14 +104,15 @@ float CalcSSDO(vec3 P, vec3 N) {
 		float occ_coeff = clamp(is_occluder + step(SSAO_DEPTH_THRESHOLD, abs(P.z-screen_occ)), 0.0f, 1.0f);
 		occ += occ_coeff;
 	}
-	occ /= SSDO_SAMPLE;
+	occ /= float(SSDO_SAMPLES);
 	occ = clamp(occ, 0.0f, 1.0f);
 	return pow(occ, SSDO_BLEND_FACTOR);
 }
+#endif
 
 void main()
 {
-	oColor = vec4(0f, 0f, 0f, 0f);
+	oColor = vec4(0.0f, 0.0f, 0.0f, 0.0f);
 
 	// Read gbuffer
 	vec4 color = texture(uColor, Texcoord2);
@@ -129,19 +144,26 @@ void main()
 
 	// BRDF specular
 	float specExp = 8.0f;
+#if BRDF_MODEL == 1
 	float F0 = pow((1 - metalness)/sqrt(roughness), specExp);
 	float specularTerm = 
 		pow(
 			max( dot( reflection, V ), 0.f ),
 			clamp( F0 * (1.f - nDotL) / 2.f, 0.001f, 255.0f) + specExp + specExp*metalness 
 		) * (F0 + 2.f) * 1.f/(2.f*PI);
+#else
+	float specularTerm = pow(max(dot(reflection, V), 0.f), specExp) * (specExp + 2.f)/(2.f*PI);
+#endif
 
 	// Final light combine
 	oColor.rgb = diffuseTerm*color.rgb*occlusion + specularTerm*specularColor + inAmbient.a;
 
+#if AO
 	// Compute SS colored AO
 	oColor.rgb *= ComputeColoredAO(1 - CalcSSDO(position.rgb, normal.rgb), color.rgb);
+#endif
 
+#if FOG
 	// Fog - simple depth based exponential fog
 	const vec4 fogColor = vec4(0.345098f,0.545098f,0.6627450f,1);
 	const float fogPowBase = 2.71828;
@@ -150,5 +172,6 @@ void main()
 	float fogFactor = clamp(pow(fogPowBase,-fogExp*fogExp), 0, 1);
 
 	oColor.rgb = mix(fogColor.rgb, oColor.rgb, fogFactor);
+#endif
 
 }